@@ -0,0 +1,98 @@
+#==================================================================================================#
+#                                                                                                  #
+#  Copyright 2013 MaidSafe.net limited                                                             #
+#                                                                                                  #
+#  This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,        #
+#  version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which    #
+#  licence you accepted on initial access to the Software (the "Licences").                        #
+#                                                                                                  #
+#  By contributing code to the MaidSafe Software, or to this project generally, you agree to be    #
+#  bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root        #
+#  directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also             #
+#  available at: http://www.maidsafe.net/licenses                                                  #
+#                                                                                                  #
+#  Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed    #
+#  under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS      #
+#  OF ANY KIND, either express or implied.                                                         #
+#                                                                                                  #
+#  See the Licences for the specific language governing permissions and limitations relating to    #
+#  use of the MaidSafe Software.                                                                   #
+#                                                                                                  #
+#==================================================================================================#
+#                                                                                                  #
+#  Generates message_dispatch.h from the *.message_types.meta files.  Run in script mode:          #
+#                                                                                                  #
+#    cmake -DInputFile=<message_dispatch.h.in> -DOutputFile=<message_dispatch.h>                   #
+#          -DMetaDir=<dir containing meta files> -P generate_message_dispatch.cmake                #
+#                                                                                                  #
+#  For each destination persona, a DispatchTable specialisation is written listing the message     #
+#  types in the order they appear in the meta files, and mapping each (action, source persona)     #
+#  pair to that type's position.                                                                   #
+#                                                                                                  #
+#==================================================================================================#
+
+
+foreach(Var InputFile OutputFile MetaDir)
+  if(NOT ${Var})
+    message(FATAL_ERROR "${Var} must be defined when running generate_message_dispatch.cmake")
+  endif()
+endforeach()
+
+file(GLOB_RECURSE MetaFiles "${MetaDir}/*.message_types.meta")
+list(SORT MetaFiles)
+
+set(LineRegex "^Action:([A-Za-z]+)[ \t]+Source:([A-Za-z]+):[A-Za-z]+[ \t]+")
+set(LineRegex "${LineRegex}Destination:([A-Za-z]+):[A-Za-z]+")
+set(Destinations)
+foreach(MetaFile ${MetaFiles})
+  file(STRINGS "${MetaFile}" Lines REGEX "^Action:")
+  foreach(Line ${Lines})
+    if(NOT Line MATCHES "${LineRegex}")
+      message(FATAL_ERROR "Failed to parse \"${Line}\" in ${MetaFile}")
+    endif()
+    set(Action ${CMAKE_MATCH_1})
+    set(Source ${CMAKE_MATCH_2})
+    set(Destination ${CMAKE_MATCH_3})
+    list(FIND Destinations ${Destination} Found)
+    if(Found EQUAL -1)
+      list(APPEND Destinations ${Destination})
+      set(${Destination}Count 0)
+      set(${Destination}Types)
+      set(${Destination}Cases)
+    endif()
+    set(Key "${Action}:${Source}")
+    list(FIND ${Destination}Keys ${Key} Found)
+    if(NOT Found EQUAL -1)
+      message(FATAL_ERROR
+              "Duplicate message ${Action} from ${Source} to ${Destination} in ${MetaFile}")
+    endif()
+    list(APPEND ${Destination}Keys ${Key})
+    if(${Destination}Count GREATER 0)
+      set(${Destination}Types "${${Destination}Types},\n                     ")
+    endif()
+    set(${Destination}Types "${${Destination}Types}${Action}From${Source}To${Destination}")
+    set(Case "      case detail::DispatchKey(MessageAction::k${Action}, Persona::k${Source}):\n")
+    set(${Destination}Cases "${${Destination}Cases}${Case}")
+    set(${Destination}Cases "${${Destination}Cases}        return ${${Destination}Count};\n")
+    math(EXPR ${Destination}Count "${${Destination}Count} + 1")
+  endforeach()
+endforeach()
+
+set(DispatchTables)
+foreach(Destination ${Destinations})
+  set(DispatchTables "${DispatchTables}
+template<>
+struct DispatchTable<${Destination}ServiceMessages> {
+  static const Persona kDestinationPersona = Persona::k${Destination};
+  typedef std::tuple<${${Destination}Types}> Messages;
+  static int Index(MessageAction action, Persona source_persona) {
+    switch (detail::DispatchKey(action, source_persona)) {
+${${Destination}Cases}      default:
+        return -1;
+    }
+  }
+};
+")
+endforeach()
+
+configure_file("${InputFile}" "${OutputFile}" @ONLY)
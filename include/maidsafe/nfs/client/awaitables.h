@@ -0,0 +1,199 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_AWAITABLES_H_
+#define MAIDSAFE_NFS_CLIENT_AWAITABLES_H_
+
+// Awaitable versions of the client ops, for use with C++20 coroutines.  Everything below is
+// compiled out unless the compiler supports coroutines, so this header can be included
+// unconditionally.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && defined(__has_include)
+#if __has_include(<coroutine>)
+#define MAIDSAFE_NFS_HAS_COROUTINES
+#endif
+#endif
+
+#ifdef MAIDSAFE_NFS_HAS_COROUTINES
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/data_types/structured_data_versions.h"
+
+#include "maidsafe/nfs/expected.h"
+#include "maidsafe/nfs/latency_estimator.h"
+#include "maidsafe/nfs/client/client_utils.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// Runs posted functors immediately, so that a completion handler resumes its coroutine directly
+// from the thread which handled the response.
+struct InlineExecutor {
+  template<typename Functor>
+  void post(Functor&& functor) const { functor(); }
+};
+
+// Starts an op via the completion-handler overload of a client function when awaited, and resumes
+// the awaiting coroutine once the op resolves.  No future or promise is involved, and no thread is
+// blocked while the op is in flight.  'co_await' yields the result, or throws the op's error.
+// 'Start' is called with an executor and a completion handler.
+template<typename Result, typename Start>
+class OpAwaitable {
+ public:
+  explicit OpAwaitable(Start start)
+      : start_(std::move(start)), shared_state_(std::make_shared<SharedState>()) {}
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> coroutine);
+  Result await_resume();
+
+ private:
+  OpAwaitable(const OpAwaitable&);
+  OpAwaitable(OpAwaitable&&);
+  OpAwaitable& operator=(OpAwaitable);
+
+  // The handler can run on another thread before 'await_suspend' returns, or even before 'start_'
+  // returns, so whichever of the two finishes second is responsible for resuming.  The state is
+  // shared with the handler, since if 'start_' throws, the exception unwinds the awaitable while
+  // the op may still be registered and so complete later.
+  enum State : int { kPending, kSuspended, kCompleted };
+
+  struct SharedState {
+    SharedState() : state(kPending), coroutine(), outcome() {}
+    void Complete(nfs::Expected<Result>&& outcome_in);
+    std::atomic<int> state;
+    std::coroutine_handle<> coroutine;
+    boost::optional<nfs::Expected<Result>> outcome;
+  };
+
+  struct Handler {
+    void operator()(nfs::Expected<Result> outcome) const {
+      shared_state->Complete(std::move(outcome));
+    }
+    std::shared_ptr<SharedState> shared_state;
+  };
+
+  static InlineExecutor executor_;
+  Start start_;
+  std::shared_ptr<SharedState> shared_state_;
+};
+
+template<typename Result, typename Start>
+OpAwaitable<Result, Start> MakeOpAwaitable(Start start) {
+  return OpAwaitable<Result, Start>(std::move(start));
+}
+
+// The following can be used with MaidNodeNfs or DataGetter, except for AwaitPut which is
+// MaidNodeNfs only.
+template<typename Data, typename Client>
+auto AwaitGet(Client& client, const typename Data::Name& data_name,
+              const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout) {
+  return MakeOpAwaitable<Data>(
+      [&client, data_name, timeout](InlineExecutor& executor, auto handler) {
+        client.template Get<Data>(data_name, executor, std::move(handler), timeout);
+      });
+}
+
+// Awaiting coroutines are resumed on the thread which handled the response to their previous op.
+// MaidNodeNfs queues rather than blocks a Put when 'max_puts_in_flight' are already in flight, so
+// awaiting a Put from there can't deadlock.
+template<typename Data, typename Client>
+auto AwaitPut(Client& client, const Data& data,
+              const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout) {
+  return MakeOpAwaitable<void>(
+      [&client, data, timeout](InlineExecutor& executor, auto handler) {
+        client.Put(data, executor, std::move(handler), timeout);
+      });
+}
+
+template<typename Data, typename Client>
+auto AwaitGetVersions(
+    Client& client, const typename Data::Name& data_name,
+    const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout) {
+  return MakeOpAwaitable<VersionNames>(
+      [&client, data_name, timeout](InlineExecutor& executor, auto handler) {
+        client.template GetVersions<Data>(data_name, executor, std::move(handler), timeout);
+      });
+}
+
+template<typename Data, typename Client>
+auto AwaitGetBranch(
+    Client& client, const typename Data::Name& data_name,
+    const StructuredDataVersions::VersionName& branch_tip,
+    const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout) {
+  return MakeOpAwaitable<VersionNames>(
+      [&client, data_name, branch_tip, timeout](InlineExecutor& executor, auto handler) {
+        client.template GetBranch<Data>(data_name, branch_tip, executor, std::move(handler),
+                                        timeout);
+      });
+}
+
+
+
+// ==================== Implementation =============================================================
+template<typename Result, typename Start>
+InlineExecutor OpAwaitable<Result, Start>::executor_;
+
+template<typename Result, typename Start>
+bool OpAwaitable<Result, Start>::await_suspend(std::coroutine_handle<> coroutine) {
+  shared_state_->coroutine = coroutine;
+  try {
+    start_(executor_, Handler{shared_state_});
+  }
+  catch(...) {
+    // The exception resumes the coroutine, so the handler mustn't if it's invoked later.
+    shared_state_->state.store(kCompleted);
+    throw;
+  }
+  int state(kPending);
+  // If the op has already completed, don't suspend.
+  return shared_state_->state.compare_exchange_strong(state, kSuspended);
+}
+
+template<typename Result, typename Start>
+Result OpAwaitable<Result, Start>::await_resume() {
+  if constexpr (std::is_void<Result>::value)
+    shared_state_->outcome->value();
+  else
+    return std::move(shared_state_->outcome->value());
+}
+
+template<typename Result, typename Start>
+void OpAwaitable<Result, Start>::SharedState::Complete(nfs::Expected<Result>&& outcome_in) {
+  outcome = std::move(outcome_in);
+  int current_state(kPending);
+  if (!state.compare_exchange_strong(current_state, kCompleted) && current_state == kSuspended)
+    coroutine.resume();
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_HAS_COROUTINES
+
+#endif  // MAIDSAFE_NFS_CLIENT_AWAITABLES_H_
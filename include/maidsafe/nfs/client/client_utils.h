@@ -19,14 +19,23 @@
 #ifndef MAIDSAFE_NFS_CLIENT_CLIENT_UTILS_H_
 #define MAIDSAFE_NFS_CLIENT_CLIENT_UTILS_H_
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "boost/exception/all.hpp"
+#include "boost/optional/optional.hpp"
 #include "boost/thread/future.hpp"
 
 #include "maidsafe/data_types/structured_data_versions.h"
 
+#include "maidsafe/nfs/expected.h"
+#include "maidsafe/nfs/op_pool.h"
+#include "maidsafe/nfs/pending_ops.h"
+#include "maidsafe/nfs/utils.h"
+#include "maidsafe/nfs/client/data_cache.h"
 #include "maidsafe/nfs/client/messages.h"
 
 
@@ -34,41 +43,189 @@ namespace maidsafe {
 
 namespace nfs_client {
 
+typedef std::vector<StructuredDataVersions::VersionName> VersionNames;
+
+// Convert a response into the outcome of the op.  If 'data_cache' is non-null, successfully
+// retrieved data is added to it.
+template<typename Data>
+nfs::Expected<Data> GetResult(const DataNameAndContentOrReturnCode& result,
+                              DataCache* data_cache = nullptr);
+nfs::Expected<void> PutResult(const DataPmidHintAndReturnCode& result);
+nfs::Expected<VersionNames> GetVersionsOrBranchResult(
+    const StructuredDataNameAndContentOrReturnCode& result);
+
+// If 'data_cache_in' is non-null, successfully retrieved data is added to it.
 template<typename Data>
 struct HandleGetResult {
-  explicit HandleGetResult(std::shared_ptr<boost::promise<Data>> promise_in)
-      : promise(std::move(promise_in)) {}
+  explicit HandleGetResult(std::shared_ptr<boost::promise<Data>> promise_in,
+                           DataCache* data_cache_in = nullptr)
+      : promise(std::move(promise_in)), data_cache(data_cache_in) {}
   void operator()(const DataNameAndContentOrReturnCode& result) const;
   std::shared_ptr<boost::promise<Data>> promise;
+  DataCache* data_cache;
 };
 
+// Returns the error of the exception currently being handled, or CommonErrors::unknown if it isn't
+// a maidsafe_error.  Must only be called from within a catch block.
+maidsafe_error CurrentError();
+
+// A failed response for 'data_name' carrying CurrentError(), for resolving a Get whose request
+// couldn't be sent.
+template<typename DataName>
+DataNameAndContentOrReturnCode GetFailureResponse(const DataName& data_name) {
+  return DataNameAndContentOrReturnCode(DataNameAndReturnCode(nfs_vault::DataName(data_name),
+                                                              ReturnCode(CurrentError())));
+}
+
+// As above, for resolving a GetVersions or GetBranch whose request couldn't be sent.
+template<typename DataName>
+StructuredDataNameAndContentOrReturnCode VersionsFailureResponse(const DataName& data_name) {
+  StructuredDataNameAndContentOrReturnCode response;
+  response.data_name_and_return_code =
+      DataNameAndReturnCode(nfs_vault::DataName(data_name), ReturnCode(CurrentError()));
+  return response;
+}
+
+// A failed response carrying CurrentError(), for resolving a Put whose request couldn't be sent.
+DataPmidHintAndReturnCode PutFailureResponse();
+
+// Registers 'op_data' with 'pending_ops' and passes its message ID to 'send'.  If either throws,
+// the op is resolved with 'failure_response()', which is called from within the catch block and so
+// can use CurrentError(), and the exception isn't propagated: the completion-handler overloads
+// report every outcome via their handler alone.
+template<typename ResponseContents, typename Send, typename FailureResponse>
+void StartCompletionOp(nfs::PendingOps<ResponseContents>& pending_ops,
+                       const std::shared_ptr<nfs::OpData<ResponseContents>>& op_data,
+                       const std::chrono::steady_clock::duration& timeout, Send send,
+                       FailureResponse failure_response) {
+  boost::optional<nfs::MessageId> message_id;
+  try {
+    message_id = pending_ops.Add(op_data, timeout);
+    send(*message_id);
+  }
+  catch(...) {
+    if (message_id)
+      pending_ops.Cancel(*message_id, failure_response());
+    else
+      op_data->HandleTimeout(failure_response());
+  }
+}
+
+void HandlePutResult(const DataPmidHintAndReturnCode& result,
+                     std::shared_ptr<boost::promise<void>> promise);
+
 void HandleGetVersionsOrBranchResult(const StructuredDataNameAndContentOrReturnCode& result,
     std::shared_ptr<boost::promise<std::vector<StructuredDataVersions::VersionName>>> promise);
 
+// Posts 'handler' to 'executor' to be invoked with 'result'.
+template<typename Handler, typename Result>
+struct PostedCompletion {
+  PostedCompletion(Handler handler_in, Result result_in)
+      : handler(std::move(handler_in)), result(std::move(result_in)) {}
+  void operator()() { handler(std::move(result)); }
+  Handler handler;
+  Result result;
+};
+
+template<typename Executor, typename Handler, typename Result>
+void PostCompletion(Executor& executor, Handler handler, Result result) {
+  executor.post(PostedCompletion<Handler, Result>(std::move(handler), std::move(result)));
+}
+
+// Posts 'handler' to 'executor' with the outcome of a Get, as a functor attached to an InFlightGets
+// entry.  Those must be copyable, so the handler is held via a shared_ptr.  If 'data_cache_in' is
+// non-null, successfully retrieved data is added to it.
+template<typename Data, typename Executor, typename Handler>
+struct PostGetResult {
+  PostGetResult(Executor& executor_in, Handler handler_in, DataCache* data_cache_in = nullptr)
+      : executor(&executor_in),
+        handler(std::make_shared<Handler>(std::move(handler_in))),
+        data_cache(data_cache_in) {}
+  void operator()(const DataNameAndContentOrReturnCode& result) const {
+    PostCompletion(*executor, std::move(*handler), GetResult<Data>(result, data_cache));
+  }
+  Executor* executor;
+  std::shared_ptr<Handler> handler;
+  DataCache* data_cache;
+};
+
+// The callback of an op whose outcome is passed to a completion handler rather than via a promise.
+// 'complete' converts the resolving response into an nfs::Expected result, and the handler is then
+// posted to 'executor', which must provide 'post' (as boost::asio::io_service does).
+template<typename Executor, typename Handler, typename Complete>
+class Completion {
+ public:
+  Completion(Executor& executor, Handler handler, Complete complete)
+      : executor_(executor), handler_(std::move(handler)), complete_(std::move(complete)) {}
+
+  Completion(Completion&& other)
+      : executor_(other.executor_),
+        handler_(std::move(other.handler_)),
+        complete_(std::move(other.complete_)) {}
+
+  template<typename ResponseContents>
+  void operator()(const ResponseContents& response) {
+    PostCompletion(executor_, std::move(handler_), complete_(response));
+  }
+
+ private:
+  Completion(const Completion&);
+  Completion& operator=(Completion);
+
+  Executor& executor_;
+  Handler handler_;
+  Complete complete_;
+};
+
+// Returns an OpData allocated from 'op_pool' which shares a single block with the handler and the
+// 'complete' functor; see nfs::MakeOpData.
+template<typename ResponseContents, typename Executor, typename Handler, typename Complete>
+std::shared_ptr<nfs::OpData<ResponseContents>> MakeCompletionOp(const nfs::OpPool& op_pool,
+                                                                 int successes_required,
+                                                                 Executor& executor,
+                                                                 Handler handler,
+                                                                 Complete complete) {
+  return nfs::MakeOpData<ResponseContents>(
+      op_pool, successes_required,
+      Completion<Executor, Handler, Complete>(executor, std::move(handler), std::move(complete)));
+}
+
 
 
 // ==================== Implementation =============================================================
 template<typename Data>
-void HandleGetResult<Data>::operator()(const DataNameAndContentOrReturnCode& result) const {
+nfs::Expected<Data> GetResult(const DataNameAndContentOrReturnCode& result,
+                              DataCache* data_cache) {
   try {
     if (result.data) {
       if (result.data->name.type != Data::Tag::kValue)
         ThrowError(CommonErrors::invalid_parameter);
 
       Data data(typename Data::Name(result.data->name.raw_name),
-                typename Data::serialised_type(result.data->content));
-      promise->set_value(data);
+                typename Data::serialised_type(result.data->content.non_empty_string()));
+      if (data_cache)
+        data_cache->PutSerialised<Data>(data.name(), result.data->content);
+      return nfs::Expected<Data>(std::move(data));
     } else if (result.data_name_and_return_code) {
-      boost::throw_exception(result.data_name_and_return_code->return_code.value);
+      return nfs::Expected<Data>(result.data_name_and_return_code->return_code.value);
     } else {
-      ThrowError(CommonErrors::uninitialised);
+      return nfs::Expected<Data>(MakeError(CommonErrors::uninitialised));
     }
   }
-  catch(...) {
-    promise->set_exception(boost::current_exception());
+  catch(const maidsafe_error& error) {
+    return nfs::Expected<Data>(error);
   }
 }
 
+template<typename Data>
+void HandleGetResult<Data>::operator()(const DataNameAndContentOrReturnCode& result) const {
+  auto data(GetResult<Data>(result, data_cache));
+  if (data)
+    promise->set_value(std::move(*data));
+  else
+    promise->set_exception(boost::copy_exception(data.error()));
+}
+
 }  // namespace nfs_client
 
 }  // namespace maidsafe
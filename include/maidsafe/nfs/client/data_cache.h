@@ -0,0 +1,171 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_DATA_CACHE_H_
+#define MAIDSAFE_NFS_CLIENT_DATA_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/data_types/data_type_values.h"
+
+#include "maidsafe/nfs/shared_buffer.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// In-process cache of the serialised content of cacheable data, keyed by type and name.  Only
+// types for which 'is_cacheable<Data>::value' is true are admitted; since these are named by the
+// hash of their content, a cached copy never goes stale and entries are only ever evicted to stay
+// within the configured size.  Entries are spread across independently-locked shards by name, and
+// each shard evicts its least recently used entries once it exceeds its share of 'max_bytes'.
+class DataCache {
+ public:
+  struct Config {
+    Config() : max_bytes(0), shard_count(16) {}
+    Config(uint64_t max_bytes_in, int shard_count_in)
+        : max_bytes(max_bytes_in), shard_count(shard_count_in) {}
+    // A 'max_bytes' of 0 disables the cache.
+    uint64_t max_bytes;
+    int shard_count;
+  };
+
+  struct Stats {
+    Stats() : hits(0), misses(0), insertions(0), evictions(0), entry_count(0), bytes(0) {}
+    uint64_t hits, misses, insertions, evictions, entry_count, bytes;
+  };
+
+  explicit DataCache(const Config& config);
+
+  // Identifies data of any type by its type and name.
+  static std::string Key(DataTagValue tag_value, const Identity& raw_name);
+
+  bool enabled() const { return max_bytes_ != 0; }
+
+  // Returns an empty optional for a miss, or if 'Data' isn't cacheable.  Misses are only counted
+  // for cacheable types.
+  template<typename Data>
+  boost::optional<Data> Get(const typename Data::Name& data_name);
+  // No-op if 'Data' isn't cacheable.
+  template<typename Data>
+  void Put(const Data& data);
+  // As above, but for 'content' already known to be the serialised form of the data named
+  // 'data_name'.  The cache shares 'content' rather than copying it.
+  template<typename Data>
+  void PutSerialised(const typename Data::Name& data_name, const nfs::SharedBuffer& content);
+
+  Stats stats() const;
+
+ private:
+  DataCache(const DataCache&);
+  DataCache(DataCache&&);
+  DataCache& operator=(DataCache);
+
+  struct Entry {
+    Entry(std::string key_in, nfs::SharedBuffer content_in)
+        : key(std::move(key_in)), content(std::move(content_in)) {}
+    std::string key;
+    nfs::SharedBuffer content;
+  };
+
+  struct Shard {
+    Shard() : mutex(), entries(), index(), bytes(0), hits(0), misses(0), insertions(0),
+              evictions(0) {}
+    std::mutex mutex;
+    // Most recently used at the front.
+    std::list<Entry> entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    uint64_t bytes;
+    std::atomic<uint64_t> hits, misses, insertions, evictions;
+  };
+
+  template<typename Data>
+  boost::optional<Data> DoGet(const typename Data::Name& data_name, std::true_type);
+  template<typename Data>
+  boost::optional<Data> DoGet(const typename Data::Name& /*data_name*/, std::false_type) {
+    return boost::optional<Data>();
+  }
+  template<typename Data>
+  void DoPut(const Data& data, std::true_type);
+  template<typename Data>
+  void DoPut(const Data& /*data*/, std::false_type) {}
+
+  static uint64_t Cost(const Entry& entry);
+  Shard& GetShard(const std::string& key);
+  boost::optional<nfs::SharedBuffer> GetContent(const std::string& key);
+  void PutContent(std::string key, nfs::SharedBuffer content);
+
+  const uint64_t max_bytes_, max_bytes_per_shard_;
+  const int shard_count_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+
+
+// ==================== Implementation =============================================================
+template<typename Data>
+boost::optional<Data> DataCache::Get(const typename Data::Name& data_name) {
+  return DoGet<Data>(data_name, is_cacheable<Data>());
+}
+
+template<typename Data>
+void DataCache::Put(const Data& data) {
+  DoPut(data, is_cacheable<Data>());
+}
+
+template<typename Data>
+boost::optional<Data> DataCache::DoGet(const typename Data::Name& data_name, std::true_type) {
+  if (!enabled())
+    return boost::optional<Data>();
+  auto content(GetContent(Key(Data::Tag::kValue, data_name.value)));
+  if (!content)
+    return boost::optional<Data>();
+  return boost::optional<Data>(
+      Data(data_name, typename Data::serialised_type(content->non_empty_string())));
+}
+
+template<typename Data>
+void DataCache::DoPut(const Data& data, std::true_type) {
+  if (enabled())
+    PutContent(Key(Data::Tag::kValue, data.name().value), nfs::SharedBuffer(data.Serialise().data));
+}
+
+template<typename Data>
+void DataCache::PutSerialised(const typename Data::Name& data_name,
+                              const nfs::SharedBuffer& content) {
+  if (is_cacheable<Data>::value && enabled())
+    PutContent(Key(Data::Tag::kValue, data_name.value), content);
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_DATA_CACHE_H_
@@ -19,10 +19,14 @@
 #ifndef MAIDSAFE_NFS_CLIENT_DATA_GETTER_H_
 #define MAIDSAFE_NFS_CLIENT_DATA_GETTER_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "boost/optional/optional.hpp"
 #include "boost/thread/future.hpp"
 
 #include "maidsafe/common/asio_service.h"
@@ -30,12 +34,18 @@
 #include "maidsafe/passport/types.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/routing_api.h"
-#include "maidsafe/routing/timer.h"
 
+#include "maidsafe/nfs/hedge_policy.h"
+#include "maidsafe/nfs/latency_estimator.h"
+#include "maidsafe/nfs/op_pool.h"
 #include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/pending_ops.h"
 #include "maidsafe/nfs/service.h"
 #include "maidsafe/nfs/utils.h"
 #include "maidsafe/nfs/client/client_utils.h"
+#include "maidsafe/nfs/client/data_cache.h"
+#include "maidsafe/nfs/client/get_many.h"
+#include "maidsafe/nfs/client/in_flight_gets.h"
 #include "maidsafe/nfs/client/data_getter_dispatcher.h"
 #include "maidsafe/nfs/client/data_getter_service.h"
 
@@ -48,26 +58,82 @@ class DataGetter {
  public:
   typedef boost::future<std::vector<StructuredDataVersions::VersionName>> VersionNamesFuture;
 
-  // all_pmids_from_file should only be non-empty if TESTING is defined
+  static const int kDefaultMaxGetsInFlight = 32;
+
+  // all_pmids_from_file should only be non-empty if TESTING is defined.  By default, cacheable data
+  // isn't cached locally; see DataCache::Config.  Operations called without an explicit timeout
+  // use one derived from 'latency_estimator_config'.  By default, Gets aren't hedged; see
+  // nfs::HedgePolicy.
   DataGetter(AsioService& asio_service, routing::Routing& routing,
              std::vector<passport::PublicPmid> public_pmids_from_file =
-                 std::vector<passport::PublicPmid>());
+                 std::vector<passport::PublicPmid>(),
+             const DataCache::Config& data_cache_config = DataCache::Config(),
+             const nfs::LatencyEstimator::Config& latency_estimator_config =
+                 nfs::LatencyEstimator::Config(),
+             const nfs::HedgePolicy::Config& get_hedge_config = nfs::HedgePolicy::Config());
+
+  DataCache::Stats data_cache_stats() const { return data_cache_.stats(); }
+  // The number of Gets which were attached to an identical Get already in flight.
+  uint64_t coalesced_get_count() const { return in_flight_gets_.coalesced_count(); }
+  // When enabled, operations called without an explicit timeout use one derived from the observed
+  // latencies of previous successful operations of the same kind.  Disabled by default.
+  void set_adaptive_timeouts(bool enabled) { latency_estimator_.set_adaptive(enabled); }
+  nfs::HedgePolicy::Stats get_hedge_stats() const { return get_hedge_policy_.stats(); }
+#ifdef TESTING
+  // See DataGetterDispatcher::SetSendFunctor.
+  void SetSendFunctor(std::function<void(const std::string&)> send_functor) {
+    dispatcher_.SetSendFunctor(std::move(send_functor));
+  }
+#endif
 
   template<typename Data>
   boost::future<Data> Get(
       const typename Data::Name& data_name,
-      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10));
+      const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout);
+
+  // As above, but rather than returning a future, posts 'handler' to 'executor' with the outcome.
+  // 'handler' must be callable as void(nfs::Expected<Data>), and 'executor' must provide 'post'
+  // (e.g. boost::asio::io_service).  Like the overload above, this is coalesced with identical
+  // Gets already in flight.  This doesn't throw if the request can't be sent; 'handler' is posted
+  // with the error instead, as it is by the other handler overloads.
+  template<typename Data, typename Executor, typename Handler>
+  void Get(const typename Data::Name& data_name, Executor& executor, Handler handler,
+           const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout);
+
+  // Retrieves each of 'data_names', returning a future per name in the same order.  At most
+  // 'max_in_flight' requests are outstanding at once.  'timeout' applies to the batch as a whole
+  // and starts when this is called, so names still waiting for a free slot when it expires are
+  // never requested and time out with the rest.
+  template<typename Data>
+  std::vector<boost::future<Data>> GetMany(
+      const std::vector<typename Data::Name>& data_names,
+      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(60),
+      int max_in_flight = kDefaultMaxGetsInFlight);
 
   template<typename Data>
   VersionNamesFuture GetVersions(
       const typename Data::Name& data_name,
-      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10));
+      const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout);
+
+  // As above, but posts 'handler' to 'executor' with the outcome, as for the handler overload of
+  // Get.  'handler' must be callable as void(nfs::Expected<VersionNames>).
+  template<typename Data, typename Executor, typename Handler>
+  void GetVersions(const typename Data::Name& data_name, Executor& executor, Handler handler,
+                   const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout);
 
   template<typename Data>
   VersionNamesFuture GetBranch(
       const typename Data::Name& data_name,
       const StructuredDataVersions::VersionName& branch_tip,
-      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10));
+      const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout);
+
+  // As above, but posts 'handler' to 'executor' with the outcome, as for the handler overload of
+  // Get.  'handler' must be callable as void(nfs::Expected<VersionNames>).
+  template<typename Data, typename Executor, typename Handler>
+  void GetBranch(const typename Data::Name& data_name,
+                 const StructuredDataVersions::VersionName& branch_tip, Executor& executor,
+                 Handler handler,
+                 const std::chrono::steady_clock::duration& timeout = nfs::kUnspecifiedTimeout);
 
   // This should be the function used in the GroupToSingle (and maybe also SingleToSingle) functors
   // passed to 'routing.Join'.
@@ -84,10 +150,28 @@ class DataGetter {
   DataGetter(DataGetter&&);
   DataGetter& operator=(DataGetter);
 
-  routing::Timer<DataGetterService::GetResponse::Contents> get_timer_;
-  routing::Timer<DataGetterService::GetVersionsResponse::Contents> get_versions_timer_;
-  routing::Timer<DataGetterService::GetBranchResponse::Contents> get_branch_timer_;
+  // Sends the Get for 'data_name' on behalf of the callers attached to 'key' in 'in_flight_gets_'.
+  // If that throws, they're all resolved with the error before it's rethrown, so that later Gets
+  // for the same data aren't attached to an op which will never complete.
+  template<typename Data>
+  void SendGet(const typename Data::Name& data_name, const std::string& key,
+               const std::chrono::steady_clock::duration& timeout);
+
+  // Re-sends the Get for 'data_name' if it's still pending after the hedge delay.
+  template<typename Data>
+  void ScheduleGetHedges(nfs::MessageId message_id, const typename Data::Name& data_name,
+                         const std::chrono::steady_clock::duration& timeout);
+
+  // Declared before the pending ops, since their response and hedge functors may refer to these.
+  DataCache data_cache_;
+  InFlightGets in_flight_gets_;
+  nfs::LatencyEstimator latency_estimator_;
+  nfs::HedgePolicy get_hedge_policy_;
+  nfs::OpPool op_pool_;
   DataGetterDispatcher dispatcher_;
+  nfs::PendingOps<DataGetterService::GetResponse::Contents> get_ops_;
+  nfs::PendingOps<DataGetterService::GetVersionsResponse::Contents> get_versions_ops_;
+  nfs::PendingOps<DataGetterService::GetBranchResponse::Contents> get_branch_ops_;
   nfs::Service<DataGetterService> service_;
 #ifdef TESTING
   std::vector<passport::PublicPmid> kAllPmids_;
@@ -105,42 +189,134 @@ boost::future<passport::PublicPmid> DataGetter::Get<passport::PublicPmid>(
 template<typename Data>
 boost::future<Data> DataGetter::Get(const typename Data::Name& data_name,
                                     const std::chrono::steady_clock::duration& timeout) {
-  typedef DataGetterService::GetResponse::Contents ResponseContents;
   auto promise(std::make_shared<boost::promise<Data>>());
-  HandleGetResult<Data> response_functor(promise);
-  auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(get_timer_.AddTask(
-      timeout,
-      [op_data](ResponseContents get_response) {
-          op_data->HandleResponseContents(std::move(get_response));
-      },
-      // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-      routing::Parameters::node_group_size * 2));
-  dispatcher_.SendGetRequest(task_id, data_name);
+  auto cached_data(data_cache_.Get<Data>(data_name));
+  if (cached_data) {
+    promise->set_value(std::move(*cached_data));
+    return promise->get_future();
+  }
+  const std::string key(DataCache::Key(Data::Tag::kValue, data_name.value));
+  if (!in_flight_gets_.Join(key, HandleGetResult<Data>(promise, &data_cache_)))
+    SendGet<Data>(data_name, key, timeout);
   return promise->get_future();
 }
 
+template<typename Data, typename Executor, typename Handler>
+void DataGetter::Get(const typename Data::Name& data_name, Executor& executor, Handler handler,
+                     const std::chrono::steady_clock::duration& timeout) {
+  auto cached_data(data_cache_.Get<Data>(data_name));
+  if (cached_data) {
+    return PostCompletion(executor, std::move(handler),
+                          nfs::Expected<Data>(std::move(*cached_data)));
+  }
+  const std::string key(DataCache::Key(Data::Tag::kValue, data_name.value));
+  if (!in_flight_gets_.Join(key, PostGetResult<Data, Executor, Handler>(
+                                     executor, std::move(handler), &data_cache_))) {
+    try {
+      SendGet<Data>(data_name, key, timeout);
+    }
+    catch(...) {
+      // SendGet has resolved the Gets attached to 'key', so 'handler' has been passed the error.
+    }
+  }
+}
+
+template<typename Data>
+void DataGetter::SendGet(const typename Data::Name& data_name, const std::string& key,
+                         const std::chrono::steady_clock::duration& timeout) {
+  typedef DataGetterService::GetResponse::Contents ResponseContents;
+  boost::optional<nfs::MessageId> message_id;
+  try {
+    const auto start_time(std::chrono::steady_clock::now());
+    auto response_functor([this, key, start_time](const ResponseContents& result) {
+                            latency_estimator_.AddResult(nfs::MessageAction::kGetRequest,
+                                                         nfs::Persona::kDataManager, start_time,
+                                                         result);
+                            in_flight_gets_.Resolve(key, result);
+                          });
+    auto op_data(nfs::MakeOpData<ResponseContents>(op_pool_, 1, response_functor));
+    const auto op_timeout(latency_estimator_.Timeout(nfs::MessageAction::kGetRequest,
+                                                     nfs::Persona::kDataManager, timeout));
+    message_id = get_ops_.Add(op_data, op_timeout);
+    dispatcher_.SendGetRequest<Data>(*message_id, data_name);
+    ScheduleGetHedges<Data>(*message_id, data_name, op_timeout);
+  }
+  catch(...) {
+    // Once the op is registered, cancelling it resolves 'key' via its response functor.
+    if (message_id)
+      get_ops_.Cancel(*message_id, GetFailureResponse(data_name));
+    else
+      in_flight_gets_.Resolve(key, GetFailureResponse(data_name));
+    throw;
+  }
+}
+
+template<typename Data>
+void DataGetter::ScheduleGetHedges(nfs::MessageId message_id, const typename Data::Name& data_name,
+                                   const std::chrono::steady_clock::duration& timeout) {
+  get_hedge_policy_.AddRequest();
+  if (!get_hedge_policy_.enabled())
+    return;
+  const auto latency_estimate(latency_estimator_.Percentile(
+      nfs::MessageAction::kGetRequest, nfs::Persona::kDataManager,
+      get_hedge_policy_.latency_percentile()));
+  get_ops_.ScheduleHedges(message_id, get_hedge_policy_.Delay(timeout, latency_estimate),
+                          get_hedge_policy_,
+                          [this, data_name](nfs::MessageId hedge_id) {
+                            dispatcher_.SendGetRequest<Data>(hedge_id, data_name);
+                          });
+}
+
+template<typename Data>
+std::vector<boost::future<Data>> DataGetter::GetMany(
+    const std::vector<typename Data::Name>& data_names,
+    const std::chrono::steady_clock::duration& timeout, int max_in_flight) {
+  return PipelinedGetMany<Data>(data_names, timeout, max_in_flight, data_cache_, in_flight_gets_,
+                                op_pool_, get_ops_, dispatcher_);
+}
+
 template<typename Data>
 DataGetter::VersionNamesFuture DataGetter::GetVersions(
     const typename Data::Name& data_name,
     const std::chrono::steady_clock::duration& timeout) {
   typedef DataGetterService::GetVersionsResponse::Contents ResponseContents;
   auto promise(std::make_shared<VersionNamesPromise>());
-  auto response_functor([promise](const StructuredDataNameAndContentOrReturnCode& result) {
+  const auto start_time(std::chrono::steady_clock::now());
+  auto response_functor([this, promise, start_time](
+                            const StructuredDataNameAndContentOrReturnCode& result) {
+                          latency_estimator_.AddResult(nfs::MessageAction::kGetVersionsRequest,
+                                                       nfs::Persona::kVersionManager, start_time,
+                                                       result);
                           HandleGetVersionsOrBranchResult(result, promise);
                         });
-  auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(get_versions_timer_.AddTask(
-      timeout,
-      [op_data](ResponseContents get_versions_response) {
-          op_data->HandleResponseContents(std::move(get_versions_response));
-      },
-      // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-      routing::Parameters::node_group_size * 2));
-  dispatcher_.SendGetVersionsRequest(task_id, data_name);
+  auto op_data(nfs::MakeOpData<ResponseContents>(op_pool_, 1, response_functor));
+  auto message_id(get_versions_ops_.Add(op_data, latency_estimator_.Timeout(
+      nfs::MessageAction::kGetVersionsRequest, nfs::Persona::kVersionManager, timeout)));
+  dispatcher_.SendGetVersionsRequest<Data>(message_id, data_name);
   return promise->get_future();
 }
 
+template<typename Data, typename Executor, typename Handler>
+void DataGetter::GetVersions(const typename Data::Name& data_name, Executor& executor,
+                             Handler handler, const std::chrono::steady_clock::duration& timeout) {
+  typedef DataGetterService::GetVersionsResponse::Contents ResponseContents;
+  const auto start_time(std::chrono::steady_clock::now());
+  auto op_data(MakeCompletionOp<ResponseContents>(
+      op_pool_, 1, executor, std::move(handler),
+      [this, start_time](const ResponseContents& result)->nfs::Expected<VersionNames> {
+        latency_estimator_.AddResult(nfs::MessageAction::kGetVersionsRequest,
+                                     nfs::Persona::kVersionManager, start_time, result);
+        return GetVersionsOrBranchResult(result);
+      }));
+  StartCompletionOp(get_versions_ops_, op_data,
+                    latency_estimator_.Timeout(nfs::MessageAction::kGetVersionsRequest,
+                                               nfs::Persona::kVersionManager, timeout),
+                    [this, &data_name](nfs::MessageId message_id) {
+                      dispatcher_.SendGetVersionsRequest<Data>(message_id, data_name);
+                    },
+                    [&data_name] { return VersionsFailureResponse(data_name); });
+}
+
 template<typename Data>
 DataGetter::VersionNamesFuture DataGetter::GetBranch(
     const typename Data::Name& data_name,
@@ -148,21 +324,44 @@ DataGetter::VersionNamesFuture DataGetter::GetBranch(
     const std::chrono::steady_clock::duration& timeout) {
   typedef DataGetterService::GetBranchResponse::Contents ResponseContents;
   auto promise(std::make_shared<VersionNamesPromise>());
-  auto response_functor([promise](const StructuredDataNameAndContentOrReturnCode& result) {
+  const auto start_time(std::chrono::steady_clock::now());
+  auto response_functor([this, promise, start_time](
+                            const StructuredDataNameAndContentOrReturnCode& result) {
+                          latency_estimator_.AddResult(nfs::MessageAction::kGetBranchRequest,
+                                                       nfs::Persona::kVersionManager, start_time,
+                                                       result);
                           HandleGetVersionsOrBranchResult(result, promise);
                         });
-  auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-  auto task_id(get_branch_timer_.AddTask(
-      timeout,
-      [op_data](ResponseContents get_branch_response) {
-          op_data->HandleResponseContents(std::move(get_branch_response));
-      },
-      // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-      routing::Parameters::node_group_size * 2));
-  dispatcher_.SendGetBranchRequest(task_id, data_name, branch_tip);
+  auto op_data(nfs::MakeOpData<ResponseContents>(op_pool_, 1, response_functor));
+  auto message_id(get_branch_ops_.Add(op_data, latency_estimator_.Timeout(
+      nfs::MessageAction::kGetBranchRequest, nfs::Persona::kVersionManager, timeout)));
+  dispatcher_.SendGetBranchRequest<Data>(message_id, data_name, branch_tip);
   return promise->get_future();
 }
 
+template<typename Data, typename Executor, typename Handler>
+void DataGetter::GetBranch(const typename Data::Name& data_name,
+                           const StructuredDataVersions::VersionName& branch_tip,
+                           Executor& executor, Handler handler,
+                           const std::chrono::steady_clock::duration& timeout) {
+  typedef DataGetterService::GetBranchResponse::Contents ResponseContents;
+  const auto start_time(std::chrono::steady_clock::now());
+  auto op_data(MakeCompletionOp<ResponseContents>(
+      op_pool_, 1, executor, std::move(handler),
+      [this, start_time](const ResponseContents& result)->nfs::Expected<VersionNames> {
+        latency_estimator_.AddResult(nfs::MessageAction::kGetBranchRequest,
+                                     nfs::Persona::kVersionManager, start_time, result);
+        return GetVersionsOrBranchResult(result);
+      }));
+  StartCompletionOp(get_branch_ops_, op_data,
+                    latency_estimator_.Timeout(nfs::MessageAction::kGetBranchRequest,
+                                               nfs::Persona::kVersionManager, timeout),
+                    [this, &data_name, &branch_tip](nfs::MessageId message_id) {
+                      dispatcher_.SendGetBranchRequest<Data>(message_id, data_name, branch_tip);
+                    },
+                    [&data_name] { return VersionsFailureResponse(data_name); });
+}
+
 template<typename T>
 void DataGetter::HandleMessage(const T& routing_message) {
   auto wrapper_tuple(nfs::ParseMessageWrapper(routing_message.contents));
@@ -19,7 +19,9 @@
 #ifndef MAIDSAFE_NFS_CLIENT_DATA_GETTER_DISPATCHER_H_
 #define MAIDSAFE_NFS_CLIENT_DATA_GETTER_DISPATCHER_H_
 
+#include <functional>
 #include <string>
+#include <utility>
 
 #include "maidsafe/data_types/structured_data_versions.h"
 #include "maidsafe/routing/message.h"
@@ -41,16 +43,25 @@ class DataGetterDispatcher {
   explicit DataGetterDispatcher(routing::Routing& routing);
 
   template<typename Data>
-  void SendGetRequest(routing::TaskId task_id, const typename Data::Name& data_name);
+  void SendGetRequest(nfs::MessageId message_id, const typename Data::Name& data_name);
 
   template<typename Data>
-  void SendGetVersionsRequest(routing::TaskId task_id, const typename Data::Name& data_name);
+  void SendGetVersionsRequest(nfs::MessageId message_id, const typename Data::Name& data_name);
 
   template<typename Data>
-  void SendGetBranchRequest(routing::TaskId task_id,
+  void SendGetBranchRequest(nfs::MessageId message_id,
                             const typename Data::Name& data_name,
                             const StructuredDataVersions::VersionName& branch_tip);
 
+#ifdef TESTING
+  // Passes the serialised nfs message of every subsequent request to 'send_functor' instead of
+  // sending it via routing, so that tests can capture requests or make sending fail.  Must not be
+  // called while requests are being sent.
+  void SetSendFunctor(std::function<void(const std::string&)> send_functor) {
+    send_functor_ = std::move(send_functor);
+  }
+#endif
+
  private:
   DataGetterDispatcher();
   DataGetterDispatcher(const DataGetterDispatcher&);
@@ -60,42 +71,49 @@ class DataGetterDispatcher {
   template<typename Message>
   void CheckSourcePersonaType() const;
 
+  template<typename RoutingMessage>
+  void Send(const RoutingMessage& routing_message);
+
   routing::Routing& routing_;
   const routing::SingleSource kThisNodeAsSender_;
+#ifdef TESTING
+  std::function<void(const std::string&)> send_functor_;
+#endif
 };
 
 
 
 // ==================== Implementation =============================================================
 template<typename Data>
-void DataGetterDispatcher::SendGetRequest(routing::TaskId task_id,
+void DataGetterDispatcher::SendGetRequest(nfs::MessageId message_id,
                                           const typename Data::Name& data_name) {
   typedef nfs::GetRequestFromDataGetterToDataManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   static const routing::Cacheable kCacheable(is_cacheable<Data>::value ? routing::Cacheable::kGet :
                                                                          routing::Cacheable::kNone);
-  NfsMessage nfs_message((nfs::MessageId(task_id), NfsMessage::Contents(data_name)));
+  NfsMessage nfs_message(message_id, NfsMessage::Contents(data_name));
   NfsMessage::Receiver receiver(routing::GroupId(NodeId(data_name->string())));
-  RoutingMessage routing_message(nfs_message.Serialise(), kThisNodeAsSender_, receiver, kCacheable);
-  routing_.Send(routing_message);
+  RoutingMessage routing_message(std::move(nfs_message).Serialise(), kThisNodeAsSender_, receiver,
+                                 kCacheable);
+  Send(routing_message);
 }
 
 template<typename Data>
-void DataGetterDispatcher::SendGetVersionsRequest(routing::TaskId task_id,
+void DataGetterDispatcher::SendGetVersionsRequest(nfs::MessageId message_id,
                                                   const typename Data::Name& data_name) {
   typedef nfs::GetVersionsRequestFromDataGetterToVersionManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
-  NfsMessage nfs_message((nfs::MessageId(task_id), NfsMessage::Contents(data_name)));
+  NfsMessage nfs_message(message_id, NfsMessage::Contents(data_name));
   NfsMessage::Receiver receiver(routing::GroupId(NodeId(data_name->string())));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, receiver));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_, receiver));
 }
 
 template<typename Data>
 void DataGetterDispatcher::SendGetBranchRequest(
-    routing::TaskId task_id,
+    nfs::MessageId message_id,
     const typename Data::Name& data_name,
     const StructuredDataVersions::VersionName& branch_tip) {
   typedef nfs::GetBranchRequestFromDataGetterToVersionManager NfsMessage;
@@ -103,11 +121,20 @@ void DataGetterDispatcher::SendGetBranchRequest(
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage::Contents contents;
-  contents.data_name = DataName(data_name);
+  contents.data_name = nfs_vault::DataName(data_name);
   contents.version_name = branch_tip;
-  NfsMessage nfs_message(nfs::MessageId(task_id), contents);
+  NfsMessage nfs_message(message_id, std::move(contents));
   NfsMessage::Receiver receiver(routing::GroupId(NodeId(data_name->string())));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, receiver));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_, receiver));
+}
+
+template<typename RoutingMessage>
+void DataGetterDispatcher::Send(const RoutingMessage& routing_message) {
+#ifdef TESTING
+  if (send_functor_)
+    return send_functor_(routing_message.contents);
+#endif
+  routing_.Send(routing_message);
 }
 
 template<typename Message>
@@ -20,9 +20,10 @@
 #define MAIDSAFE_NFS_CLIENT_DATA_GETTER_SERVICE_H_
 
 #include "maidsafe/routing/routing_api.h"
-#include "maidsafe/routing/timer.h"
 
 #include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/pending_ops.h"
 #include "maidsafe/nfs/client/messages.h"
 #include "maidsafe/nfs/vault/messages.h"
 
@@ -42,9 +43,13 @@ class DataGetterService {
 
   DataGetterService(
       routing::Routing& routing,
-      routing::Timer<DataGetterService::GetResponse::Contents>& get_timer,
-      routing::Timer<DataGetterService::GetVersionsResponse::Contents>& get_versions_timer,
-      routing::Timer<DataGetterService::GetBranchResponse::Contents>& get_branch_timer);
+      nfs::PendingOps<DataGetterService::GetResponse::Contents>& get_ops,
+      nfs::PendingOps<DataGetterService::GetVersionsResponse::Contents>& get_versions_ops,
+      nfs::PendingOps<DataGetterService::GetBranchResponse::Contents>& get_branch_ops);
+
+  // Called by nfs::Service before the message contents are parsed.  Returns false for responses
+  // to Get, GetVersions or GetBranch requests which have already been resolved or have timed out.
+  bool IsLive(const nfs::TypeErasedMessageWrapper& message) const;
 
   template<typename T>
   void HandleMessage(const T& /*message*/,
@@ -55,9 +60,9 @@ class DataGetterService {
 
  private:
   routing::Routing& routing_;
-  routing::Timer<DataGetterService::GetResponse::Contents>& get_timer_;
-  routing::Timer<DataGetterService::GetVersionsResponse::Contents>& get_versions_timer_;
-  routing::Timer<DataGetterService::GetBranchResponse::Contents>& get_branch_timer_;
+  nfs::PendingOps<DataGetterService::GetResponse::Contents>& get_ops_;
+  nfs::PendingOps<DataGetterService::GetVersionsResponse::Contents>& get_versions_ops_;
+  nfs::PendingOps<DataGetterService::GetBranchResponse::Contents>& get_branch_ops_;
 };
 
 template<>
@@ -0,0 +1,205 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_GET_MANY_H_
+#define MAIDSAFE_NFS_CLIENT_GET_MANY_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/thread/future.hpp"
+
+#include "maidsafe/common/error.h"
+
+#include "maidsafe/nfs/op_pool.h"
+#include "maidsafe/nfs/pending_ops.h"
+#include "maidsafe/nfs/types.h"
+#include "maidsafe/nfs/utils.h"
+#include "maidsafe/nfs/client/client_utils.h"
+#include "maidsafe/nfs/client/data_cache.h"
+#include "maidsafe/nfs/client/in_flight_gets.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// Implements 'GetMany' for a client.  Names found in 'data_cache' are resolved immediately, and
+// names already being retrieved (including duplicates within 'data_names') are attached to the
+// in-flight Get.  Ops for the remaining names are registered as a single batch with one timer task
+// covering the whole batch, and their requests are pipelined through 'dispatcher' so that at most
+// 'max_in_flight' are outstanding at once; each completion sends the next request.  'timeout'
+// starts here rather than when each request is sent, and once it has expired no further requests
+// are sent.  The ops' state is allocated from 'op_pool'.
+template<typename Data, typename Dispatcher, typename ResponseContents>
+std::vector<boost::future<Data>> PipelinedGetMany(
+    const std::vector<typename Data::Name>& data_names,
+    const std::chrono::steady_clock::duration& timeout, int max_in_flight, DataCache& data_cache,
+    InFlightGets& in_flight_gets, const nfs::OpPool& op_pool,
+    nfs::PendingOps<ResponseContents>& get_ops, Dispatcher& dispatcher);
+
+template<typename Data, typename Dispatcher, typename ResponseContents>
+class GetManyPipeline {
+ public:
+  GetManyPipeline(nfs::PendingOps<ResponseContents>& get_ops, Dispatcher& dispatcher,
+                  std::chrono::steady_clock::time_point deadline)
+      : get_ops_(get_ops),
+        dispatcher_(dispatcher),
+        kDeadline_(deadline),
+        mutex_(),
+        requests_(),
+        next_request_(0),
+        sends_owed_(0) {}
+
+  void SetRequests(std::vector<std::pair<nfs::MessageId, typename Data::Name>>&& requests) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_ = std::move(requests);
+  }
+
+  // Sends the next request whose op is still pending.  Ops which have already timed out are
+  // skipped, and nothing is sent once the batch's deadline has passed: the remaining ops are about
+  // to time out, and in particular, each op resolved by the batch timeout calls this.  If a request
+  // can't be sent, its op is cancelled with the error and the following request is sent instead.
+  // This never throws, since it's called from the ops' response functors.
+  void SendNext();
+
+ private:
+  GetManyPipeline(const GetManyPipeline&);
+  GetManyPipeline(GetManyPipeline&&);
+  GetManyPipeline& operator=(GetManyPipeline);
+
+  // Must be called with 'mutex_' held.  Returns the index of the next request to send, or the
+  // number of requests if there's nothing left to send.
+  std::size_t NextRequest();
+
+  nfs::PendingOps<ResponseContents>& get_ops_;
+  Dispatcher& dispatcher_;
+  const std::chrono::steady_clock::time_point kDeadline_;
+  std::mutex mutex_;
+  std::vector<std::pair<nfs::MessageId, typename Data::Name>> requests_;
+  std::size_t next_request_;
+  // The number of SendNext calls not yet served.  Only the call which raises this from 0 sends;
+  // calls made meanwhile (including those from ops cancelled by a failed send, which would
+  // otherwise recurse) leave their send to it.
+  std::size_t sends_owed_;
+};
+
+
+
+// ==================== Implementation =============================================================
+template<typename Data, typename Dispatcher, typename ResponseContents>
+std::vector<boost::future<Data>> PipelinedGetMany(
+    const std::vector<typename Data::Name>& data_names,
+    const std::chrono::steady_clock::duration& timeout, int max_in_flight, DataCache& data_cache,
+    InFlightGets& in_flight_gets, const nfs::OpPool& op_pool,
+    nfs::PendingOps<ResponseContents>& get_ops, Dispatcher& dispatcher) {
+  if (max_in_flight <= 0)
+    ThrowError(CommonErrors::invalid_parameter);
+
+  typedef GetManyPipeline<Data, Dispatcher, ResponseContents> Pipeline;
+  auto pipeline(std::make_shared<Pipeline>(get_ops, dispatcher,
+                                           std::chrono::steady_clock::now() + timeout));
+  std::vector<boost::future<Data>> futures;
+  futures.reserve(data_names.size());
+  std::vector<std::shared_ptr<nfs::OpData<ResponseContents>>> op_datas;
+  std::vector<typename Data::Name> names_to_send;
+  std::vector<std::string> keys_to_send;
+  for (const auto& data_name : data_names) {
+    auto promise(std::make_shared<boost::promise<Data>>());
+    futures.push_back(promise->get_future());
+    auto cached_data(data_cache.Get<Data>(data_name));
+    if (cached_data) {
+      promise->set_value(std::move(*cached_data));
+      continue;
+    }
+    const std::string key(DataCache::Key(Data::Tag::kValue, data_name.value));
+    if (in_flight_gets.Join(key, HandleGetResult<Data>(promise, &data_cache)))
+      continue;
+
+    InFlightGets* in_flight_gets_ptr(&in_flight_gets);
+    auto response_functor([in_flight_gets_ptr, key, pipeline](const ResponseContents& result) {
+                            in_flight_gets_ptr->Resolve(key, result);
+                            pipeline->SendNext();
+                          });
+    op_datas.push_back(nfs::MakeOpData<ResponseContents>(op_pool, 1, response_functor));
+    names_to_send.push_back(data_name);
+    keys_to_send.push_back(key);
+  }
+  if (op_datas.empty())
+    return futures;
+
+  auto message_ids(get_ops.AddBatch(op_datas, timeout, keys_to_send));
+  std::vector<std::pair<nfs::MessageId, typename Data::Name>> requests;
+  requests.reserve(message_ids.size());
+  for (std::size_t i(0); i != message_ids.size(); ++i)
+    requests.push_back(std::make_pair(message_ids[i], names_to_send[i]));
+  pipeline->SetRequests(std::move(requests));
+  const std::size_t initial_count(std::min(message_ids.size(),
+                                           static_cast<std::size_t>(max_in_flight)));
+  for (std::size_t i(0); i != initial_count; ++i)
+    pipeline->SendNext();
+  return futures;
+}
+
+template<typename Data, typename Dispatcher, typename ResponseContents>
+void GetManyPipeline<Data, Dispatcher, ResponseContents>::SendNext() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (sends_owed_++ != 0)
+    return;
+  for (;;) {
+    const std::size_t index(NextRequest());
+    if (index != requests_.size()) {
+      const auto request(requests_[index]);
+      lock.unlock();
+      try {
+        dispatcher_.template SendGetRequest<Data>(request.first, request.second);
+      }
+      catch(...) {
+        // This resolves the op, whose response functor calls SendNext to replace it.
+        get_ops_.Cancel(request.first, GetFailureResponse(request.second));
+      }
+      lock.lock();
+    }
+    if (--sends_owed_ == 0)
+      return;
+  }
+}
+
+template<typename Data, typename Dispatcher, typename ResponseContents>
+std::size_t GetManyPipeline<Data, Dispatcher, ResponseContents>::NextRequest() {
+  if (std::chrono::steady_clock::now() >= kDeadline_)
+    return requests_.size();
+  while (next_request_ < requests_.size()) {
+    if (get_ops_.Contains(requests_[next_request_].first))
+      return next_request_++;
+    ++next_request_;
+  }
+  return requests_.size();
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_GET_MANY_H_
@@ -0,0 +1,72 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CLIENT_IN_FLIGHT_GETS_H_
+#define MAIDSAFE_NFS_CLIENT_IN_FLIGHT_GETS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "maidsafe/nfs/client/messages.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+// Coalesces concurrent Gets for the same data.  While a Get for a given key (see DataCache::Key)
+// is in flight, further callers are attached to it rather than sending their own request, and are
+// all passed the single result when it arrives.  Attached callers share the first caller's
+// timeout.
+class InFlightGets {
+ public:
+  typedef std::function<void(const DataNameAndContentOrReturnCode&)> GetFunctor;
+
+  InFlightGets();
+
+  // Returns true if 'functor' was attached to a Get already in flight for 'key'.  Otherwise, a new
+  // in-flight Get is recorded for 'key' and the caller must send the request, and then pass the
+  // result to 'Resolve' once its op completes.
+  bool Join(const std::string& key, const GetFunctor& functor);
+  // Retires the in-flight Get for 'key', passing 'result' to every functor attached to it.
+  void Resolve(const std::string& key, const DataNameAndContentOrReturnCode& result);
+
+  std::size_t size() const;
+  // The number of calls to 'Join' which were attached to an existing Get.
+  uint64_t coalesced_count() const { return coalesced_count_; }
+
+ private:
+  InFlightGets(const InFlightGets&);
+  InFlightGets(InFlightGets&&);
+  InFlightGets& operator=(InFlightGets);
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::vector<GetFunctor>> gets_;
+  std::atomic<uint64_t> coalesced_count_;
+};
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CLIENT_IN_FLIGHT_GETS_H_
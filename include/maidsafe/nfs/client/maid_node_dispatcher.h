@@ -19,7 +19,9 @@
 #ifndef MAIDSAFE_NFS_CLIENT_MAID_NODE_DISPATCHER_H_
 #define MAIDSAFE_NFS_CLIENT_MAID_NODE_DISPATCHER_H_
 
+#include <functional>
 #include <string>
+#include <utility>
 
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/types.h"
@@ -46,19 +48,22 @@ class MaidNodeDispatcher {
   explicit MaidNodeDispatcher(routing::Routing& routing);
 
   template<typename Data>
-  void SendGetRequest(routing::TaskId task_id, const typename Data::Name& data_name);
+  void SendGetRequest(nfs::MessageId message_id, const typename Data::Name& data_name);
 
+  // 'data' is the Data being put, already converted so that the caller can hold on to it cheaply
+  // (e.g. while the Put is queued), since its content is shared rather than copied.
   template<typename Data>
-  void SendPutRequest(const Data& data, const passport::PublicPmid::Name& pmid_node_hint);
+  void SendPutRequest(nfs::MessageId message_id, const nfs_vault::DataNameAndContent& data,
+                      const passport::PublicPmid::Name& pmid_node_hint);
 
   template<typename Data>
   void SendDeleteRequest(const typename Data::Name& data_name);
 
   template<typename Data>
-  void SendGetVersionsRequest(routing::TaskId task_id, const typename Data::Name& data_name);
+  void SendGetVersionsRequest(nfs::MessageId message_id, const typename Data::Name& data_name);
 
   template<typename Data>
-  void SendGetBranchRequest(routing::TaskId task_id,
+  void SendGetBranchRequest(nfs::MessageId message_id,
                             const typename Data::Name& data_name,
                             const StructuredDataVersions::VersionName& branch_tip);
 
@@ -84,6 +89,15 @@ class MaidNodeDispatcher {
 
   void SendGetPmidHealthRequest(const passport::Pmid& pmid);
 
+#ifdef TESTING
+  // Passes the serialised nfs message of every subsequent request to 'send_functor' instead of
+  // sending it via routing, so that tests can capture requests or make sending fail.  Must not be
+  // called while requests are being sent.
+  void SetSendFunctor(std::function<void(const std::string&)> send_functor) {
+    send_functor_ = std::move(send_functor);
+  }
+#endif
+
  private:
   MaidNodeDispatcher();
   MaidNodeDispatcher(const MaidNodeDispatcher&);
@@ -93,30 +107,38 @@ class MaidNodeDispatcher {
   template<typename Message>
   void CheckSourcePersonaType() const;
 
+  template<typename RoutingMessage>
+  void Send(const RoutingMessage& routing_message);
+
   routing::Routing& routing_;
   const routing::SingleSource kThisNodeAsSender_;
   const routing::GroupId kMaidManagerReceiver_;
+#ifdef TESTING
+  std::function<void(const std::string&)> send_functor_;
+#endif
 };
 
 
 
 // ==================== Implementation =============================================================
 template<typename Data>
-void MaidNodeDispatcher::SendGetRequest(routing::TaskId task_id,
+void MaidNodeDispatcher::SendGetRequest(nfs::MessageId message_id,
                                         const typename Data::Name& data_name) {
   typedef nfs::GetRequestFromMaidNodeToDataManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   static const routing::Cacheable kCacheable(is_cacheable<Data>::value ? routing::Cacheable::kGet :
                                                                          routing::Cacheable::kNone);
-  NfsMessage nfs_message((nfs::MessageId(task_id), NfsMessage::Contents(data_name)));
+  NfsMessage nfs_message(message_id, NfsMessage::Contents(data_name));
   NfsMessage::Receiver receiver(routing::GroupId(NodeId(data_name->string())));
-  RoutingMessage routing_message(nfs_message.Serialise(), kThisNodeAsSender_, receiver, kCacheable);
-  routing_.Send(routing_message);
+  RoutingMessage routing_message(std::move(nfs_message).Serialise(), kThisNodeAsSender_, receiver,
+                                 kCacheable);
+  Send(routing_message);
 }
 
 template<typename Data>
-void MaidNodeDispatcher::SendPutRequest(const Data& data,
+void MaidNodeDispatcher::SendPutRequest(nfs::MessageId message_id,
+                                        const nfs_vault::DataNameAndContent& data,
                                         const passport::PublicPmid::Name& pmid_node_hint) {
   typedef nfs::PutRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
@@ -124,11 +146,11 @@ void MaidNodeDispatcher::SendPutRequest(const Data& data,
   static const routing::Cacheable kCacheable(is_cacheable<Data>::value ? routing::Cacheable::kPut :
                                                                          routing::Cacheable::kNone);
   NfsMessage::Contents contents;
-  contents.data = nfs_vault::DataNameAndContent(data);
+  contents.data = data;
   contents.pmid_hint = pmid_node_hint.value;
-  NfsMessage nfs_message(contents);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_,
-                               kCacheable));
+  NfsMessage nfs_message(message_id, std::move(contents));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_, kCacheable));
 }
 
 template<typename Data>
@@ -138,24 +160,25 @@ void MaidNodeDispatcher::SendDeleteRequest(const typename Data::Name& data_name)
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage nfs_message((NfsMessage::Contents(data_name)));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_));
 }
 
 template<typename Data>
-void MaidNodeDispatcher::SendGetVersionsRequest(routing::TaskId task_id,
+void MaidNodeDispatcher::SendGetVersionsRequest(nfs::MessageId message_id,
                                                 const typename Data::Name& data_name) {
   typedef nfs::GetVersionsRequestFromMaidNodeToVersionManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
-  NfsMessage nfs_message((nfs::MessageId(task_id), NfsMessage::Contents(data_name)));
+  NfsMessage nfs_message(message_id, NfsMessage::Contents(data_name));
   NfsMessage::Receiver receiver(routing::GroupId(NodeId(data_name->string())));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, receiver));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_, receiver));
 }
 
 template<typename Data>
 void MaidNodeDispatcher::SendGetBranchRequest(
-    routing::TaskId task_id,
+    nfs::MessageId message_id,
     const typename Data::Name& data_name,
     const StructuredDataVersions::VersionName& branch_tip) {
   typedef nfs::GetBranchRequestFromMaidNodeToVersionManager NfsMessage;
@@ -163,11 +186,11 @@ void MaidNodeDispatcher::SendGetBranchRequest(
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage::Contents contents;
-  contents.data_name = DataName(data_name);
+  contents.data_name = nfs_vault::DataName(data_name);
   contents.version_name = branch_tip;
-  NfsMessage nfs_message(nfs::MessageId(task_id), contents);
+  NfsMessage nfs_message(message_id, std::move(contents));
   NfsMessage::Receiver receiver(routing::GroupId(NodeId(data_name->string())));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, receiver));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_, receiver));
 }
 
 template<typename Data>
@@ -181,11 +204,12 @@ void MaidNodeDispatcher::SendPutVersionRequest(
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage::Contents contents;
-  contents.data_name = DataName(data_name);
+  contents.data_name = nfs_vault::DataName(data_name);
   contents.old_version_name = old_version_name;
   contents.new_version_name = new_version_name;
-  NfsMessage nfs_message(nfs::MessageId(task_id), contents);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  NfsMessage nfs_message(nfs::MessageId(task_id), std::move(contents));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_));
 }
 
 template<typename Data>
@@ -197,10 +221,20 @@ void MaidNodeDispatcher::SendDeleteBranchUntilForkRequest(
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
 
   NfsMessage::Contents contents;
-  contents.data_name = DataName(data_name);
+  contents.data_name = nfs_vault::DataName(data_name);
   contents.version_name = branch_tip;
-  NfsMessage nfs_message(contents);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  NfsMessage nfs_message(std::move(contents));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_));
+}
+
+template<typename RoutingMessage>
+void MaidNodeDispatcher::Send(const RoutingMessage& routing_message) {
+#ifdef TESTING
+  if (send_functor_)
+    return send_functor_(routing_message.contents);
+#endif
+  routing_.Send(routing_message);
 }
 
 template<typename Message>
@@ -20,9 +20,10 @@
 #define MAIDSAFE_NFS_CLIENT_MAID_NODE_SERVICE_H_
 
 #include "maidsafe/routing/routing_api.h"
-#include "maidsafe/routing/timer.h"
 
 #include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/pending_ops.h"
 #include "maidsafe/nfs/client/messages.h"
 #include "maidsafe/nfs/vault/messages.h"
 
@@ -44,9 +45,15 @@ class MaidNodeService {
 
   MaidNodeService(
       routing::Routing& routing,
-      routing::Timer<MaidNodeService::GetResponse::Contents>& get_timer,
-      routing::Timer<MaidNodeService::GetVersionsResponse::Contents>& get_versions_timer,
-      routing::Timer<MaidNodeService::GetBranchResponse::Contents>& get_branch_timer);
+      nfs::PendingOps<MaidNodeService::GetResponse::Contents>& get_ops,
+      nfs::PendingOps<MaidNodeService::GetVersionsResponse::Contents>& get_versions_ops,
+      nfs::PendingOps<MaidNodeService::GetBranchResponse::Contents>& get_branch_ops,
+      nfs::PendingOps<MaidNodeService::PutResponse::Contents>& put_ops);
+
+  // Called by nfs::Service before the message contents are parsed.  Returns false for responses
+  // to Get, GetVersions, GetBranch or Put requests which have already been resolved or have timed
+  // out.
+  bool IsLive(const nfs::TypeErasedMessageWrapper& message) const;
 
   template<typename T>
   void HandleMessage(const T& /*message*/,
@@ -61,9 +68,10 @@ class MaidNodeService {
                          const typename nfs::PutRequestFromMaidNodeToMaidManager::Sender& sender);
 
   routing::Routing& routing_;
-  routing::Timer<MaidNodeService::GetResponse::Contents>& get_timer_;
-  routing::Timer<MaidNodeService::GetVersionsResponse::Contents>& get_versions_timer_;
-  routing::Timer<MaidNodeService::GetBranchResponse::Contents>& get_branch_timer_;
+  nfs::PendingOps<MaidNodeService::GetResponse::Contents>& get_ops_;
+  nfs::PendingOps<MaidNodeService::GetVersionsResponse::Contents>& get_versions_ops_;
+  nfs::PendingOps<MaidNodeService::GetBranchResponse::Contents>& get_branch_ops_;
+  nfs::PendingOps<MaidNodeService::PutResponse::Contents>& put_ops_;
 };
 
 template<>
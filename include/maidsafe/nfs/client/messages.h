@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_NFS_CLIENT_MESSAGES_H_
 #define MAIDSAFE_NFS_CLIENT_MESSAGES_H_
 
+#include <cstddef>
 #include <string>
 #include <system_error>
 #include <type_traits>
@@ -31,6 +32,8 @@
 #include "maidsafe/common/types.h"
 #include "maidsafe/data_types/data_type_values.h"
 
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/shared_buffer.h"
 #include "maidsafe/nfs/client/structured_data.h"
 #include "maidsafe/nfs/vault/messages.h"
 #include "maidsafe/nfs/utils.h"
@@ -224,6 +227,10 @@ struct DataNameAndContentAndReturnCode {
                                   const Identity& name_in,
                                   nfs_client::ReturnCode code_in,
                                   const NonEmptyString& content_in);
+  DataNameAndContentAndReturnCode(const DataTagValue& type_in,
+                                  const Identity& name_in,
+                                  nfs_client::ReturnCode code_in,
+                                  nfs::SharedBuffer content_in);
   DataNameAndContentAndReturnCode(const DataTagValue& type_in,
                                   const Identity& name_in,
                                   nfs_client::ReturnCode code_in);
@@ -237,7 +244,7 @@ struct DataNameAndContentAndReturnCode {
 
   nfs_vault::DataName name;
   nfs_client::ReturnCode return_code;
-  boost::optional<NonEmptyString> content;
+  boost::optional<nfs::SharedBuffer> content;
 };
 
 void swap(DataNameAndContentAndReturnCode& lhs,
@@ -252,6 +259,54 @@ bool operator==(const DataNameAndContentAndReturnCode& lhs,
 
 namespace nfs {
 
+template<>
+struct DirectCodec<nfs_client::ReturnCode> {
+  typedef nfs_client::ReturnCode Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_client::DataNameAndReturnCode> {
+  typedef nfs_client::DataNameAndReturnCode Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_client::DataNameAndContentOrReturnCode> {
+  typedef nfs_client::DataNameAndContentOrReturnCode Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_client::StructuredDataNameAndContentOrReturnCode> {
+  typedef nfs_client::StructuredDataNameAndContentOrReturnCode Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_client::DataPmidHintAndReturnCode> {
+  typedef nfs_client::DataPmidHintAndReturnCode Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_client::DataNameAndContentAndReturnCode> {
+  typedef nfs_client::DataNameAndContentAndReturnCode Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
 template<>
 bool IsSuccess<nfs_client::DataNameAndContentOrReturnCode>(
     const nfs_client::DataNameAndContentOrReturnCode& response);
@@ -260,6 +315,14 @@ template<>
 std::error_code ErrorCode<nfs_client::DataNameAndContentOrReturnCode>(
     const nfs_client::DataNameAndContentOrReturnCode& response);
 
+template<>
+bool IsSuccess<nfs_client::DataPmidHintAndReturnCode>(
+    const nfs_client::DataPmidHintAndReturnCode& response);
+
+template<>
+std::error_code ErrorCode<nfs_client::DataPmidHintAndReturnCode>(
+    const nfs_client::DataPmidHintAndReturnCode& response);
+
 template<>
 bool IsSuccess<nfs_client::StructuredDataNameAndContentOrReturnCode>(
     const nfs_client::StructuredDataNameAndContentOrReturnCode& response);
@@ -19,12 +19,17 @@
 #ifndef MAIDSAFE_NFS_CLIENT_STRUCTURED_DATA_H_
 #define MAIDSAFE_NFS_CLIENT_STRUCTURED_DATA_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+#include "boost/utility/string_ref.hpp"
+
 #include "maidsafe/common/config.h"
 #include "maidsafe/data_types/structured_data_versions.h"
 
+#include "maidsafe/nfs/message_wrapper.h"
+
 
 namespace maidsafe {
 
@@ -51,6 +56,20 @@ void swap(StructuredData& lhs, StructuredData& rhs) MAIDSAFE_NOEXCEPT;
 
 }  // namespace nfs_client
 
+
+
+namespace nfs {
+
+template<>
+struct DirectCodec<nfs_client::StructuredData> {
+  typedef nfs_client::StructuredData Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+}  // namespace nfs
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_NFS_CLIENT_STRUCTURED_DATA_H_
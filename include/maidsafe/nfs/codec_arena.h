@@ -0,0 +1,65 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_CODEC_ARENA_H_
+#define MAIDSAFE_NFS_CODEC_ARENA_H_
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+// Selects how nfs message contents are (de)serialised.  kDirect (the default) uses the
+// DirectCodec specialisations, which write and read the protobuf wire format straight to and from
+// the message buffer.  kProtobuf goes via the generated protobuf classes instead, as does
+// kProtobufArena, but with each MessageWrapper being serialised or having its contents parsed
+// getting a protobuf arena for the duration; every protobuf message (and its string fields) created
+// while encoding or decoding the nested contents is allocated from it and freed in one go
+// afterwards.  The arena's first block is reused per thread, so small messages need no arena
+// allocations at all.  Arenas need protobuf 3.14 or later (where every message type supports
+// them); otherwise kProtobufArena behaves as kProtobuf.  All modes produce identical encodings.
+enum class CodecMode { kDirect, kProtobuf, kProtobufArena };
+
+void SetCodecMode(CodecMode codec_mode);
+CodecMode GetCodecMode();
+// Whether this build's protobuf supports arena allocation of the nfs messages.
+bool ArenaCodecAvailable();
+
+// Makes the calling thread's codec arena current for the lifetime of the outermost instance, if
+// the codec mode is kProtobufArena.  Nested instances (e.g. for a MessageWrapper serialised while
+// serialising another one) share the outermost instance's arena.  All protobuf messages allocated
+// from the arena are destroyed when the outermost instance is, so instances must be scoped to the
+// encoding or decoding of a single message.
+class CodecArena {
+ public:
+  CodecArena();
+  ~CodecArena();
+
+ private:
+  CodecArena(const CodecArena&);
+  CodecArena(CodecArena&&);
+  CodecArena& operator=(CodecArena);
+
+  bool owns_arena_;
+};
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_CODEC_ARENA_H_
@@ -0,0 +1,73 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_ERROR_CATEGORIES_H_
+#define MAIDSAFE_NFS_ERROR_CATEGORIES_H_
+
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/error.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+// Stable numeric identifiers for the error categories which can be sent across the network, e.g.
+// in a ReturnCode.  These form part of the wire format, so existing values must never change;
+// new categories must be appended.
+enum class ErrorCategoryId : uint32_t {
+  kCommon = 1,
+  kAsymm = 2,
+  kPassport = 3,
+  kNfs = 4,
+  kRouting = 5,
+  kDrive = 6,
+  kVault = 7,
+  kLifeStuff = 8
+};
+
+// Returns an uninitialised optional if 'category' isn't one of the registered categories, in which
+// case it can only be sent across the network by name.
+boost::optional<ErrorCategoryId> GetErrorCategoryId(const std::error_category& category);
+
+// Governs whether a ReturnCode is serialised with its category's ID only, or with its category's
+// name too, as peers which predate the registry require.  Inbound ReturnCodes are always parsed by
+// ID if present, else by name, so this is negotiated network-wide: names are sent (the default)
+// until every peer runs a version which can decode IDs, and are then dropped by all.  Categories
+// which aren't registered are always sent by name.  A ReturnCode's size is computed separately from
+// its encoding, so this should only be changed while no messages are being serialised.
+void SetErrorCategoryIdsOnly(bool ids_only);
+bool GetErrorCategoryIdsOnly();
+
+// Returns the error with 'error_value' in the category identified by 'category_id'.  Throws
+// CommonErrors::parsing_error if 'category_id' is unknown.
+maidsafe_error MakeErrorFromCategory(uint32_t category_id, int error_value);
+
+// As above, but identifying the category by its name, as sent by peers which predate the registry.
+maidsafe_error MakeErrorFromCategoryName(const std::string& category_name, int error_value);
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_ERROR_CATEGORIES_H_
@@ -0,0 +1,103 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_EXPECTED_H_
+#define MAIDSAFE_NFS_EXPECTED_H_
+
+#include <utility>
+
+#include "boost/optional/optional.hpp"
+#include "boost/throw_exception.hpp"
+
+#include "maidsafe/common/error.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+// Holds either the result of an operation or the error which caused it to fail.  Used to pass the
+// outcome of an op to a completion handler without an exception having to be thrown and caught.
+template<typename T, typename Error = maidsafe_error>
+class Expected {
+ public:
+  explicit Expected(T value) : value_(std::move(value)), error_() {}
+  explicit Expected(Error error) : value_(), error_(std::move(error)) {}
+
+  bool has_value() const { return static_cast<bool>(value_); }
+  explicit operator bool() const { return has_value(); }
+  // Throws the error if there is no value.
+  T& value();
+  const T& value() const;
+  // Must only be called if there is no value.
+  const Error& error() const { return *error_; }
+  T& operator*() { return *value_; }
+  const T& operator*() const { return *value_; }
+  T* operator->() { return &*value_; }
+  const T* operator->() const { return &*value_; }
+
+ private:
+  boost::optional<T> value_;
+  boost::optional<Error> error_;
+};
+
+template<typename Error>
+class Expected<void, Error> {
+ public:
+  Expected() : error_() {}
+  explicit Expected(Error error) : error_(std::move(error)) {}
+
+  bool has_value() const { return !error_; }
+  explicit operator bool() const { return has_value(); }
+  // Throws the error if there is one.
+  void value() const;
+  // Must only be called if there is no value.
+  const Error& error() const { return *error_; }
+
+ private:
+  boost::optional<Error> error_;
+};
+
+
+
+// ==================== Implementation =============================================================
+template<typename T, typename Error>
+T& Expected<T, Error>::value() {
+  if (!value_)
+    boost::throw_exception(*error_);
+  return *value_;
+}
+
+template<typename T, typename Error>
+const T& Expected<T, Error>::value() const {
+  if (!value_)
+    boost::throw_exception(*error_);
+  return *value_;
+}
+
+template<typename Error>
+void Expected<void, Error>::value() const {
+  if (error_)
+    boost::throw_exception(*error_);
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_EXPECTED_H_
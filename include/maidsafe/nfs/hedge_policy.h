@@ -0,0 +1,83 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_HEDGE_POLICY_H_
+#define MAIDSAFE_NFS_HEDGE_POLICY_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+// Decides when, and how often, a slow request is re-sent as a "hedge".  A hedge is a copy of the
+// request with a new message ID, attached to the same op, so the op is resolved by whichever
+// attempt completes first; see PendingOps::ScheduleHedges.  Hedges are limited both per op and,
+// via the budget, as a proportion of all requests covered by the policy.
+class HedgePolicy {
+ public:
+  struct Config {
+    Config();
+    // Hedging is disabled if this is 0.
+    int max_hedges;
+    // A request is hedged once it has been outstanding for the lower of 'delay_fraction' of its
+    // timeout and the 'latency_percentile' estimate of its latency (if there is one).
+    double delay_fraction, latency_percentile;
+    // The maximum number of hedges as a percentage of requests.
+    double budget_percent;
+  };
+
+  struct Stats {
+    Stats() : requests(0), hedges(0), hedges_over_budget(0), hedge_wins(0) {}
+    uint64_t requests, hedges, hedges_over_budget, hedge_wins;
+  };
+
+  HedgePolicy();
+  explicit HedgePolicy(const Config& config);
+
+  bool enabled() const { return kConfig_.max_hedges > 0; }
+  int max_hedges() const { return kConfig_.max_hedges; }
+  double latency_percentile() const { return kConfig_.latency_percentile; }
+  // 'latency_estimate' should be empty if there's no estimate available.
+  std::chrono::steady_clock::duration Delay(
+      const std::chrono::steady_clock::duration& timeout,
+      const std::chrono::steady_clock::duration& latency_estimate) const;
+
+  void AddRequest() { ++requests_; }
+  // Returns false, and counts the refusal, if a further hedge would exceed the budget.
+  bool TryAddHedge();
+  void AddHedgeWin() { ++hedge_wins_; }
+  Stats stats() const;
+
+ private:
+  HedgePolicy(const HedgePolicy&);
+  HedgePolicy(HedgePolicy&&);
+  HedgePolicy& operator=(HedgePolicy);
+
+  const Config kConfig_;
+  std::atomic<uint64_t> requests_, hedges_, hedges_over_budget_, hedge_wins_;
+};
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_HEDGE_POLICY_H_
@@ -0,0 +1,123 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_LATENCY_ESTIMATOR_H_
+#define MAIDSAFE_NFS_LATENCY_ESTIMATOR_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+#include "maidsafe/common/error.h"
+
+#include "maidsafe/nfs/types.h"
+#include "maidsafe/nfs/utils.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+// Passed as the timeout of a client operation to have the client choose the deadline; see
+// LatencyEstimator::Timeout.  It's negative so that an explicit zero timeout is still honoured.
+const std::chrono::steady_clock::duration kUnspecifiedTimeout(
+    std::chrono::steady_clock::duration(-1));
+
+// Keeps a streaming estimate of the latency distribution of each type of request, keyed by the
+// request's action and destination persona.  Latencies are counted in a histogram of half-octave
+// buckets whose counts are halved periodically, so that the estimate follows recent behaviour.  If
+// adaptive timeouts are enabled, an unspecified timeout is replaced by a high percentile of the
+// estimate plus a margin, clamped to a sane range.
+class LatencyEstimator {
+ public:
+  struct Config {
+    Config();
+    // The percentile of observed latencies used as the base of the adaptive timeout.
+    double percentile;
+    std::chrono::steady_clock::duration margin, min_timeout, max_timeout;
+    // Used in place of an unspecified timeout when adaptive timeouts are disabled, or when fewer
+    // than 'min_samples' latencies have been observed.  Mustn't be negative.
+    std::chrono::steady_clock::duration default_timeout;
+    uint32_t min_samples;
+  };
+
+  LatencyEstimator();
+  explicit LatencyEstimator(const Config& config);
+
+  void AddSample(MessageAction action, Persona destination_persona,
+                 const std::chrono::steady_clock::duration& latency);
+  // Records the latency of an op started at 'start_time' if 'result' is a success.  A timeout is
+  // recorded as a censored sample at the time it fired, since the true latency was at least that;
+  // otherwise the estimate could never grow past a timeout it had set too low.  Other failures
+  // aren't recorded, since they don't reflect the time taken to retrieve the data.
+  template<typename ResponseContents>
+  void AddResult(MessageAction action, Persona destination_persona,
+                 const std::chrono::steady_clock::time_point& start_time,
+                 const ResponseContents& result);
+  // Returns 'timeout' unless it's kUnspecifiedTimeout.
+  std::chrono::steady_clock::duration Timeout(
+      MessageAction action, Persona destination_persona,
+      const std::chrono::steady_clock::duration& timeout = kUnspecifiedTimeout) const;
+  // Returns an empty duration if fewer than 'min_samples' latencies have been observed.
+  std::chrono::steady_clock::duration Percentile(MessageAction action,
+                                                 Persona destination_persona,
+                                                 double percentile) const;
+
+  void set_adaptive(bool adaptive) { adaptive_ = adaptive; }
+  bool adaptive() const { return adaptive_; }
+
+ private:
+  LatencyEstimator(const LatencyEstimator&);
+  LatencyEstimator(LatencyEstimator&&);
+  LatencyEstimator& operator=(LatencyEstimator);
+
+  // Bucket i counts latencies up to 2^(i/2) ms, and the last bucket counts everything above.
+  static const int kBucketCount = 36;
+  struct Histogram {
+    Histogram() : counts(), total(0) { counts.fill(0); }
+    std::array<uint32_t, kBucketCount> counts;
+    uint32_t total;
+  };
+
+  const Config kConfig_;
+  std::atomic<bool> adaptive_;
+  mutable std::mutex mutex_;
+  std::map<std::pair<MessageAction, Persona>, Histogram> histograms_;
+};
+
+
+
+// ==================== Implementation =============================================================
+template<typename ResponseContents>
+void LatencyEstimator::AddResult(MessageAction action, Persona destination_persona,
+                                 const std::chrono::steady_clock::time_point& start_time,
+                                 const ResponseContents& result) {
+  if (IsSuccess(result) || ErrorCode(result) == make_error_code(NfsErrors::timed_out))
+    AddSample(action, destination_persona, std::chrono::steady_clock::now() - start_time);
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_LATENCY_ESTIMATOR_H_
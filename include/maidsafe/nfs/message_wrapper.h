@@ -19,13 +19,26 @@
 #ifndef MAIDSAFE_NFS_MESSAGE_WRAPPER_H_
 #define MAIDSAFE_NFS_MESSAGE_WRAPPER_H_
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "boost/optional/optional.hpp"
+#include "boost/utility/string_ref.hpp"
+
+#include "maidsafe/common/config.h"
 #include "maidsafe/common/tagged_value.h"
 
+#include "maidsafe/nfs/codec_arena.h"
+#include "maidsafe/nfs/payload_compression.h"
 #include "maidsafe/nfs/types.h"
 
 
@@ -44,8 +57,154 @@ typedef TaggedValue<Persona, struct detail::DestinationTag> DestinationTaggedVal
 
 
 
+// The fifth element is a view of the serialised contents within the buffer which was passed to
+// ParseMessageWrapper, so that buffer must outlive the tuple and any copies of it.  The final
+// element is the encoding of those contents, which are compressed unless it's kNone.
 typedef std::tuple<MessageAction, detail::SourceTaggedValue, detail::DestinationTaggedValue,
-                   MessageId, std::string> TypeErasedMessageWrapper;
+                   MessageId, boost::string_ref, PayloadEncoding> TypeErasedMessageWrapper;
+
+// Encodes and decodes 'ContentsType' directly to and from its protobuf wire format, without
+// building protobuf messages or serialising nested fields into intermediate strings.  Bulk content
+// is copied once only, directly into the outbound buffer or out of the inbound one.  The encoding
+// is byte-for-byte that of the type's protobuf-based Serialise().  Each specialisation is declared
+// in the same header as its type, so that HasDirectCodec gives the same answer wherever the type is
+// complete, and provides:
+//   static std::size_t Size(const ContentsType& contents);  // the exact encoded size
+//   static void AppendTo(const ContentsType& contents, std::string& buffer);
+//   static ContentsType Parse(const boost::string_ref& serialised_contents);
+template<typename ContentsType>
+struct DirectCodec {};
+
+namespace detail {
+
+template<typename ContentsType, typename Enable = void>
+struct HasDirectCodec : std::false_type {};
+
+template<typename ContentsType>
+struct HasDirectCodec<ContentsType,
+                      decltype(static_cast<void>(&DirectCodec<ContentsType>::Parse))>
+    : std::true_type {};
+
+// Uses DirectCodec<ContentsType> if there is one and the codec mode is kDirect, otherwise the
+// type's protobuf-based Serialise() and std::string c'tor.
+template<typename ContentsType, bool = HasDirectCodec<ContentsType>::value>
+struct ContentsCodec {
+  static bool Direct() { return GetCodecMode() == CodecMode::kDirect; }
+  static std::size_t Size(const ContentsType& contents) {
+    return DirectCodec<ContentsType>::Size(contents);
+  }
+  static void AppendTo(const ContentsType& contents, std::string& buffer) {
+    DirectCodec<ContentsType>::AppendTo(contents, buffer);
+  }
+  static ContentsType Parse(const boost::string_ref& serialised_contents) {
+    return Direct() ? DirectCodec<ContentsType>::Parse(serialised_contents)
+                    : ContentsType(serialised_contents.to_string());
+  }
+};
+
+template<typename ContentsType>
+struct ContentsCodec<ContentsType, false> {
+  static bool Direct() { return false; }
+  static std::size_t Size(const ContentsType& /*contents*/) { return 0; }
+  static void AppendTo(const ContentsType& /*contents*/, std::string& /*buffer*/) {}
+  static ContentsType Parse(const boost::string_ref& serialised_contents) {
+    return ContentsType(serialised_contents.to_string());
+  }
+};
+
+}  // namespace detail
+
+// Parses 'ContentsType' from a view of its serialised form; see DirectCodec.
+template<typename ContentsType>
+ContentsType ParseContents(const boost::string_ref& serialised_contents) {
+  return detail::ContentsCodec<ContentsType>::Parse(serialised_contents);
+}
+
+// Serialises 'ContentsType' for MessageWrapper::Serialise.  'size' returns the exact number of
+// bytes which 'AppendTo' appends.  With a direct codec, nothing is encoded until 'AppendTo', so the
+// serialiser mustn't outlive the contents it was constructed from.
+template<typename ContentsType>
+class ContentsSerialiser {
+ public:
+  explicit ContentsSerialiser(const ContentsType& contents)
+      : contents_(contents),
+        direct_(detail::ContentsCodec<ContentsType>::Direct()),
+        serialised_(direct_ ? std::string() : contents.Serialise()),
+        size_(direct_ ? detail::ContentsCodec<ContentsType>::Size(contents) : serialised_.size()) {}
+  const ContentsType& contents() const { return contents_; }
+  std::size_t size() const { return size_; }
+  void AppendTo(std::string& buffer) const {
+    if (direct_)
+      detail::ContentsCodec<ContentsType>::AppendTo(contents_, buffer);
+    else
+      buffer.append(serialised_);
+  }
+
+ private:
+  ContentsSerialiser(const ContentsSerialiser&);
+  ContentsSerialiser(ContentsSerialiser&&);
+  ContentsSerialiser& operator=(ContentsSerialiser);
+
+  const ContentsType& contents_;
+  const bool direct_;
+  const std::string serialised_;
+  const std::size_t size_;
+};
+
+// Holds a MessageWrapper's contents, which copies of the wrapper share as they would a
+// std::shared_ptr.  Contents parsed from an inbound message are held as a view of their serialised
+// form, and only decoded when first dereferenced.  Decoding happens exactly once, even if several
+// threads dereference concurrently, so a handler which only needs the message's header never pays
+// for parsing its contents.  Any error parsing the contents is thrown from that first dereference.
+// The view refers to the buffer which was passed to ParseMessageWrapper, so copying or moving an
+// undecoded LazyContents decodes it first; only the original can refer to that buffer.  Compressed
+// contents are decompressed as part of decoding.
+template<typename ContentsType>
+class LazyContents {
+ public:
+  LazyContents() : state_() {}
+  explicit LazyContents(ContentsType contents)
+      : state_(std::make_shared<State>(std::move(contents))) {}
+  explicit LazyContents(const boost::string_ref& serialised_contents,
+                        PayloadEncoding encoding = PayloadEncoding::kNone)
+      : state_(std::make_shared<State>(serialised_contents, encoding)) {}
+  LazyContents(const LazyContents& other) : state_((other.Decode(), other.state_)) {}
+  LazyContents(LazyContents&& other) : state_((other.Decode(), std::move(other.state_))) {}
+  LazyContents& operator=(LazyContents other) {
+    swap(*this, other);
+    return *this;
+  }
+
+  ContentsType& operator*() const { return *Decode(); }
+  ContentsType* operator->() const { return Decode(); }
+  ContentsType* get() const { return Decode(); }
+  explicit operator bool() const { return static_cast<bool>(state_); }
+  bool decoded() const { return !state_ || state_->decoded; }
+  void reset() { state_.reset(); }
+
+  friend void swap(LazyContents& lhs, LazyContents& rhs) MAIDSAFE_NOEXCEPT {
+    using std::swap;
+    swap(lhs.state_, rhs.state_);
+  }
+
+ private:
+  struct State {
+    explicit State(ContentsType contents_in)
+        : mutex(), serialised(), encoding(PayloadEncoding::kNone),
+          contents(std::move(contents_in)), decoded(true) {}
+    State(const boost::string_ref& serialised_in, PayloadEncoding encoding_in)
+        : mutex(), serialised(serialised_in), encoding(encoding_in), contents(), decoded(false) {}
+    std::mutex mutex;
+    boost::string_ref serialised;
+    PayloadEncoding encoding;
+    boost::optional<ContentsType> contents;
+    std::atomic<bool> decoded;
+  };
+
+  ContentsType* Decode() const;
+
+  std::shared_ptr<State> state_;
+};
 
 template<MessageAction action,
          typename SourcePersonaType,
@@ -64,18 +223,24 @@ struct MessageWrapper {
 
   // For use with new messages (a new message_id is automatically applied).
   explicit MessageWrapper(const ContentsType& contents_in);
+  explicit MessageWrapper(ContentsType&& contents_in);
 
   // For use with new messages.
   MessageWrapper(MessageId message_id_in, const ContentsType& contents_in);
+  MessageWrapper(MessageId message_id_in, ContentsType&& contents_in);
 
-  // For use when handling incoming messages where the sender has already set the message_id.
+  // For use when handling incoming messages where the sender has already set the message_id.  The
+  // contents are decoded lazily; see LazyContents.
   explicit MessageWrapper(const TypeErasedMessageWrapper& parsed_message_wrapper);
 
   MessageWrapper(const MessageWrapper& other);
   MessageWrapper(MessageWrapper&& other);
   MessageWrapper& operator=(MessageWrapper other);
 
-  std::string Serialise() const;
+  std::string Serialise() const&;
+  // As above, but also releases 'contents', so that if this was the last reference to them, their
+  // content is freed as soon as it has been copied into the returned buffer.
+  std::string Serialise() &&;
 
   friend void swap(MessageWrapper& lhs, MessageWrapper& rhs) {
     using std::swap;
@@ -84,7 +249,7 @@ struct MessageWrapper {
   }
 
   MessageId message_id;
-  std::shared_ptr<ContentsType> contents;
+  LazyContents<ContentsType> contents;
 
  private:
   static const detail::SourceTaggedValue kSourceTaggedValue;
@@ -117,16 +282,170 @@ bool operator==(const MessageWrapper<action,
     return *lhs.contents == *rhs.contents;
   return true;
 }
+// Only the header is parsed here; the returned tuple holds a view of the serialised contents rather
+// than a copy of them.  A MessageWrapper constructed from the tuple parses its contents directly
+// from 'serialised_message_wrapper' when they're first dereferenced, so that string must outlive
+// the MessageWrapper unless it has been copied or moved (which decodes the contents).
 TypeErasedMessageWrapper ParseMessageWrapper(const std::string& serialised_message_wrapper);
+// Disallowed, since the returned tuple would refer to the destroyed temporary.
+TypeErasedMessageWrapper ParseMessageWrapper(std::string&& serialised_message_wrapper) = delete;
 
 
 
 // ==================== Implementation =============================================================
+template<typename ContentsType>
+ContentsType* LazyContents<ContentsType>::Decode() const {
+  if (!state_)
+    return nullptr;
+  if (!state_->decoded.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!state_->decoded.load(std::memory_order_relaxed)) {
+      CodecArena codec_arena;
+      if (state_->encoding == PayloadEncoding::kNone) {
+        state_->contents = ParseContents<ContentsType>(state_->serialised);
+      } else {
+        state_->contents = ParseContents<ContentsType>(
+            detail::DecompressPayload(state_->encoding, state_->serialised));
+      }
+      state_->serialised.clear();
+      state_->decoded.store(true, std::memory_order_release);
+    }
+  }
+  return &*state_->contents;
+}
+
 namespace detail {
 
 MessageId GetNewMessageId();
 
-std::string SerialiseMessageWrapper(const TypeErasedMessageWrapper& message_tuple);
+// Returns a buffer holding the header fields, with capacity reserved for the 'contents_size' bytes
+// of serialised contents which are to be appended to it.  'payload_encoding' is only written to the
+// header if it isn't kNone.
+std::string SerialiseMessageWrapperHeader(
+    MessageAction action,
+    Persona source_persona,
+    Persona destination_persona,
+    MessageId message_id,
+    std::size_t contents_size,
+    PayloadEncoding payload_encoding = PayloadEncoding::kNone);
+
+// Writes the header fields and the serialised contents into a single buffer in one pass.  The
+// output is identical to the protobuf::MessageWrapper encoding, so it is parsed as before by
+// ParseMessageWrapper, but 'serialised_contents' is copied into the output once rather than via
+// the tuple, the protobuf field and SerializeAsString.
+std::string SerialiseMessageWrapper(MessageAction action,
+                                    Persona source_persona,
+                                    Persona destination_persona,
+                                    MessageId message_id,
+                                    const std::string& serialised_contents,
+                                    PayloadEncoding payload_encoding = PayloadEncoding::kNone);
+
+// Returns the compressed contents from 'serialiser' and sets 'payload_encoding' if they're of a
+// compressible type, the compression policy allows, and they compress well enough.  The bulk
+// content is probed before the contents are serialised into a temporary buffer for compression, so
+// content which is already compressed or encrypted isn't copied.
+template<typename ContentsType, bool = IsCompressiblePayload<ContentsType>::value>
+struct ContentsCompressor {
+  static boost::optional<std::string> Compress(
+      const ContentsSerialiser<ContentsType>& /*serialiser*/,
+      PayloadEncoding& /*payload_encoding*/) {
+    return boost::none;
+  }
+};
+
+template<typename ContentsType>
+struct ContentsCompressor<ContentsType, true> {
+  static boost::optional<std::string> Compress(const ContentsSerialiser<ContentsType>& serialiser,
+                                               PayloadEncoding& payload_encoding) {
+    if (!CompressionWanted(serialiser.size()) ||
+        !ContentLooksCompressible(
+            IsCompressiblePayload<ContentsType>::Content(serialiser.contents()))) {
+      return boost::none;
+    }
+    std::string serialised_contents;
+    serialised_contents.reserve(serialiser.size());
+    serialiser.AppendTo(serialised_contents);
+    return CompressPayload(serialised_contents, payload_encoding);
+  }
+};
+
+// Serialises the header and the contents from 'serialiser', compressed if ContentsCompressor
+// allows, or otherwise directly into the returned buffer.
+template<typename ContentsType>
+std::string SerialiseMessageWrapper(MessageAction action,
+                                    Persona source_persona,
+                                    Persona destination_persona,
+                                    MessageId message_id,
+                                    const ContentsSerialiser<ContentsType>& serialiser) {
+  PayloadEncoding payload_encoding(PayloadEncoding::kNone);
+  auto compressed_contents(
+      ContentsCompressor<ContentsType>::Compress(serialiser, payload_encoding));
+  if (compressed_contents) {
+    return SerialiseMessageWrapper(action, source_persona, destination_persona, message_id,
+                                   *compressed_contents, payload_encoding);
+  }
+  auto serialised_message_wrapper(SerialiseMessageWrapperHeader(
+      action, source_persona, destination_persona, message_id, serialiser.size()));
+  serialiser.AppendTo(serialised_message_wrapper);
+  return serialised_message_wrapper;
+}
+
+// Returns a view of the length-delimited (bytes) field 'field_number' within the protobuf-encoded
+// 'serialised_message', or an uninitialised optional if the field is absent.  Throws
+// CommonErrors::parsing_error if 'serialised_message' is malformed.
+boost::optional<boost::string_ref> GetBytesField(const boost::string_ref& serialised_message,
+                                                 int field_number);
+
+// Helpers for ContentsSerialiser specialisations, matching the protobuf encoding of a
+// length-delimited (bytes) field.  'BytesFieldSize' is the total size of the field for a value of
+// 'value_size' bytes, and 'AppendBytesFieldHeader' appends just its tag and length prefix, so that
+// the value can then be appended in place.
+std::size_t BytesFieldSize(int field_number, std::size_t value_size);
+void AppendBytesFieldHeader(int field_number, std::size_t value_size, std::string& buffer);
+void AppendBytesField(int field_number, const boost::string_ref& value, std::string& buffer);
+
+// As above, for a varint field.  Negative int32 and int64 values must be passed sign-extended to
+// 64 bits (i.e. static_cast<uint64_t>(static_cast<int64_t>(value))), as protobuf encodes them.
+std::size_t VarintFieldSize(int field_number, uint64_t value);
+void AppendVarintField(int field_number, uint64_t value, std::string& buffer);
+
+// The top-level fields of a protobuf-encoded message, read in a single pass without copying any of
+// it.  As with protobuf, the last occurrence of a singular field wins.  Fields numbered above
+// kMaxFieldNumber, and fields of other wire types, are skipped.  The c'tor throws
+// CommonErrors::parsing_error if 'serialised_message' is malformed, and so do 'bytes' and 'varint'
+// if the requested field is absent.
+class MessageFields {
+ public:
+  static const int kMaxFieldNumber = 7;
+
+  explicit MessageFields(const boost::string_ref& serialised_message);
+
+  bool has_bytes(int field_number) const { return static_cast<bool>(bytes_[field_number]); }
+  bool has_varint(int field_number) const { return static_cast<bool>(varints_[field_number]); }
+  boost::string_ref bytes(int field_number) const;
+  uint64_t varint(int field_number) const;
+
+ private:
+  std::array<boost::optional<boost::string_ref>, kMaxFieldNumber + 1> bytes_;
+  std::array<boost::optional<uint64_t>, kMaxFieldNumber + 1> varints_;
+};
+
+// Returns views of every occurrence of the repeated bytes field 'field_number', in order.
+std::vector<boost::string_ref> GetRepeatedBytesField(const boost::string_ref& serialised_message,
+                                                     int field_number);
+
+// For DirectCodec specialisations: the size of, and appending, 'value' encoded by its own
+// DirectCodec as the bytes field 'field_number'.
+template<typename ValueType>
+std::size_t NestedFieldSize(int field_number, const ValueType& value) {
+  return BytesFieldSize(field_number, DirectCodec<ValueType>::Size(value));
+}
+
+template<typename ValueType>
+void AppendNestedField(int field_number, const ValueType& value, std::string& buffer) {
+  AppendBytesFieldHeader(field_number, DirectCodec<ValueType>::Size(value), buffer);
+  DirectCodec<ValueType>::AppendTo(value, buffer);
+}
 
 }  // namespace detail
 
@@ -186,7 +505,22 @@ MessageWrapper<action,
                RoutingReceiverType,
                ContentsType>::MessageWrapper(const ContentsType& contents_in)
     : message_id(detail::GetNewMessageId()),
-      contents(std::make_shared<ContentsType>(contents_in)) {}
+      contents(contents_in) {}
+
+template<MessageAction action,
+         typename SourcePersonaType,
+         typename RoutingSenderType,
+         typename DestinationPersonaType,
+         typename RoutingReceiverType,
+         typename ContentsType>
+MessageWrapper<action,
+               SourcePersonaType,
+               RoutingSenderType,
+               DestinationPersonaType,
+               RoutingReceiverType,
+               ContentsType>::MessageWrapper(ContentsType&& contents_in)
+    : message_id(detail::GetNewMessageId()),
+      contents(std::move(contents_in)) {}
 
 template <MessageAction action, typename SourcePersonaType,
           typename RoutingSenderType, typename DestinationPersonaType,
@@ -196,7 +530,22 @@ MessageWrapper<action, SourcePersonaType, RoutingSenderType,
                ContentsType>::MessageWrapper(MessageId message_id_in,
                                              const ContentsType& contents_in)
     : message_id(std::move(message_id_in)),
-      contents(std::make_shared<ContentsType>(contents_in)) {}
+      contents(contents_in) {}
+
+template<MessageAction action,
+         typename SourcePersonaType,
+         typename RoutingSenderType,
+         typename DestinationPersonaType,
+         typename RoutingReceiverType,
+         typename ContentsType>
+MessageWrapper<action,
+               SourcePersonaType,
+               RoutingSenderType,
+               DestinationPersonaType,
+               RoutingReceiverType,
+               ContentsType>::MessageWrapper(MessageId message_id_in, ContentsType&& contents_in)
+    : message_id(std::move(message_id_in)),
+      contents(std::move(contents_in)) {}
 
 template<MessageAction action,
          typename SourcePersonaType,
@@ -211,7 +560,7 @@ MessageWrapper<action,
                RoutingReceiverType,
                ContentsType>::MessageWrapper(const TypeErasedMessageWrapper& parsed_message_wrapper)
     : message_id(std::get<3>(parsed_message_wrapper)),
-      contents(std::make_shared<ContentsType>(std::get<4>(parsed_message_wrapper))) {}
+      contents(std::get<4>(parsed_message_wrapper), std::get<5>(parsed_message_wrapper)) {}
 
 template<MessageAction action,
          typename SourcePersonaType,
@@ -275,9 +624,31 @@ std::string MessageWrapper<action,
                            RoutingSenderType,
                            DestinationPersonaType,
                            RoutingReceiverType,
-                           ContentsType>::Serialise() const {
-  return detail::SerialiseMessageWrapper(std::make_tuple(action, kSourceTaggedValue,
-      kDestinationTaggedValue, message_id, contents->Serialise()));
+                           ContentsType>::Serialise() const& {
+  CodecArena codec_arena;
+  ContentsSerialiser<ContentsType> serialiser(*contents);
+  return detail::SerialiseMessageWrapper(action, kSourceTaggedValue.data,
+                                         kDestinationTaggedValue.data, message_id, serialiser);
+}
+
+template<MessageAction action,
+         typename SourcePersonaType,
+         typename RoutingSenderType,
+         typename DestinationPersonaType,
+         typename RoutingReceiverType,
+         typename ContentsType>
+std::string MessageWrapper<action,
+                           SourcePersonaType,
+                           RoutingSenderType,
+                           DestinationPersonaType,
+                           RoutingReceiverType,
+                           ContentsType>::Serialise() && {
+  CodecArena codec_arena;
+  ContentsSerialiser<ContentsType> serialiser(*contents);
+  auto serialised_message_wrapper(detail::SerialiseMessageWrapper(
+      action, kSourceTaggedValue.data, kDestinationTaggedValue.data, message_id, serialiser));
+  contents.reset();
+  return serialised_message_wrapper;
 }
 
 }  // namespace nfs
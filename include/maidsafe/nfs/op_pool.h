@@ -0,0 +1,177 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_OP_POOL_H_
+#define MAIDSAFE_NFS_OP_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "maidsafe/nfs/utils.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace detail { class OpSlabs; }
+
+// A pool of fixed-size blocks for the state of in-flight ops, carved out of slab chunks of
+// 'blocks_per_chunk' blocks.  A block is recycled as soon as the op using it is destroyed, so in
+// the steady state creating an op doesn't touch the heap.  Requests larger than 'block_size' fall
+// back to the heap.  Thread-safe.  The chunks are kept alive by any PoolAllocator referring to
+// them, so the pool may be destroyed before the ops allocated from it.
+class OpPool {
+ public:
+  struct Stats {
+    Stats() : chunks(0), blocks_in_use(0), heap_allocations(0) {}
+    uint64_t chunks, blocks_in_use, heap_allocations;
+  };
+
+  static const std::size_t kDefaultBlockSize = 512;
+  static const std::size_t kDefaultBlocksPerChunk = 64;
+
+  explicit OpPool(std::size_t block_size = kDefaultBlockSize,
+                  std::size_t blocks_per_chunk = kDefaultBlocksPerChunk);
+  Stats stats() const;
+
+ private:
+  OpPool(const OpPool&);
+  OpPool(OpPool&&);
+  OpPool& operator=(OpPool);
+
+  template<typename T>
+  friend class PoolAllocator;
+
+  std::shared_ptr<detail::OpSlabs> slabs_;
+};
+
+namespace detail {
+
+class OpSlabs {
+ public:
+  OpSlabs(std::size_t block_size, std::size_t blocks_per_chunk);
+  ~OpSlabs();
+  // Return nullptr if 'size' is larger than a block.
+  void* Allocate(std::size_t size);
+  void Free(void* block);
+  std::size_t block_size() const { return kBlockSize_; }
+  void AddHeapAllocation();
+  OpPool::Stats stats() const;
+
+ private:
+  OpSlabs(const OpSlabs&);
+  OpSlabs(OpSlabs&&);
+  OpSlabs& operator=(OpSlabs);
+
+  struct FreeBlock { FreeBlock* next; };
+  struct Impl;
+
+  const std::size_t kBlockSize_;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace detail
+
+// Standard allocator over an OpPool, for use with std::allocate_shared.
+template<typename T>
+class PoolAllocator {
+ public:
+  typedef T value_type;
+
+  explicit PoolAllocator(const OpPool& pool) : slabs_(pool.slabs_) {}
+  template<typename U>
+  PoolAllocator(const PoolAllocator<U>& other) : slabs_(other.slabs_) {}  // NOLINT
+
+  T* allocate(std::size_t count);
+  void deallocate(T* pointer, std::size_t count);
+
+  template<typename U>
+  bool operator==(const PoolAllocator<U>& other) const { return slabs_ == other.slabs_; }
+  template<typename U>
+  bool operator!=(const PoolAllocator<U>& other) const { return slabs_ != other.slabs_; }
+
+ private:
+  template<typename U>
+  friend class PoolAllocator;
+
+  std::shared_ptr<detail::OpSlabs> slabs_;
+};
+
+// An OpData together with the callback it invokes, so that both live in a single block.  The
+// OpData's own std::function only holds a pointer back to this object, so it never allocates.
+template<typename ResponseContents, typename Callback>
+class CallbackOp {
+ public:
+  CallbackOp(int successes_required, Callback callback)
+      : op_data(successes_required,
+                [this](ResponseContents response) { callback_(std::move(response)); }),
+        callback_(std::move(callback)) {}
+
+  OpData<ResponseContents> op_data;
+
+ private:
+  CallbackOp(const CallbackOp&);
+  CallbackOp(CallbackOp&&);
+  CallbackOp& operator=(CallbackOp);
+
+  Callback callback_;
+};
+
+// Creates an OpData which invokes 'callback' once resolved, allocated from 'pool'.  The returned
+// pointer shares ownership of the whole CallbackOp.
+template<typename ResponseContents, typename Callback>
+std::shared_ptr<OpData<ResponseContents>> MakeOpData(const OpPool& pool, int successes_required,
+                                                     Callback callback);
+
+
+
+// ==================== Implementation =============================================================
+template<typename T>
+T* PoolAllocator<T>::allocate(std::size_t count) {
+  if (void* block = slabs_->Allocate(count * sizeof(T)))
+    return static_cast<T*>(block);
+  slabs_->AddHeapAllocation();
+  return static_cast<T*>(::operator new(count * sizeof(T)));
+}
+
+template<typename T>
+void PoolAllocator<T>::deallocate(T* pointer, std::size_t count) {
+  if (count * sizeof(T) <= slabs_->block_size())
+    slabs_->Free(pointer);
+  else
+    ::operator delete(pointer);
+}
+
+template<typename ResponseContents, typename Callback>
+std::shared_ptr<OpData<ResponseContents>> MakeOpData(const OpPool& pool, int successes_required,
+                                                     Callback callback) {
+  typedef CallbackOp<ResponseContents, Callback> Op;
+  auto op(std::allocate_shared<Op>(PoolAllocator<Op>(pool), successes_required,
+                                   std::move(callback)));
+  return std::shared_ptr<OpData<ResponseContents>>(op, &op->op_data);
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_OP_POOL_H_
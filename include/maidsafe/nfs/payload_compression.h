@@ -0,0 +1,99 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_PAYLOAD_COMPRESSION_H_
+#define MAIDSAFE_NFS_PAYLOAD_COMPRESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "boost/optional/optional.hpp"
+#include "boost/utility/string_ref.hpp"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+// How a MessageWrapper's serialised contents are encoded on the wire.  kNone is never sent: the
+// header's payload_encoding field is simply omitted, so uncompressed messages are unchanged from
+// those of peers which predate compression.  kLz4 is only available if this library was built with
+// lz4 (MAIDSAFE_NFS_LZ4 defined).
+enum class PayloadEncoding : int32_t { kNone = 0, kZlib = 1, kLz4 = 2 };
+
+bool PayloadEncodingAvailable(PayloadEncoding encoding);
+
+// Whether compression may be applied to messages carrying 'ContentsType'.  Specialised for the
+// types which carry chunk content, whose specialisations also provide
+//   static boost::string_ref Content(const ContentsType& contents);
+// returning a view of that content, which is probed before the contents are serialised for
+// compression.
+template<typename ContentsType>
+struct IsCompressiblePayload : std::false_type {};
+
+// Governs which outbound payloads are compressed.  Inbound compressed payloads are always
+// decompressed, whatever the policy, so compression is negotiated network-wide: it stays disabled
+// (the default) until every peer runs a version which can decode it, and is then enabled on all.
+struct CompressionPolicy {
+  CompressionPolicy();
+
+  bool enabled;
+  // kZlib by default, since every build can decode it.  kLz4 must only be chosen once every peer
+  // is known to have been built with lz4; it falls back to kZlib if unavailable here.
+  PayloadEncoding encoding;
+  // Payloads smaller than this are never compressed.
+  std::size_t min_size;
+  // The compressed payload is only sent if it's at most this fraction of the original size.
+  double max_compressed_ratio;
+  // The zlib compression level: 1 (fastest) to 9 (smallest).
+  int zlib_level;
+};
+
+void SetCompressionPolicy(const CompressionPolicy& policy);
+CompressionPolicy GetCompressionPolicy();
+
+namespace detail {
+
+// Whether the current policy allows compressing a payload of 'payload_size' bytes.  This is cheap,
+// so is checked before serialising contents into a temporary buffer for compression.
+bool CompressionWanted(std::size_t payload_size);
+
+// Whether 'content' (the bulk of a payload) might compress well enough to be worth compressing the
+// payload.  Large content is probed by compressing a sample from its middle, so that content which
+// is already compressed or encrypted is rejected before its payload is serialised for compression.
+bool ContentLooksCompressible(const boost::string_ref& content);
+
+// Returns the compressed form of 'payload' and sets 'encoding', or returns an uninitialised
+// optional if the payload doesn't compress well enough.
+boost::optional<std::string> CompressPayload(const boost::string_ref& payload,
+                                             PayloadEncoding& encoding);
+
+// Throws CommonErrors::parsing_error if 'compressed_payload' is malformed or 'encoding' is unknown
+// or unavailable.
+std::string DecompressPayload(PayloadEncoding encoding,
+                              const boost::string_ref& compressed_payload);
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_PAYLOAD_COMPRESSION_H_
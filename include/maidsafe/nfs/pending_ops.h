@@ -0,0 +1,500 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_PENDING_OPS_H_
+#define MAIDSAFE_NFS_PENDING_OPS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/timer.h"
+
+#include "maidsafe/nfs/hedge_policy.h"
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/types.h"
+#include "maidsafe/nfs/utils.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+// Index of the ops awaiting responses, keyed by the message ID of their request.  Responses are
+// correlated with their op via an open-addressed hash table, and passed straight to the op's
+// OpData.  An op is retired as soon as its OpData resolves, or when it times out, after which any
+// further responses with its message ID are ignored.  The timer is only used for timeouts and
+// hedges.
+template<typename ResponseContents>
+class PendingOps {
+ public:
+  explicit PendingOps(AsioService& asio_service);
+
+  // Allocates a new message ID for the op and registers 'op_data' against it.  If 'op_data' hasn't
+  // resolved within 'timeout', it is resolved via OpData::HandleTimeout.  'request_key' optionally
+  // identifies what was requested; see 'AddResponseFor'.
+  MessageId Add(std::shared_ptr<OpData<ResponseContents>> op_data,
+                const std::chrono::steady_clock::duration& timeout,
+                std::string request_key = std::string());
+  // As 'Add', but registers a single timer task for the whole batch, which is cancelled once all of
+  // the batch's ops have resolved.  The returned message IDs are in the same order as 'op_datas'.
+  // 'request_keys' must be empty or the same size as 'op_datas'.
+  std::vector<MessageId> AddBatch(
+      const std::vector<std::shared_ptr<OpData<ResponseContents>>>& op_datas,
+      const std::chrono::steady_clock::duration& timeout,
+      const std::vector<std::string>& request_keys = std::vector<std::string>());
+  bool Contains(MessageId message_id) const;
+  void AddResponse(MessageId message_id, ResponseContents response);
+  // For responses from sources which aren't otherwise trusted to answer the request.  The response
+  // is ignored unless the op was added with the same non-empty 'request_key'.
+  void AddResponseFor(const std::string& request_key, MessageId message_id,
+                      ResponseContents response);
+  // Retires the op for 'message_id' along with its hedges, resolving it via OpData::HandleTimeout
+  // with 'response' unless it has already resolved.  For ops whose request couldn't be sent.
+  void Cancel(MessageId message_id, ResponseContents response);
+  // Each time 'delay' elapses with the op for 'message_id' still pending, up to the policy's
+  // maximum, registers a hedge (a new message ID attached to the same OpData and request key) and
+  // passes its ID to 'send_hedge'.  The op still times out at its original deadline, and once it
+  // resolves via any of its message IDs, all of them are retired and any hedge not yet sent is
+  // cancelled.  'hedge_policy' must outlive
+  // this object.
+  void ScheduleHedges(MessageId message_id, const std::chrono::steady_clock::duration& delay,
+                      HedgePolicy& hedge_policy, std::function<void(MessageId)> send_hedge);
+
+ private:
+  PendingOps(const PendingOps&);
+  PendingOps(PendingOps&&);
+  PendingOps& operator=(PendingOps);
+
+  // The timeout task of an op, or of a batch of ops, which is cancelled once none of its ops are
+  // pending.  Guarded by 'mutex_'.
+  struct TimeoutTask {
+    explicit TimeoutTask(std::size_t op_count)
+        : task_id(0), added(false), pending_op_count(op_count) {}
+    routing::TaskId task_id;
+    bool added;
+    std::size_t pending_op_count;
+  };
+
+  struct Entry {
+    enum State { kEmpty, kOccupied, kErased };
+    Entry() : state(kEmpty), message_id(0), timeout_task(), request_key(), op_data(),
+              next_attempt_id(0), hedge_count(0), hedge_task_id(), hedge_policy(nullptr) {}
+    State state;
+    int64_t message_id;
+    // Only set in the original request's entry.
+    std::shared_ptr<TimeoutTask> timeout_task;
+    std::string request_key;
+    std::shared_ptr<OpData<ResponseContents>> op_data;
+    // The attempts (the original request and its hedges) of a single op form a ring via this, or
+    // it's 0 if the op has never been hedged.
+    int64_t next_attempt_id;
+    // Only used in the original request's entry.
+    int hedge_count;
+    // The timer task of the next hedge, if one is scheduled.  Only used in the original request's
+    // entry.
+    boost::optional<routing::TaskId> hedge_task_id;
+    // Only set for hedges.
+    HedgePolicy* hedge_policy;
+  };
+
+  // The following seven functions must be called with 'mutex_' held.  'Find' returns the index of
+  // the entry for 'message_id', or 'entries_.size()' if there isn't one.  'EraseAttempts' erases
+  // the entry at 'index' along with any other attempts of the same op, returning them all, and
+  // counts the op as no longer pending against its timeout task.  'TasksToCancel' returns the
+  // IDs of the retired op's scheduled hedge task and, if 'include_timeout_task' is true and the op
+  // was the last pending one of its timeout task, that task.
+  std::size_t Find(int64_t message_id) const;
+  void Insert(int64_t message_id, std::shared_ptr<OpData<ResponseContents>> op_data,
+              std::string request_key, std::shared_ptr<TimeoutTask> timeout_task);
+  void Reinsert(Entry&& entry);
+  Entry Erase(std::size_t index);
+  std::vector<Entry> EraseAttempts(std::size_t index);
+  std::vector<routing::TaskId> TasksToCancel(const std::vector<Entry>& retired,
+                                             bool include_timeout_task) const;
+  void Rehash(std::size_t capacity);
+
+  // Records the ID of the newly-added 'timeout_task', cancelling it if its ops have all resolved
+  // meanwhile.
+  void SetTimeoutTaskId(const std::shared_ptr<TimeoutTask>& timeout_task, routing::TaskId task_id);
+
+  void DoAddResponse(MessageId message_id, ResponseContents response,
+                     const std::string* request_key);
+  void HandleTimeout(MessageId message_id, ResponseContents timeout_response);
+  void CancelTasks(const std::vector<routing::TaskId>& task_ids);
+  void Hedge(MessageId message_id, routing::TaskId task_id,
+             const std::chrono::steady_clock::duration& delay, HedgePolicy& hedge_policy,
+             std::function<void(MessageId)> send_hedge);
+
+  static const std::size_t kInitialCapacity = 64;
+
+  mutable std::mutex mutex_;
+  std::vector<Entry> entries_;
+  std::size_t occupied_count_, erased_count_;
+  // Declared last so that it's destroyed first, since its tasks refer to this object.
+  routing::Timer<ResponseContents> timer_;
+};
+
+
+
+// ==================== Implementation =============================================================
+template<typename ResponseContents>
+PendingOps<ResponseContents>::PendingOps(AsioService& asio_service)
+    : mutex_(),
+      entries_(kInitialCapacity),
+      occupied_count_(0),
+      erased_count_(0),
+      timer_(asio_service) {}
+
+template<typename ResponseContents>
+MessageId PendingOps<ResponseContents>::Add(std::shared_ptr<OpData<ResponseContents>> op_data,
+                                            const std::chrono::steady_clock::duration& timeout,
+                                            std::string request_key) {
+  const MessageId message_id(detail::GetNewMessageId());
+  auto timeout_task(std::make_shared<TimeoutTask>(1));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Insert(message_id.data, std::move(op_data), std::move(request_key), timeout_task);
+  }
+  // The timer task is added without holding 'mutex_', since its functor takes 'mutex_'.
+  SetTimeoutTaskId(timeout_task, timer_.AddTask(
+      timeout,
+      [this, message_id](ResponseContents timeout_response) {
+          HandleTimeout(message_id, std::move(timeout_response));
+      },
+      1));
+  return message_id;
+}
+
+template<typename ResponseContents>
+std::vector<MessageId> PendingOps<ResponseContents>::AddBatch(
+    const std::vector<std::shared_ptr<OpData<ResponseContents>>>& op_datas,
+    const std::chrono::steady_clock::duration& timeout,
+    const std::vector<std::string>& request_keys) {
+  if (!request_keys.empty() && request_keys.size() != op_datas.size())
+    ThrowError(CommonErrors::invalid_parameter);
+  std::vector<MessageId> message_ids;
+  message_ids.reserve(op_datas.size());
+  for (std::size_t i(0); i != op_datas.size(); ++i)
+    message_ids.push_back(detail::GetNewMessageId());
+  auto timeout_task(std::make_shared<TimeoutTask>(op_datas.size()));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i(0); i != op_datas.size(); ++i)
+      Insert(message_ids[i].data, op_datas[i],
+             request_keys.empty() ? std::string() : request_keys[i], timeout_task);
+  }
+  auto batch_message_ids(std::make_shared<std::vector<MessageId>>(message_ids));
+  SetTimeoutTaskId(timeout_task, timer_.AddTask(
+      timeout,
+      [this, batch_message_ids](ResponseContents timeout_response) {
+          for (const auto& message_id : *batch_message_ids)
+            HandleTimeout(message_id, timeout_response);
+      },
+      1));
+  return message_ids;
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::SetTimeoutTaskId(
+    const std::shared_ptr<TimeoutTask>& timeout_task, routing::TaskId task_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_task->task_id = task_id;
+    timeout_task->added = true;
+    if (timeout_task->pending_op_count != 0)
+      return;
+  }
+  timer_.CancelTask(task_id);
+}
+
+template<typename ResponseContents>
+bool PendingOps<ResponseContents>::Contains(MessageId message_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return Find(message_id.data) != entries_.size();
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::AddResponse(MessageId message_id, ResponseContents response) {
+  DoAddResponse(message_id, std::move(response), nullptr);
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::AddResponseFor(const std::string& request_key,
+                                                  MessageId message_id,
+                                                  ResponseContents response) {
+  if (!request_key.empty())
+    DoAddResponse(message_id, std::move(response), &request_key);
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::DoAddResponse(MessageId message_id, ResponseContents response,
+                                                 const std::string* request_key) {
+  std::shared_ptr<OpData<ResponseContents>> op_data;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t index(Find(message_id.data));
+    if (index == entries_.size())
+      return;
+    if (request_key && *request_key != entries_[index].request_key)
+      return;
+    op_data = entries_[index].op_data;
+  }
+  if (!op_data->HandleResponseContents(std::move(response)))
+    return;
+
+  std::vector<routing::TaskId> tasks_to_cancel;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t index(Find(message_id.data));
+    if (index == entries_.size())
+      return;
+    if (entries_[index].hedge_policy)
+      entries_[index].hedge_policy->AddHedgeWin();
+    tasks_to_cancel = TasksToCancel(EraseAttempts(index), true);
+  }
+  CancelTasks(tasks_to_cancel);
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::Cancel(MessageId message_id, ResponseContents response) {
+  std::vector<Entry> retired;
+  std::vector<routing::TaskId> tasks_to_cancel;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t index(Find(message_id.data));
+    if (index == entries_.size())
+      return;
+    retired = EraseAttempts(index);
+    tasks_to_cancel = TasksToCancel(retired, true);
+  }
+  CancelTasks(tasks_to_cancel);
+  retired.front().op_data->HandleTimeout(std::move(response));
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::HandleTimeout(MessageId message_id,
+                                                 ResponseContents timeout_response) {
+  // This is only called by the op's own timeout task, which mustn't be cancelled from within its
+  // functor, so the task isn't cancelled even if this was its last pending op.
+  std::vector<Entry> retired;
+  std::vector<routing::TaskId> tasks_to_cancel;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t index(Find(message_id.data));
+    if (index == entries_.size())
+      return;
+    retired = EraseAttempts(index);
+    tasks_to_cancel = TasksToCancel(retired, false);
+  }
+  CancelTasks(tasks_to_cancel);
+  retired.front().op_data->HandleTimeout(std::move(timeout_response));
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::ScheduleHedges(
+    MessageId message_id, const std::chrono::steady_clock::duration& delay,
+    HedgePolicy& hedge_policy, std::function<void(MessageId)> send_hedge) {
+  if (!hedge_policy.enabled())
+    return;
+  // The task's ID is recorded in the op's entry before the task is added, so that the op can cancel
+  // it on retiring.  If the op retires in between, the task is cancelled here instead.
+  const routing::TaskId task_id(timer_.NewTaskId());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t index(Find(message_id.data));
+    if (index == entries_.size())
+      return;
+    entries_[index].hedge_task_id = task_id;
+  }
+  timer_.AddTask(
+      delay,
+      [this, message_id, task_id, delay, &hedge_policy, send_hedge](ResponseContents) {
+          Hedge(message_id, task_id, delay, hedge_policy, send_hedge);
+      },
+      1, task_id);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Find(message_id.data) != entries_.size())
+      return;
+  }
+  timer_.CancelTask(task_id);
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::CancelTasks(const std::vector<routing::TaskId>& task_ids) {
+  for (const auto& task_id : task_ids)
+    timer_.CancelTask(task_id);
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::Hedge(MessageId message_id, routing::TaskId task_id,
+                                         const std::chrono::steady_clock::duration& delay,
+                                         HedgePolicy& hedge_policy,
+                                         std::function<void(MessageId)> send_hedge) {
+  const MessageId hedge_id(detail::GetNewMessageId());
+  bool more_hedges_allowed(false);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t index(Find(message_id.data));
+    if (index == entries_.size())
+      return;
+    if (entries_[index].hedge_task_id == task_id)
+      entries_[index].hedge_task_id = boost::none;
+    if (entries_[index].hedge_count >= hedge_policy.max_hedges() || !hedge_policy.TryAddHedge())
+      return;
+    Entry& original(entries_[index]);
+    Entry hedge;
+    hedge.message_id = hedge_id.data;
+    hedge.request_key = original.request_key;
+    hedge.op_data = original.op_data;
+    hedge.next_attempt_id = original.next_attempt_id ? original.next_attempt_id : message_id.data;
+    hedge.hedge_policy = &hedge_policy;
+    original.next_attempt_id = hedge_id.data;
+    more_hedges_allowed = ++original.hedge_count < hedge_policy.max_hedges();
+    // 'original' may be invalidated by this.
+    Reinsert(std::move(hedge));
+  }
+  send_hedge(hedge_id);
+  if (more_hedges_allowed)
+    ScheduleHedges(message_id, delay, hedge_policy, send_hedge);
+}
+
+namespace detail {
+
+// Spreads the sequential low bits of message IDs across the table.
+inline std::size_t MessageIdHash(int64_t message_id) {
+  uint64_t hash(static_cast<uint64_t>(message_id) * 0x9e3779b97f4a7c15ULL);
+  return static_cast<std::size_t>(hash ^ (hash >> 32));
+}
+
+}  // namespace detail
+
+template<typename ResponseContents>
+std::size_t PendingOps<ResponseContents>::Find(int64_t message_id) const {
+  const std::size_t mask(entries_.size() - 1);
+  for (std::size_t index(detail::MessageIdHash(message_id) & mask); ; index = (index + 1) & mask) {
+    const Entry& entry(entries_[index]);
+    if (entry.state == Entry::kEmpty)
+      return entries_.size();
+    if (entry.state == Entry::kOccupied && entry.message_id == message_id)
+      return index;
+  }
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::Insert(int64_t message_id,
+                                          std::shared_ptr<OpData<ResponseContents>> op_data,
+                                          std::string request_key,
+                                          std::shared_ptr<TimeoutTask> timeout_task) {
+  Entry entry;
+  entry.message_id = message_id;
+  entry.timeout_task = std::move(timeout_task);
+  entry.request_key = std::move(request_key);
+  entry.op_data = std::move(op_data);
+  Reinsert(std::move(entry));
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::Reinsert(Entry&& entry) {
+  // Keep at least half the entries empty so that probe sequences stay short.
+  if ((occupied_count_ + erased_count_ + 1) * 2 > entries_.size())
+    Rehash((occupied_count_ + 1) * 4 > entries_.size() ? entries_.size() * 2 : entries_.size());
+  const std::size_t mask(entries_.size() - 1);
+  std::size_t index(detail::MessageIdHash(entry.message_id) & mask);
+  while (entries_[index].state == Entry::kOccupied)
+    index = (index + 1) & mask;
+  if (entries_[index].state == Entry::kErased)
+    --erased_count_;
+  entry.state = Entry::kOccupied;
+  entries_[index] = std::move(entry);
+  ++occupied_count_;
+}
+
+template<typename ResponseContents>
+typename PendingOps<ResponseContents>::Entry PendingOps<ResponseContents>::Erase(
+    std::size_t index) {
+  Entry erased;
+  std::swap(erased, entries_[index]);
+  entries_[index].state = Entry::kErased;
+  --occupied_count_;
+  ++erased_count_;
+  return erased;
+}
+
+template<typename ResponseContents>
+std::vector<typename PendingOps<ResponseContents>::Entry>
+    PendingOps<ResponseContents>::EraseAttempts(std::size_t index) {
+  std::vector<Entry> erased(1, Erase(index));
+  const int64_t first_id(erased.front().message_id);
+  int64_t next_id(erased.front().next_attempt_id);
+  while (next_id != 0 && next_id != first_id) {
+    index = Find(next_id);
+    if (index == entries_.size())
+      break;
+    erased.push_back(Erase(index));
+    next_id = erased.back().next_attempt_id;
+  }
+  for (const auto& entry : erased) {
+    if (entry.timeout_task)
+      --entry.timeout_task->pending_op_count;
+  }
+  return erased;
+}
+
+template<typename ResponseContents>
+std::vector<routing::TaskId> PendingOps<ResponseContents>::TasksToCancel(
+    const std::vector<Entry>& retired, bool include_timeout_task) const {
+  std::vector<routing::TaskId> task_ids;
+  for (const auto& entry : retired) {
+    if (entry.hedge_task_id)
+      task_ids.push_back(*entry.hedge_task_id);
+    if (include_timeout_task && entry.timeout_task && entry.timeout_task->added &&
+        entry.timeout_task->pending_op_count == 0) {
+      task_ids.push_back(entry.timeout_task->task_id);
+    }
+  }
+  return task_ids;
+}
+
+template<typename ResponseContents>
+void PendingOps<ResponseContents>::Rehash(std::size_t capacity) {
+  std::vector<Entry> old_entries(capacity);
+  old_entries.swap(entries_);
+  occupied_count_ = 0;
+  erased_count_ = 0;
+  for (auto& entry : old_entries) {
+    if (entry.state == Entry::kOccupied)
+      Reinsert(std::move(entry));
+  }
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_PENDING_OPS_H_
@@ -20,13 +20,16 @@
 #define MAIDSAFE_NFS_SERVICE_H_
 
 #include <memory>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include "boost/variant/static_visitor.hpp"
 #include "boost/variant/variant.hpp"
 
 #include "maidsafe/routing/api_config.h"
 
+#include "maidsafe/nfs/message_dispatch.h"
 #include "maidsafe/nfs/message_types.h"
 #include "maidsafe/nfs/message_wrapper.h"
 #include "maidsafe/nfs/types.h"
@@ -75,6 +78,64 @@ class PersonaDemuxer : public boost::static_visitor<> {
   const Receiver& receiver_;
 };
 
+// Detects whether 'PersonaService' provides 'bool IsLive(const TypeErasedMessageWrapper&) const'.
+// If so, Service calls it with the parsed header before any contents are parsed, and silently drops
+// the message if it returns false, e.g. a response to an op which has already resolved.
+template<typename PersonaService>
+class HasLiveMessageFilter {
+  template<typename T>
+  static auto Check(int) -> decltype(
+      std::declval<const T&>().IsLive(std::declval<const TypeErasedMessageWrapper&>()),
+      std::true_type());
+  template<typename T>
+  static std::false_type Check(...);
+
+ public:
+  typedef decltype(Check<PersonaService>(0)) type;
+};
+
+// Parses the type-erased message as 'Message' and passes it to the persona service if the sender
+// and receiver types match those of 'Message'.
+template<typename PersonaService, typename Sender, typename Receiver, typename Message,
+         bool IsHandled = std::is_same<Sender, typename Message::Sender>::value &&
+                          std::is_same<Receiver, typename Message::Receiver>::value>
+struct TypedMessageHandler {
+  static void Handle(PersonaService& persona_service, const TypeErasedMessageWrapper& message,
+                     const Sender& sender, const Receiver& receiver) {
+    persona_service.HandleMessage(Message(message), sender, receiver);
+  }
+};
+
+template<typename PersonaService, typename Sender, typename Receiver, typename Message>
+struct TypedMessageHandler<PersonaService, Sender, Receiver, Message, false> {
+  static void Handle(PersonaService& /*persona_service*/,
+                     const TypeErasedMessageWrapper& /*message*/,
+                     const Sender& /*sender*/,
+                     const Receiver& /*receiver*/) {
+    // The message's declared sender or receiver type doesn't match the routing types it arrived
+    // with, so this is a malformed message.
+    ThrowError(CommonErrors::invalid_parameter);
+  }
+};
+
+// One handler per message type in a DispatchTable's 'Messages' tuple, in the same order, so that
+// DispatchTable::Index can be used directly to select the handler.
+template<typename PersonaService, typename Sender, typename Receiver, typename Messages>
+struct MessageHandlers;
+
+template<typename PersonaService, typename Sender, typename Receiver, typename... Messages>
+struct MessageHandlers<PersonaService, Sender, Receiver, std::tuple<Messages...>> {
+  typedef void (*Handler)(PersonaService&, const TypeErasedMessageWrapper&, const Sender&,
+                          const Receiver&);
+  static const Handler kHandlers[sizeof...(Messages)];
+};
+
+template<typename PersonaService, typename Sender, typename Receiver, typename... Messages>
+const typename MessageHandlers<PersonaService, Sender, Receiver, std::tuple<Messages...>>::Handler
+    MessageHandlers<PersonaService, Sender, Receiver, std::tuple<Messages...>>::kHandlers[
+        sizeof...(Messages)] = {
+            &TypedMessageHandler<PersonaService, Sender, Receiver, Messages>::Handle... };
+
 }  // namespace detail
 
 
@@ -96,11 +157,12 @@ class Service {
   void HandleMessage(const nfs::TypeErasedMessageWrapper& message,
                      const Sender& sender,
                      const Receiver& receiver) {
-    const detail::PersonaDemuxer<PersonaService, Sender, Receiver> demuxer(*impl_, sender,
-                                                                           receiver);
+    if (!IsLive(message, typename detail::HasLiveMessageFilter<PersonaService>::type()))
+      return;
     static std::is_void<PublicMessages> public_messages_void_state;
     static std::is_void<VaultMessages> vault_messages_void_state;
-    if (!HandleMessage(message, demuxer, public_messages_void_state, vault_messages_void_state)) {
+    if (!HandleMessage(message, sender, receiver, public_messages_void_state,
+                       vault_messages_void_state)) {
       LOG(kError) << "Invalid request.";
       ThrowError(CommonErrors::invalid_parameter);
     }
@@ -111,50 +173,76 @@ class Service {
  private:
   typedef std::true_type IsVoid;
   typedef std::false_type IsNotVoid;
+  typedef std::true_type HasFilter;
+  typedef std::false_type HasNoFilter;
+
+  bool IsLive(const nfs::TypeErasedMessageWrapper& message, HasFilter) const {
+    return impl_->IsLive(message);
+  }
 
-  template<typename Demuxer>
-  bool HandlePublicMessage(const nfs::TypeErasedMessageWrapper& message, const Demuxer& demuxer) {
-    PublicMessages public_variant_message;
-    if (!nfs::GetVariant(message, public_variant_message))
+  bool IsLive(const nfs::TypeErasedMessageWrapper& /*message*/, HasNoFilter) const {
+    return true;
+  }
+
+  // Public messages are all declared in this project's meta files, so are dispatched via the
+  // generated table rather than by parsing into a variant and visiting it.
+  template<typename Sender, typename Receiver>
+  bool HandlePublicMessage(const nfs::TypeErasedMessageWrapper& message,
+                           const Sender& sender,
+                           const Receiver& receiver) {
+    typedef DispatchTable<PublicMessages> Table;
+    if (std::get<2>(message).data != Table::kDestinationPersona)
       return false;
-    boost::apply_visitor(demuxer, public_variant_message);
+    int index(Table::Index(std::get<0>(message), std::get<1>(message).data));
+    if (index < 0)
+      return false;
+    detail::MessageHandlers<PersonaService, Sender, Receiver, typename Table::Messages>::
+        kHandlers[index](*impl_, message, sender, receiver);
     return true;
   }
 
-  template<typename Demuxer>
-  bool HandleVaultMessage(const nfs::TypeErasedMessageWrapper& message, const Demuxer& demuxer) {
+  template<typename Sender, typename Receiver>
+  bool HandleVaultMessage(const nfs::TypeErasedMessageWrapper& message,
+                          const Sender& sender,
+                          const Receiver& receiver) {
     VaultMessages vault_variant_message;
     if (vault::GetVariant(message, vault_variant_message))
       return false;
+    const detail::PersonaDemuxer<PersonaService, Sender, Receiver> demuxer(*impl_, sender,
+                                                                           receiver);
     boost::apply_visitor(demuxer, vault_variant_message);
     return true;
   }
 
   // Public messages only are non-void.
-  template<typename Demuxer>
+  template<typename Sender, typename Receiver>
   bool HandleMessage(const nfs::TypeErasedMessageWrapper& message,
-                     const Demuxer& demuxer,
+                     const Sender& sender,
+                     const Receiver& receiver,
                      IsNotVoid,
                      IsVoid) {
-    return HandlePublicMessage(message, demuxer);
+    return HandlePublicMessage(message, sender, receiver);
   }
 
   // Vault messages only are non-void.
-  template<typename Demuxer>
+  template<typename Sender, typename Receiver>
   bool HandleMessage(const nfs::TypeErasedMessageWrapper& message,
-                     const Demuxer& demuxer,
+                     const Sender& sender,
+                     const Receiver& receiver,
                      IsVoid,
                      IsNotVoid) {
-    return HandleVaultMessage(message, demuxer);
+    return HandleVaultMessage(message, sender, receiver);
   }
 
   // Both types of message are non-void.
-  template<typename Demuxer>
+  template<typename Sender, typename Receiver>
   bool HandleMessage(const nfs::TypeErasedMessageWrapper& message,
-                     const Demuxer& demuxer,
+                     const Sender& sender,
+                     const Receiver& receiver,
                      IsNotVoid,
                      IsNotVoid) {
-    return HandlePublicMessage(message, demuxer) && HandleVaultMessage(message, demuxer);
+    return HandlePublicMessage(message, sender, receiver) ||
+           HandleVaultMessage(message, sender, receiver);
   }
 
   std::unique_ptr<PersonaService> impl_;
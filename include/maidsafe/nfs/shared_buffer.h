@@ -0,0 +1,68 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_SHARED_BUFFER_H_
+#define MAIDSAFE_NFS_SHARED_BUFFER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/types.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+// An immutable, reference-counted buffer holding the content of a chunk.  Copies share the same
+// bytes, so a chunk's content is allocated once when it is parsed or serialised and can then be
+// passed between messages, responses and the data cache without being duplicated.
+class SharedBuffer {
+ public:
+  SharedBuffer();
+  explicit SharedBuffer(NonEmptyString content);
+  SharedBuffer(const SharedBuffer& other);
+  SharedBuffer(SharedBuffer&& other);
+  SharedBuffer& operator=(SharedBuffer other);
+
+  bool IsInitialised() const { return static_cast<bool>(content_); }
+  // These throw if the buffer is uninitialised.
+  const NonEmptyString& non_empty_string() const;
+  const std::string& string() const { return non_empty_string().string(); }
+  std::size_t size() const { return content_ ? content_->string().size() : 0; }
+  // The number of SharedBuffers sharing these bytes.
+  long use_count() const { return content_.use_count(); }  // NOLINT
+
+  friend bool operator==(const SharedBuffer& lhs, const SharedBuffer& rhs);
+  friend void swap(SharedBuffer& lhs, SharedBuffer& rhs) MAIDSAFE_NOEXCEPT;
+
+ private:
+  std::shared_ptr<const NonEmptyString> content_;
+};
+
+bool operator==(const SharedBuffer& lhs, const SharedBuffer& rhs);
+bool operator!=(const SharedBuffer& lhs, const SharedBuffer& rhs);
+void swap(SharedBuffer& lhs, SharedBuffer& rhs) MAIDSAFE_NOEXCEPT;
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_SHARED_BUFFER_H_
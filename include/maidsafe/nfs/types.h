@@ -99,7 +99,7 @@ template<Persona PersonaType>
 struct PersonaTypes;
 
 namespace detail { struct MessageIdTag; }
-typedef TaggedValue<int32_t, detail::MessageIdTag> MessageId;
+typedef TaggedValue<int64_t, detail::MessageIdTag> MessageId;
 
 }  // namespace nfs
 
@@ -19,10 +19,14 @@
 #ifndef MAIDSAFE_NFS_UTILS_H_
 #define MAIDSAFE_NFS_UTILS_H_
 
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
-#include <mutex>
+#include <thread>
 #include <utility>
 #include <system_error>
 #include <vector>
@@ -61,22 +65,58 @@ std::pair<typename std::vector<MessageContents>::const_iterator, bool>
     GetSuccessOrMostFrequentResponse(const std::vector<MessageContents>& responses,
                                      int successes_required);
 
+// Accumulates responses for a single operation until either 'successes_required' successful
+// responses have been received, or routing::Parameters::node_group_size responses have been
+// received in total.  In the latter case the callback is invoked with a response carrying the most
+// frequent error code (on a tie, the error code which was first received).
+//
+// Responses may be handled concurrently from several threads without locking: successes and
+// failures are tallied incrementally via atomic counters, and the callback is claimed by a single
+// CAS.  Successful responses are never stored, and only the first response for each distinct error
+// code is kept as that code's candidate result.
 template<typename MessageContents>
 class OpData {
  public:
   OpData(int successes_required, std::function<void(MessageContents)> callback);
-  void HandleResponseContents(MessageContents&& response_contents);
+  // Returns true if this call resolved the operation, i.e. it invoked the callback.
+  bool HandleResponseContents(MessageContents&& response_contents);
+  // Resolves the operation if it hasn't already been resolved, using the most frequent failure
+  // received so far, or 'timeout_response' if there haven't been any.  Returns true if this call
+  // resolved the operation.
+  bool HandleTimeout(MessageContents&& timeout_response);
 
  private:
   OpData(const OpData&);
   OpData(OpData&&);
   OpData& operator=(OpData);
 
-  mutable std::mutex mutex_;
-  int successes_required_;
+  struct FailureTally {
+    enum State : int32_t { kEmpty, kClaimed, kPublished };
+    FailureTally() : state(kEmpty), count(0), error_code(), candidate() {}
+    std::atomic<int32_t> state;
+    std::atomic<int> count;
+    std::error_code error_code;
+    std::unique_ptr<MessageContents> candidate;
+  };
+
+  void AddFailure(MessageContents&& response_contents);
+  bool ClaimCallback();
+  // Returns nullptr if no failures have been tallied.
+  FailureTally* MostFrequentFailure() const;
+
+  // Enough for the usual group sizes, so that constructing an OpData needn't allocate.
+  static const int kInlineFailureCount = 8;
+
+  const int successes_required_, total_required_;
   std::function<void(MessageContents)> callback_;
-  std::vector<MessageContents> responses_;
-  bool callback_executed_;
+  std::atomic<int> successes_, total_;
+  std::atomic<bool> callback_claimed_;
+  // One entry per distinct error code, filled in order of arrival.  There can be at most
+  // 'total_required_' distinct codes before the callback is invoked.  'failures_' points to
+  // 'inline_failures_' unless that's too small, in which case it points to 'heap_failures_'.
+  std::array<FailureTally, kInlineFailureCount> inline_failures_;
+  std::unique_ptr<FailureTally[]> heap_failures_;
+  FailureTally* failures_;
 };
 
 
@@ -106,36 +146,103 @@ std::pair<typename std::vector<MessageContents>::const_iterator, bool>
 template<typename MessageContents>
 OpData<MessageContents>::OpData(int successes_required,
                                 std::function<void(MessageContents)> callback)
-    : mutex_(),
-      successes_required_(successes_required),
+    : successes_required_(successes_required),
+      total_required_(routing::Parameters::node_group_size),
       callback_(callback),
-      responses_(),
-      callback_executed_(!callback) {
-  if (!callback || successes_required <= 0)
+      successes_(0),
+      total_(0),
+      callback_claimed_(false),
+      inline_failures_(),
+      heap_failures_(total_required_ > kInlineFailureCount ?
+                     new FailureTally[total_required_] : nullptr),
+      failures_(heap_failures_ ? heap_failures_.get() : inline_failures_.data()) {
+  if (!callback || successes_required <= 0 || successes_required > total_required_)
     ThrowError(CommonErrors::invalid_parameter);
 }
 
 template<typename MessageContents>
-void OpData<MessageContents>::HandleResponseContents(MessageContents&& response_contents) {
-  std::function<void(MessageContents)> callback;
-  std::unique_ptr<MessageContents> result_ptr;
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (callback_executed_)
+bool OpData<MessageContents>::HandleResponseContents(MessageContents&& response_contents) {
+  if (callback_claimed_.load())
+    return false;
+
+  if (IsSuccess(response_contents)) {
+    if (++successes_ >= successes_required_) {
+      if (!ClaimCallback())
+        return false;
+      callback_(std::move(response_contents));
+      return true;
+    }
+  } else {
+    AddFailure(std::move(response_contents));
+  }
+
+  // The tally for this response is complete before 'total_' is incremented, so whichever thread
+  // brings 'total_' up to the required count sees every earlier tally.
+  // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
+  if (++total_ != total_required_ || !ClaimCallback())
+    return false;
+  FailureTally* most_frequent(MostFrequentFailure());
+  // Only null if every response was a success and 'successes_required_' wasn't met, which the
+  // constructor prevents.
+  assert(most_frequent);
+  callback_(std::move(*most_frequent->candidate));
+  return true;
+}
+
+template<typename MessageContents>
+bool OpData<MessageContents>::HandleTimeout(MessageContents&& timeout_response) {
+  if (!ClaimCallback())
+    return false;
+  FailureTally* most_frequent(MostFrequentFailure());
+  callback_(most_frequent ? std::move(*most_frequent->candidate) : std::move(timeout_response));
+  return true;
+}
+
+template<typename MessageContents>
+void OpData<MessageContents>::AddFailure(MessageContents&& response_contents) {
+  const std::error_code error_code(ErrorCode(response_contents));
+  for (int i(0); i != total_required_; ++i) {
+    FailureTally& tally(failures_[i]);
+    int32_t state(FailureTally::kEmpty);
+    if (tally.state.compare_exchange_strong(state, FailureTally::kClaimed)) {
+      tally.error_code = error_code;
+      tally.candidate.reset(new MessageContents(std::move(response_contents)));
+      ++tally.count;
+      tally.state.store(FailureTally::kPublished);
       return;
-    responses_.push_back(std::move(response_contents));
-    auto result(GetSuccessOrMostFrequentResponse(responses_, successes_required_));
-    // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-    if (result.second || responses_.size() == routing::Parameters::node_group_size) {
-      // Operation has succeeded or failed overall
-      callback = callback_;
-      callback_executed_ = true;
-      result_ptr = std::unique_ptr<MessageContents>(new MessageContents(*result.first));
-    } else {
+    }
+    // Another thread is filling this entry; it only has to copy the error code and candidate.
+    while (state == FailureTally::kClaimed) {
+      std::this_thread::yield();
+      state = tally.state.load();
+    }
+    if (tally.error_code == error_code) {
+      ++tally.count;
       return;
     }
   }
-  callback(*result_ptr);
+  // All entries are taken, so more than 'total_required_' responses have arrived and this one can
+  // be dropped.
+}
+
+template<typename MessageContents>
+bool OpData<MessageContents>::ClaimCallback() {
+  bool claimed(false);
+  return callback_claimed_.compare_exchange_strong(claimed, true);
+}
+
+template<typename MessageContents>
+typename OpData<MessageContents>::FailureTally* OpData<MessageContents>::MostFrequentFailure()
+    const {
+  FailureTally* most_frequent(nullptr);
+  for (int i(0); i != total_required_; ++i) {
+    FailureTally& tally(failures_[i]);
+    if (tally.state.load() != FailureTally::kPublished)
+      break;
+    if (!most_frequent || tally.count.load() > most_frequent->count.load())
+      most_frequent = &tally;
+  }
+  return most_frequent;
 }
 
 }  // namespace nfs
@@ -19,13 +19,20 @@
 #ifndef MAIDSAFE_NFS_VAULT_MESSAGES_H_
 #define MAIDSAFE_NFS_VAULT_MESSAGES_H_
 
+#include <cstddef>
 #include <string>
+#include <type_traits>
+
+#include "boost/utility/string_ref.hpp"
 
 #include "maidsafe/common/config.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/data_types/data_type_values.h"
 #include "maidsafe/data_types/structured_data_versions.h"
 
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/payload_compression.h"
+#include "maidsafe/nfs/shared_buffer.h"
 #include "maidsafe/nfs/vault/pmid_registration.h"
 
 
@@ -108,6 +115,8 @@ struct DataNameAndContent {
 
   DataNameAndContent(DataTagValue type_in, const Identity& name_in,
                      NonEmptyString content_in);
+  DataNameAndContent(DataTagValue type_in, const Identity& name_in,
+                     nfs::SharedBuffer content_in);
 
   DataNameAndContent();
   DataNameAndContent(const DataNameAndContent& other);
@@ -118,7 +127,8 @@ struct DataNameAndContent {
   std::string Serialise() const;
 
   DataName name;
-  NonEmptyString content;
+  // Shared rather than copied by copies of this object and of the messages containing it.
+  nfs::SharedBuffer content;
 };
 
 bool operator==(const DataNameAndContent& lhs, const DataNameAndContent& rhs);
@@ -156,6 +166,8 @@ struct DataAndPmidHint {
   DataAndPmidHint();
   DataAndPmidHint(const DataName& data_name, const NonEmptyString& content,
                   Identity pmid_node_hint);
+  DataAndPmidHint(const DataName& data_name, nfs::SharedBuffer content,
+                  Identity pmid_node_hint);
   DataAndPmidHint(const DataAndPmidHint& other);
   DataAndPmidHint(DataAndPmidHint&& other);
   DataAndPmidHint& operator=(DataAndPmidHint other);
@@ -172,6 +184,84 @@ void swap(DataAndPmidHint& lhs, DataAndPmidHint& rhs) MAIDSAFE_NOEXCEPT;
 
 }  // namespace nfs_vault
 
+
+
+namespace nfs {
+
+template<>
+struct DirectCodec<nfs_vault::Empty> {
+  typedef nfs_vault::Empty Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_vault::DataName> {
+  typedef nfs_vault::DataName Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_vault::DataNameAndVersion> {
+  typedef nfs_vault::DataNameAndVersion Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_vault::DataNameOldNewVersion> {
+  typedef nfs_vault::DataNameOldNewVersion Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_vault::DataNameAndContent> {
+  typedef nfs_vault::DataNameAndContent Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_vault::DataNameAndCost> {
+  typedef nfs_vault::DataNameAndCost Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+template<>
+struct DirectCodec<nfs_vault::DataAndPmidHint> {
+  typedef nfs_vault::DataAndPmidHint Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+// Includes the Synchronise and AccountTransfer messages, which also carry DataNameAndContent.
+template<>
+struct IsCompressiblePayload<nfs_vault::DataNameAndContent> : std::true_type {
+  static boost::string_ref Content(const nfs_vault::DataNameAndContent& contents) {
+    return contents.content.IsInitialised() ? boost::string_ref(contents.content.string())
+                                            : boost::string_ref();
+  }
+};
+
+template<>
+struct IsCompressiblePayload<nfs_vault::DataAndPmidHint> : std::true_type {
+  static boost::string_ref Content(const nfs_vault::DataAndPmidHint& contents) {
+    return IsCompressiblePayload<nfs_vault::DataNameAndContent>::Content(contents.data);
+  }
+};
+
+}  // namespace nfs
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_NFS_VAULT_MESSAGES_H_
@@ -19,13 +19,18 @@
 #ifndef MAIDSAFE_NFS_VAULT_PMID_REGISTRATION_H_
 #define MAIDSAFE_NFS_VAULT_PMID_REGISTRATION_H_
 
+#include <cstddef>
 #include <string>
 
+#include "boost/utility/string_ref.hpp"
+
 #include "maidsafe/common/config.h"
 #include "maidsafe/common/types.h"
 
 #include "maidsafe/passport/types.h"
 
+#include "maidsafe/nfs/message_wrapper.h"
+
 
 namespace maidsafe {
 
@@ -48,6 +53,7 @@ class PmidRegistration {
 
   friend bool operator==(const PmidRegistration& lhs, const PmidRegistration& rhs);
   friend void swap(PmidRegistration& lhs, PmidRegistration& rhs) MAIDSAFE_NOEXCEPT;
+  friend struct nfs::DirectCodec<PmidRegistration>;
 
  private:
   passport::PublicMaid::Name maid_name_;
@@ -62,6 +68,20 @@ void swap(PmidRegistration& lhs, PmidRegistration& rhs) MAIDSAFE_NOEXCEPT;
 
 }  // namespace nfs_vault
 
+
+
+namespace nfs {
+
+template<>
+struct DirectCodec<nfs_vault::PmidRegistration> {
+  typedef nfs_vault::PmidRegistration Contents;
+  static std::size_t Size(const Contents& contents);
+  static void AppendTo(const Contents& contents, std::string& buffer);
+  static Contents Parse(const boost::string_ref& serialised_contents);
+};
+
+}  // namespace nfs
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_NFS_VAULT_PMID_REGISTRATION_H_
@@ -23,22 +23,61 @@ namespace maidsafe {
 
 namespace nfs_client {
 
-void HandleGetVersionsOrBranchResult(const StructuredDataNameAndContentOrReturnCode& result,
-    std::shared_ptr<boost::promise<std::vector<StructuredDataVersions::VersionName>>> promise) {
+nfs::Expected<void> PutResult(const DataPmidHintAndReturnCode& result) {
+  if (nfs::IsSuccess(result))
+    return nfs::Expected<void>();
+  else if (result.return_code.value.code())
+    return nfs::Expected<void>(result.return_code.value);
+  else
+    return nfs::Expected<void>(MakeError(NfsErrors::timed_out));
+}
+
+nfs::Expected<VersionNames> GetVersionsOrBranchResult(
+    const StructuredDataNameAndContentOrReturnCode& result) {
+  if (result.structured_data)
+    return nfs::Expected<VersionNames>(result.structured_data->versions);
+  else if (result.data_name_and_return_code)
+    return nfs::Expected<VersionNames>(result.data_name_and_return_code->return_code.value);
+  else
+    return nfs::Expected<VersionNames>(MakeError(CommonErrors::uninitialised));
+}
+
+maidsafe_error CurrentError() {
   try {
-    if (result.structured_data) {
-      promise->set_value(result.structured_data->versions);
-    } else if (result.data_name_and_return_code) {
-      boost::throw_exception(result.data_name_and_return_code->return_code.value);
-    } else {
-      ThrowError(CommonErrors::uninitialised);
-    }
+    throw;
+  }
+  catch(const maidsafe_error& error) {
+    return error;
   }
   catch(...) {
-    promise->set_exception(boost::current_exception());
+    return MakeError(CommonErrors::unknown);
   }
 }
 
+DataPmidHintAndReturnCode PutFailureResponse() {
+  DataPmidHintAndReturnCode response;
+  response.return_code = ReturnCode(CurrentError());
+  return response;
+}
+
+void HandlePutResult(const DataPmidHintAndReturnCode& result,
+                     std::shared_ptr<boost::promise<void>> promise) {
+  auto outcome(PutResult(result));
+  if (outcome)
+    promise->set_value();
+  else
+    promise->set_exception(boost::copy_exception(outcome.error()));
+}
+
+void HandleGetVersionsOrBranchResult(const StructuredDataNameAndContentOrReturnCode& result,
+    std::shared_ptr<boost::promise<std::vector<StructuredDataVersions::VersionName>>> promise) {
+  auto versions(GetVersionsOrBranchResult(result));
+  if (versions)
+    promise->set_value(std::move(*versions));
+  else
+    promise->set_exception(boost::copy_exception(versions.error()));
+}
+
 }  // namespace nfs_client
 
 }  // namespace maidsafe
@@ -0,0 +1,123 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/data_cache.h"
+
+#include <functional>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace {
+
+// Approximate per-entry bookkeeping cost of the list node, index node and key.
+const uint64_t kEntryOverhead(128);
+
+}  // unnamed namespace
+
+DataCache::DataCache(const Config& config)
+    : max_bytes_(config.max_bytes),
+      max_bytes_per_shard_(config.shard_count > 0 ? config.max_bytes / config.shard_count : 0),
+      shard_count_(config.shard_count),
+      shards_() {
+  if (config.shard_count <= 0) {
+    LOG(kError) << "DataCache requires at least one shard.";
+    ThrowError(CommonErrors::invalid_parameter);
+  }
+  if (enabled())
+    shards_.reset(new Shard[shard_count_]);
+}
+
+std::string DataCache::Key(DataTagValue tag_value, const Identity& raw_name) {
+  std::string key(raw_name.string());
+  key += static_cast<char>(tag_value);
+  return key;
+}
+
+DataCache::Stats DataCache::stats() const {
+  Stats stats;
+  if (!enabled())
+    return stats;
+  for (int i(0); i != shard_count_; ++i) {
+    Shard& shard(shards_[i]);
+    stats.hits += shard.hits;
+    stats.misses += shard.misses;
+    stats.insertions += shard.insertions;
+    stats.evictions += shard.evictions;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    stats.entry_count += shard.index.size();
+    stats.bytes += shard.bytes;
+  }
+  return stats;
+}
+
+uint64_t DataCache::Cost(const Entry& entry) {
+  return entry.key.size() + entry.content.size() + kEntryOverhead;
+}
+
+DataCache::Shard& DataCache::GetShard(const std::string& key) {
+  return shards_[std::hash<std::string>()(key) % static_cast<std::size_t>(shard_count_)];
+}
+
+boost::optional<nfs::SharedBuffer> DataCache::GetContent(const std::string& key) {
+  Shard& shard(GetShard(key));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto itr(shard.index.find(key));
+  if (itr == shard.index.end()) {
+    ++shard.misses;
+    return boost::optional<nfs::SharedBuffer>();
+  }
+  ++shard.hits;
+  shard.entries.splice(shard.entries.begin(), shard.entries, itr->second);
+  return boost::optional<nfs::SharedBuffer>(itr->second->content);
+}
+
+void DataCache::PutContent(std::string key, nfs::SharedBuffer content) {
+  Shard& shard(GetShard(key));
+  Entry entry(std::move(key), std::move(content));
+  const uint64_t cost(Cost(entry));
+  if (cost > max_bytes_per_shard_)
+    return;
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto itr(shard.index.find(entry.key));
+  if (itr != shard.index.end()) {
+    // The content of an existing entry can't differ, so just mark it as recently used.
+    shard.entries.splice(shard.entries.begin(), shard.entries, itr->second);
+    return;
+  }
+  while (shard.bytes + cost > max_bytes_per_shard_) {
+    shard.bytes -= Cost(shard.entries.back());
+    shard.index.erase(shard.entries.back().key);
+    shard.entries.pop_back();
+    ++shard.evictions;
+  }
+  shard.entries.push_front(std::move(entry));
+  shard.index.insert(std::make_pair(shard.entries.front().key, shard.entries.begin()));
+  shard.bytes += cost;
+  ++shard.insertions;
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
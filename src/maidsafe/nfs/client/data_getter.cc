@@ -27,15 +27,23 @@ namespace maidsafe {
 namespace nfs_client {
 
 DataGetter::DataGetter(AsioService& asio_service, routing::Routing& routing,
-                       std::vector<passport::PublicPmid> public_pmids_from_file)
-    : get_timer_(asio_service),
-      get_versions_timer_(asio_service),
-      get_branch_timer_(asio_service),
+                       std::vector<passport::PublicPmid> public_pmids_from_file,
+                       const DataCache::Config& data_cache_config,
+                       const nfs::LatencyEstimator::Config& latency_estimator_config,
+                       const nfs::HedgePolicy::Config& get_hedge_config)
+    : data_cache_(data_cache_config),
+      in_flight_gets_(),
+      latency_estimator_(latency_estimator_config),
+      get_hedge_policy_(get_hedge_config),
+      op_pool_(),
       dispatcher_(routing),
-      service_([&]()->std::unique_ptr<DataGetterService> &&
+      get_ops_(asio_service),
+      get_versions_ops_(asio_service),
+      get_branch_ops_(asio_service),
+      service_([&]()->std::unique_ptr<DataGetterService>
 {
   std::unique_ptr<DataGetterService> service(new DataGetterService(
-      routing, get_timer_, get_versions_timer_, get_branch_timer_));
+      routing, get_ops_, get_versions_ops_, get_branch_ops_));
   return std::move(service);
 }())
 #ifdef TESTING
@@ -61,15 +69,10 @@ boost::future<passport::PublicPmid> DataGetter::Get<passport::PublicPmid>(
     typedef DataGetterService::GetResponse::Contents ResponseContents;
     auto promise(std::make_shared<boost::promise<passport::PublicPmid>>());
     HandleGetResult<passport::PublicPmid> response_functor(promise);
-    auto op_data(std::make_shared<nfs::OpData<ResponseContents>>(1, response_functor));
-    auto task_id(get_timer_.AddTask(
-        timeout,
-        [op_data](ResponseContents get_response) {
-            op_data->HandleResponseContents(std::move(get_response));
-        },
-        // TODO(Fraser#5#): 2013-08-18 - Confirm expected count
-        routing::Parameters::node_group_size * 2));
-    dispatcher_.SendGetRequest<passport::PublicPmid>(task_id, data_name);
+    auto op_data(nfs::MakeOpData<ResponseContents>(op_pool_, 1, response_functor));
+    auto message_id(get_ops_.Add(op_data, latency_estimator_.Timeout(
+        nfs::MessageAction::kGetRequest, nfs::Persona::kDataManager, timeout)));
+    dispatcher_.SendGetRequest<passport::PublicPmid>(message_id, data_name);
     return promise->get_future();
 #ifdef TESTING
   } else {
@@ -25,7 +25,12 @@ namespace nfs_client {
 
 DataGetterDispatcher::DataGetterDispatcher(routing::Routing& routing)
     : routing_(routing),
-      kThisNodeAsSender_(routing_.kNodeId()) {}
+      kThisNodeAsSender_(routing_.kNodeId())
+#ifdef TESTING
+      ,
+      send_functor_()
+#endif
+{}
 
 }  // namespace nfs_client
 
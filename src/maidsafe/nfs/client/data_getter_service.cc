@@ -25,13 +25,27 @@ namespace nfs_client {
 
 DataGetterService::DataGetterService(
     routing::Routing& routing,
-    routing::Timer<DataGetterService::GetResponse::Contents>& get_timer,
-    routing::Timer<DataGetterService::GetVersionsResponse::Contents>& get_versions_timer,
-    routing::Timer<DataGetterService::GetBranchResponse::Contents>& get_branch_timer)
+    nfs::PendingOps<DataGetterService::GetResponse::Contents>& get_ops,
+    nfs::PendingOps<DataGetterService::GetVersionsResponse::Contents>& get_versions_ops,
+    nfs::PendingOps<DataGetterService::GetBranchResponse::Contents>& get_branch_ops)
         : routing_(routing),
-          get_timer_(get_timer),
-          get_versions_timer_(get_versions_timer),
-          get_branch_timer_(get_branch_timer) {}
+          get_ops_(get_ops),
+          get_versions_ops_(get_versions_ops),
+          get_branch_ops_(get_branch_ops) {}
+
+bool DataGetterService::IsLive(const nfs::TypeErasedMessageWrapper& message) const {
+  const nfs::MessageId& message_id(std::get<3>(message));
+  switch (std::get<0>(message)) {
+    case nfs::MessageAction::kGetResponse:
+      return get_ops_.Contains(message_id);
+    case nfs::MessageAction::kGetVersionsResponse:
+      return get_versions_ops_.Contains(message_id);
+    case nfs::MessageAction::kGetBranchResponse:
+      return get_branch_ops_.Contains(message_id);
+    default:
+      return true;
+  }
+}
 
 template<>
 void DataGetterService::HandleMessage<DataGetterService::GetResponse>(
@@ -41,7 +55,7 @@ void DataGetterService::HandleMessage<DataGetterService::GetResponse>(
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
   static_cast<void>(routing_);
-  get_timer_.AddResponse(message.message_id.data, *message.contents);
+  get_ops_.AddResponse(message.message_id, *message.contents);
 }
 
 template<>
@@ -51,7 +65,7 @@ void DataGetterService::HandleMessage<DataGetterService::GetVersionsResponse>(
     const typename GetVersionsResponse::Receiver& receiver) {
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
-  get_versions_timer_.AddResponse(message.message_id.data, *message.contents);
+  get_versions_ops_.AddResponse(message.message_id, *message.contents);
 }
 
 template<>
@@ -61,7 +75,7 @@ void DataGetterService::HandleMessage<DataGetterService::GetBranchResponse>(
     const typename GetBranchResponse::Receiver& receiver) {
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
-  get_branch_timer_.AddResponse(message.message_id.data, *message.contents);
+  get_branch_ops_.AddResponse(message.message_id, *message.contents);
 }
 
 }  // namespace nfs_client
@@ -0,0 +1,66 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/in_flight_gets.h"
+
+#include <utility>
+
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+InFlightGets::InFlightGets() : mutex_(), gets_(), coalesced_count_(0) {}
+
+bool InFlightGets::Join(const std::string& key, const GetFunctor& functor) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto result(gets_.insert(std::make_pair(key, std::vector<GetFunctor>())));
+  result.first->second.push_back(functor);
+  if (result.second)
+    return false;
+  ++coalesced_count_;
+  return true;
+}
+
+void InFlightGets::Resolve(const std::string& key, const DataNameAndContentOrReturnCode& result) {
+  std::vector<GetFunctor> functors;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(gets_.find(key));
+    if (itr == gets_.end()) {
+      LOG(kWarning) << "No in-flight Get to resolve.";
+      return;
+    }
+    functors.swap(itr->second);
+    gets_.erase(itr);
+  }
+  // Invoked without holding 'mutex_', since a functor may start a new Get for the same key.
+  for (const auto& functor : functors)
+    functor(result);
+}
+
+std::size_t InFlightGets::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return gets_.size();
+}
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
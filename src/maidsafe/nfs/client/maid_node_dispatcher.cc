@@ -26,14 +26,20 @@ namespace nfs_client {
 MaidNodeDispatcher::MaidNodeDispatcher(routing::Routing& routing)
     : routing_(routing),
       kThisNodeAsSender_(routing_.kNodeId()),
-      kMaidManagerReceiver_(routing_.kNodeId()) {}
+      kMaidManagerReceiver_(routing_.kNodeId())
+#ifdef TESTING
+      ,
+      send_functor_()
+#endif
+{}
 
 void MaidNodeDispatcher::SendCreateAccountRequest(routing::TaskId task_id) {
   typedef nfs::CreateAccountRequestFromMaidNodeToMaidManager NfsMessage;
   CheckSourcePersonaType<NfsMessage>();
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(nfs::MessageId(task_id), (NfsMessage::Contents()));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_));
 }
 
 void MaidNodeDispatcher::SendRemoveAccountRequest(routing::TaskId task_id) {
@@ -41,7 +47,8 @@ void MaidNodeDispatcher::SendRemoveAccountRequest(routing::TaskId task_id) {
   CheckSourcePersonaType<NfsMessage>();
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(nfs::MessageId(task_id), (NfsMessage::Contents()));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_));
 }
 
 void MaidNodeDispatcher::SendRegisterPmidRequest(
@@ -52,7 +59,8 @@ void MaidNodeDispatcher::SendRegisterPmidRequest(
   assert(!pmid_registration.unregister());
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(nfs::MessageId(task_id), pmid_registration);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_));
 }
 
 void MaidNodeDispatcher::SendUnregisterPmidRequest(
@@ -63,7 +71,8 @@ void MaidNodeDispatcher::SendUnregisterPmidRequest(
   assert(pmid_registration.unregister());
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(nfs::MessageId(task_id), pmid_registration);
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_));
 }
 
 void MaidNodeDispatcher::SendGetPmidHealthRequest(const passport::Pmid& pmid) {
@@ -71,7 +80,8 @@ void MaidNodeDispatcher::SendGetPmidHealthRequest(const passport::Pmid& pmid) {
   CheckSourcePersonaType<NfsMessage>();
   typedef routing::Message<NfsMessage::Sender, NfsMessage::Receiver> RoutingMessage;
   NfsMessage nfs_message(NfsMessage::Contents(pmid.name()));
-  routing_.Send(RoutingMessage(nfs_message.Serialise(), kThisNodeAsSender_, kMaidManagerReceiver_));
+  Send(RoutingMessage(std::move(nfs_message).Serialise(), kThisNodeAsSender_,
+                      kMaidManagerReceiver_));
 }
 
 }  // namespace nfs_client
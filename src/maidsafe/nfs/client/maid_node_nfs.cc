@@ -27,19 +27,81 @@ namespace maidsafe {
 namespace nfs_client {
 
 MaidNodeNfs::MaidNodeNfs(AsioService& asio_service, routing::Routing& routing,
-                         passport::PublicPmid::Name pmid_node_hint)
-    : get_timer_(asio_service),
-      get_versions_timer_(asio_service),
-      get_branch_timer_(asio_service),
+                         passport::PublicPmid::Name pmid_node_hint,
+                         const DataCache::Config& data_cache_config, int max_puts_in_flight,
+                         const nfs::LatencyEstimator::Config& latency_estimator_config,
+                         const nfs::HedgePolicy::Config& get_hedge_config)
+    : data_cache_(data_cache_config),
+      in_flight_gets_(),
+      kMaxPutsInFlight_(max_puts_in_flight),
+      puts_in_flight_mutex_(),
+      puts_in_flight_cond_var_(),
+      puts_in_flight_(0),
+      queued_puts_(),
+      latency_estimator_(latency_estimator_config),
+      get_hedge_policy_(get_hedge_config),
+      op_pool_(),
       dispatcher_(routing),
-      service_([&]()->std::unique_ptr<MaidNodeService> &&
+      get_ops_(asio_service),
+      get_versions_ops_(asio_service),
+      get_branch_ops_(asio_service),
+      put_ops_(asio_service),
+      service_([&]()->std::unique_ptr<MaidNodeService>
 {
   std::unique_ptr<MaidNodeService> service(new MaidNodeService(
-      routing, get_timer_, get_versions_timer_, get_branch_timer_));
+      routing, get_ops_, get_versions_ops_, get_branch_ops_, put_ops_));
   return std::move(service);
 }()),
       pmid_node_hint_mutex_(),
-      pmid_node_hint_(std::move(pmid_node_hint)) {}
+      pmid_node_hint_(std::move(pmid_node_hint)) {
+  if (max_puts_in_flight <= 0) {
+    LOG(kError) << "max_puts_in_flight must be positive.";
+    ThrowError(CommonErrors::invalid_parameter);
+  }
+}
+
+void MaidNodeNfs::AcquirePutSlot() {
+  std::unique_lock<std::mutex> lock(puts_in_flight_mutex_);
+  puts_in_flight_cond_var_.wait(lock, [this] { return puts_in_flight_ < kMaxPutsInFlight_; });
+  ++puts_in_flight_;
+}
+
+bool MaidNodeNfs::TryAcquirePutSlot() {
+  std::lock_guard<std::mutex> lock(puts_in_flight_mutex_);
+  if (puts_in_flight_ == kMaxPutsInFlight_)
+    return false;
+  ++puts_in_flight_;
+  return true;
+}
+
+void MaidNodeNfs::QueuePut(std::function<void()> start) {
+  {
+    std::lock_guard<std::mutex> lock(puts_in_flight_mutex_);
+    if (puts_in_flight_ == kMaxPutsInFlight_) {
+      queued_puts_.push_back(std::move(start));
+      return;
+    }
+    ++puts_in_flight_;
+  }
+  start();
+}
+
+void MaidNodeNfs::ReleasePutSlot() {
+  std::function<void()> start;
+  {
+    std::lock_guard<std::mutex> lock(puts_in_flight_mutex_);
+    if (queued_puts_.empty()) {
+      --puts_in_flight_;
+    } else {
+      start = std::move(queued_puts_.front());
+      queued_puts_.pop_front();
+    }
+  }
+  if (start)
+    start();
+  else
+    puts_in_flight_cond_var_.notify_one();
+}
 
 passport::PublicPmid::Name MaidNodeNfs::pmid_node_hint() const {
   std::lock_guard<std::mutex> lock(pmid_node_hint_mutex_);
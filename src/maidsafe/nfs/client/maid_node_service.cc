@@ -18,20 +18,56 @@
 
 #include "maidsafe/nfs/client/maid_node_service.h"
 
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/nfs/client/data_cache.h"
+
 
 namespace maidsafe {
 
 namespace nfs_client {
 
+namespace {
+
+// A cached copy can only be trusted if it's self-validating, i.e. it's immutable data whose content
+// hashes to its name.
+bool IsValidCachedCopy(const nfs_vault::DataNameAndContent& data) {
+  return data.name.type == DataTagValue::kImmutableDataValue &&
+         crypto::Hash<crypto::SHA512>(data.content.string()).string() ==
+             data.name.raw_name.string();
+}
+
+}  // unnamed namespace
+
 MaidNodeService::MaidNodeService(
     routing::Routing& routing,
-    routing::Timer<MaidNodeService::GetResponse::Contents>& get_timer,
-    routing::Timer<MaidNodeService::GetVersionsResponse::Contents>& get_versions_timer,
-    routing::Timer<MaidNodeService::GetBranchResponse::Contents>& get_branch_timer)
+    nfs::PendingOps<MaidNodeService::GetResponse::Contents>& get_ops,
+    nfs::PendingOps<MaidNodeService::GetVersionsResponse::Contents>& get_versions_ops,
+    nfs::PendingOps<MaidNodeService::GetBranchResponse::Contents>& get_branch_ops,
+    nfs::PendingOps<MaidNodeService::PutResponse::Contents>& put_ops)
         : routing_(routing),
-          get_timer_(get_timer),
-          get_versions_timer_(get_versions_timer),
-          get_branch_timer_(get_branch_timer) {}
+          get_ops_(get_ops),
+          get_versions_ops_(get_versions_ops),
+          get_branch_ops_(get_branch_ops),
+          put_ops_(put_ops) {}
+
+bool MaidNodeService::IsLive(const nfs::TypeErasedMessageWrapper& message) const {
+  const nfs::MessageId& message_id(std::get<3>(message));
+  switch (std::get<0>(message)) {
+    case nfs::MessageAction::kGetResponse:
+    case nfs::MessageAction::kGetCachedResponse:
+      return get_ops_.Contains(message_id);
+    case nfs::MessageAction::kGetVersionsResponse:
+      return get_versions_ops_.Contains(message_id);
+    case nfs::MessageAction::kGetBranchResponse:
+      return get_branch_ops_.Contains(message_id);
+    case nfs::MessageAction::kPutResponse:
+      return put_ops_.Contains(message_id);
+    default:
+      return true;
+  }
+}
 
 template<>
 void MaidNodeService::HandleMessage<MaidNodeService::GetResponse>(
@@ -40,7 +76,7 @@ void MaidNodeService::HandleMessage<MaidNodeService::GetResponse>(
     const typename GetResponse::Receiver& receiver) {
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
-  get_timer_.AddResponse(message.message_id.data, *message.contents);
+  get_ops_.AddResponse(message.message_id, *message.contents);
 }
 
 template<>
@@ -50,7 +86,7 @@ void MaidNodeService::HandleMessage<MaidNodeService::GetVersionsResponse>(
     const typename GetVersionsResponse::Receiver& receiver) {
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
-  get_versions_timer_.AddResponse(message.message_id.data, *message.contents);
+  get_versions_ops_.AddResponse(message.message_id, *message.contents);
 }
 
 template<>
@@ -60,24 +96,38 @@ void MaidNodeService::HandleMessage<MaidNodeService::GetBranchResponse>(
     const typename GetBranchResponse::Receiver& receiver) {
   assert(receiver.data == routing_.kNodeId());
   static_cast<void>(receiver);
-  get_branch_timer_.AddResponse(message.message_id.data, *message.contents);
+  get_branch_ops_.AddResponse(message.message_id, *message.contents);
 }
 
 template<>
 void MaidNodeService::HandleMessage<MaidNodeService::PutResponse>(
-    const PutResponse& /*message*/,
+    const PutResponse& message,
     const typename PutResponse::Sender& /*sender*/,
-    const typename PutResponse::Receiver& /*receiver*/) {
-  // TODO(Fraser#5#): 2013-08-24 - Decide on how this is to be handled, and implement.
-  assert(0);
+    const typename PutResponse::Receiver& receiver) {
+  assert(receiver.data == routing_.kNodeId());
+  static_cast<void>(receiver);
+  put_ops_.AddResponse(message.message_id, *message.contents);
 }
 
 template<>
 void MaidNodeService::HandleMessage<MaidNodeService::GetCachedResponse>(
-    const GetCachedResponse& /*message*/,
+    const GetCachedResponse& message,
     const typename GetCachedResponse::Sender& /*sender*/,
-    const typename GetCachedResponse::Receiver& /*receiver*/) {
-  assert(0);
+    const typename GetCachedResponse::Receiver& receiver) {
+  assert(receiver.data == routing_.kNodeId());
+  static_cast<void>(receiver);
+  // Only a verified copy is passed on, as the first response to arrive resolves the Get.  Failures
+  // from a single PmidNode say nothing about whether the DataManagers can provide the data, so
+  // they're dropped rather than counted against the op.
+  const auto& data(message.contents->data);
+  if (!data)
+    return;
+  if (!IsValidCachedCopy(*data)) {
+    LOG(kWarning) << "Dropping cached copy which doesn't match its name.";
+    return;
+  }
+  get_ops_.AddResponseFor(DataCache::Key(data->name.type, data->name.raw_name),
+                          message.message_id, *message.contents);
 }
 
 
@@ -19,7 +19,10 @@
 #include "maidsafe/nfs/client/messages.h"
 
 #include <cstdint>
+#include <string>
 
+#include "maidsafe/nfs/error_categories.h"
+#include "maidsafe/nfs/protobuf_message.h"
 #include "maidsafe/nfs/utils.h"
 #include "maidsafe/nfs/client/messages.pb.h"
 
@@ -28,34 +31,6 @@ namespace maidsafe {
 
 namespace nfs_client {
 
-namespace {
-
-maidsafe_error GetError(int error_value, const std::string& error_category_name) {
-  if (error_category_name == std::string(GetCommonCategory().name()))
-    return MakeError(static_cast<CommonErrors>(error_value));
-  if (error_category_name == std::string(GetAsymmCategory().name()))
-    return MakeError(static_cast<AsymmErrors>(error_value));
-  if (error_category_name == std::string(GetPassportCategory().name()))
-    return MakeError(static_cast<PassportErrors>(error_value));
-  if (error_category_name == std::string(GetNfsCategory().name()))
-    return MakeError(static_cast<NfsErrors>(error_value));
-  if (error_category_name == std::string(GetRoutingCategory().name()))
-    return MakeError(static_cast<RoutingErrors>(error_value));
-  if (error_category_name == std::string(GetDriveCategory().name()))
-    return MakeError(static_cast<DriveErrors>(error_value));
-  if (error_category_name == std::string(GetVaultCategory().name()))
-    return MakeError(static_cast<VaultErrors>(error_value));
-  if (error_category_name == std::string(GetLifeStuffCategory().name()))
-    return MakeError(static_cast<LifeStuffErrors>(error_value));
-
-  ThrowError(CommonErrors::parsing_error);
-  return MakeError(CommonErrors::parsing_error);
-}
-
-}  // unnamed namespace
-
-
-
 // ==================== ReturnCode =================================================================
 ReturnCode::ReturnCode() : value(CommonErrors::success) {}
 
@@ -70,17 +45,31 @@ ReturnCode& ReturnCode::operator=(ReturnCode other) {
 
 ReturnCode::ReturnCode(const std::string& serialised_copy)
     : value([&serialised_copy] {
-          protobuf::ReturnCode proto_copy;
-          if (!proto_copy.ParseFromString(serialised_copy))
+          nfs::detail::ProtobufMessage<protobuf::ReturnCode> proto_copy;
+          if (!proto_copy->ParseFromString(serialised_copy))
             ThrowError(CommonErrors::parsing_error);
-          return GetError(proto_copy.error_value(), proto_copy.error_category_name());
+          if (proto_copy->has_error_category_id()) {
+            return nfs::MakeErrorFromCategory(proto_copy->error_category_id(),
+                                              proto_copy->error_value());
+          }
+          if (proto_copy->has_error_category_name()) {
+            return nfs::MakeErrorFromCategoryName(proto_copy->error_category_name(),
+                                                  proto_copy->error_value());
+          }
+          ThrowError(CommonErrors::parsing_error);
+          return MakeError(CommonErrors::parsing_error);
         }()) {}
 
 std::string ReturnCode::Serialise() const {
-  protobuf::ReturnCode proto_copy;
-  proto_copy.set_error_value(value.code().value());
-  proto_copy.set_error_category_name(value.code().category().name());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::ReturnCode> proto_copy;
+  const std::error_category& category(value.code().category());
+  const auto category_id(nfs::GetErrorCategoryId(category));
+  proto_copy->set_error_value(value.code().value());
+  if (!category_id || !nfs::GetErrorCategoryIdsOnly())
+    proto_copy->set_error_category_name(category.name());
+  if (category_id)
+    proto_copy->set_error_category_id(static_cast<uint32_t>(*category_id));
+  return proto_copy->SerializeAsString();
 }
 
 
@@ -118,18 +107,18 @@ DataNameAndReturnCode& DataNameAndReturnCode::operator=(DataNameAndReturnCode ot
 DataNameAndReturnCode::DataNameAndReturnCode(const std::string& serialised_copy)
     : name(),
       return_code() {
-  protobuf::DataNameAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  name = nfs_vault::DataName(proto_copy.serialised_name());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  name = nfs_vault::DataName(proto_copy->serialised_name());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataNameAndReturnCode::Serialise() const {
-  protobuf::DataNameAndReturnCode proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndReturnCode> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndReturnCode& lhs, const DataNameAndReturnCode& rhs) {
@@ -167,19 +156,19 @@ DataNameVersionAndReturnCode& DataNameVersionAndReturnCode::operator=(
 DataNameVersionAndReturnCode::DataNameVersionAndReturnCode(const std::string& serialised_copy)
     : data_name_and_version(),
       return_code() {
-  protobuf::DataNameVersionAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameVersionAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
   data_name_and_version =
-      nfs_vault::DataNameAndVersion(proto_copy.serialised_data_name_and_version());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+      nfs_vault::DataNameAndVersion(proto_copy->serialised_data_name_and_version());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataNameVersionAndReturnCode::Serialise() const {
-  protobuf::DataNameVersionAndReturnCode proto_copy;
-  proto_copy.set_serialised_data_name_and_version(data_name_and_version.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataNameVersionAndReturnCode> proto_copy;
+  proto_copy->set_serialised_data_name_and_version(data_name_and_version.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameVersionAndReturnCode& lhs, const DataNameVersionAndReturnCode& rhs) {
@@ -220,19 +209,19 @@ DataNameOldNewVersionAndReturnCode::DataNameOldNewVersionAndReturnCode(
     const std::string& serialised_copy)
         : data_name_old_new_version(),
           return_code() {
-  protobuf::DataNameOldNewVersionAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameOldNewVersionAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
   data_name_old_new_version =
-      nfs_vault::DataNameOldNewVersion(proto_copy.serialised_data_name_old_new_version());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+      nfs_vault::DataNameOldNewVersion(proto_copy->serialised_data_name_old_new_version());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataNameOldNewVersionAndReturnCode::Serialise() const {
-  protobuf::DataNameOldNewVersionAndReturnCode proto_copy;
-  proto_copy.set_serialised_data_name_old_new_version(data_name_old_new_version.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataNameOldNewVersionAndReturnCode> proto_copy;
+  proto_copy->set_serialised_data_name_old_new_version(data_name_old_new_version.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameOldNewVersionAndReturnCode& lhs,
@@ -269,18 +258,18 @@ DataAndReturnCode& DataAndReturnCode::operator=(DataAndReturnCode other) {
 DataAndReturnCode::DataAndReturnCode(const std::string& serialised_copy)
     : data(),
       return_code() {
-  protobuf::DataAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  data = nfs_vault::DataNameAndContent(proto_copy.serialised_data_name_and_content());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  data = nfs_vault::DataNameAndContent(proto_copy->serialised_data_name_and_content());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataAndReturnCode::Serialise() const {
-  protobuf::DataAndReturnCode proto_copy;
-  proto_copy.set_serialised_data_name_and_content(data.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataAndReturnCode> proto_copy;
+  proto_copy->set_serialised_data_name_and_content(data.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataAndReturnCode& lhs, const DataAndReturnCode& rhs) {
@@ -325,15 +314,15 @@ DataNameAndContentOrReturnCode& DataNameAndContentOrReturnCode::operator=(
 DataNameAndContentOrReturnCode::DataNameAndContentOrReturnCode(const std::string& serialised_copy)
     : data(),
       data_name_and_return_code() {
-  protobuf::DataNameAndContentOrReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndContentOrReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
 
-  if (proto_copy.has_serialised_data_name_and_content())
-    data.reset(nfs_vault::DataNameAndContent(proto_copy.serialised_data_name_and_content()));
-  if (proto_copy.has_serialised_data_name_and_return_code()) {
+  if (proto_copy->has_serialised_data_name_and_content())
+    data.reset(nfs_vault::DataNameAndContent(proto_copy->serialised_data_name_and_content()));
+  if (proto_copy->has_serialised_data_name_and_return_code()) {
     data_name_and_return_code.reset(
-        DataNameAndReturnCode(proto_copy.serialised_data_name_and_return_code()));
+        DataNameAndReturnCode(proto_copy->serialised_data_name_and_return_code()));
   }
   if (!nfs::CheckMutuallyExclusive(data, data_name_and_return_code)) {
     assert(false);
@@ -346,13 +335,13 @@ std::string DataNameAndContentOrReturnCode::Serialise() const {
     assert(false);
     ThrowError(CommonErrors::serialisation_error);
   }
-  protobuf::DataNameAndContentOrReturnCode proto_copy;
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndContentOrReturnCode> proto_copy;
 
   if (data)
-    proto_copy.set_serialised_data_name_and_content(data->Serialise());
+    proto_copy->set_serialised_data_name_and_content(data->Serialise());
   else
-    proto_copy.set_serialised_data_name_and_return_code(data_name_and_return_code->Serialise());
-  return proto_copy.SerializeAsString();
+    proto_copy->set_serialised_data_name_and_return_code(data_name_and_return_code->Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndContentOrReturnCode& lhs,
@@ -398,15 +387,15 @@ StructuredDataNameAndContentOrReturnCode::StructuredDataNameAndContentOrReturnCo
     const std::string& serialised_copy)
         : structured_data(),
           data_name_and_return_code() {
-  protobuf::StructuredDataNameAndContentOrReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::StructuredDataNameAndContentOrReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
 
-  if (proto_copy.has_serialised_structured_data())
-    structured_data.reset(StructuredData(proto_copy.serialised_structured_data()));
-  if (proto_copy.has_serialised_data_name_and_return_code()) {
+  if (proto_copy->has_serialised_structured_data())
+    structured_data.reset(StructuredData(proto_copy->serialised_structured_data()));
+  if (proto_copy->has_serialised_data_name_and_return_code()) {
     data_name_and_return_code.reset(
-        DataNameAndReturnCode(proto_copy.serialised_data_name_and_return_code()));
+        DataNameAndReturnCode(proto_copy->serialised_data_name_and_return_code()));
   }
   if (!nfs::CheckMutuallyExclusive(structured_data, data_name_and_return_code)) {
     assert(false);
@@ -419,13 +408,13 @@ std::string StructuredDataNameAndContentOrReturnCode::Serialise() const {
     assert(false);
     ThrowError(CommonErrors::serialisation_error);
   }
-  protobuf::StructuredDataNameAndContentOrReturnCode proto_copy;
+  nfs::detail::ProtobufMessage<protobuf::StructuredDataNameAndContentOrReturnCode> proto_copy;
 
   if (structured_data)
-    proto_copy.set_serialised_structured_data(structured_data->Serialise());
+    proto_copy->set_serialised_structured_data(structured_data->Serialise());
   else
-    proto_copy.set_serialised_data_name_and_return_code(data_name_and_return_code->Serialise());
-  return proto_copy.SerializeAsString();
+    proto_copy->set_serialised_data_name_and_return_code(data_name_and_return_code->Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const StructuredDataNameAndContentOrReturnCode& lhs,
@@ -465,18 +454,18 @@ DataPmidHintAndReturnCode& DataPmidHintAndReturnCode::operator=(DataPmidHintAndR
 DataPmidHintAndReturnCode::DataPmidHintAndReturnCode(const std::string& serialised_copy)
     : data_and_pmid_hint(),
       return_code() {
-  protobuf::DataPmidHintAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataPmidHintAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  data_and_pmid_hint = nfs_vault::DataAndPmidHint(proto_copy.serialised_data_and_pmid_hint());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  data_and_pmid_hint = nfs_vault::DataAndPmidHint(proto_copy->serialised_data_and_pmid_hint());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string DataPmidHintAndReturnCode::Serialise() const {
-  protobuf::DataPmidHintAndReturnCode proto_copy;
-  proto_copy.set_serialised_data_and_pmid_hint(data_and_pmid_hint.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataPmidHintAndReturnCode> proto_copy;
+  proto_copy->set_serialised_data_and_pmid_hint(data_and_pmid_hint.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataPmidHintAndReturnCode& lhs, const DataPmidHintAndReturnCode& rhs) {
@@ -515,18 +504,18 @@ PmidRegistrationAndReturnCode& PmidRegistrationAndReturnCode::operator=(
 PmidRegistrationAndReturnCode::PmidRegistrationAndReturnCode(const std::string& serialised_copy)
     : pmid_registration(),
       return_code() {
-  protobuf::PmidRegistrationAndReturnCode proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::PmidRegistrationAndReturnCode> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  pmid_registration = nfs_vault::PmidRegistration(proto_copy.serialised_pmid_registration());
-  return_code = ReturnCode(proto_copy.serialised_return_code());
+  pmid_registration = nfs_vault::PmidRegistration(proto_copy->serialised_pmid_registration());
+  return_code = ReturnCode(proto_copy->serialised_return_code());
 }
 
 std::string PmidRegistrationAndReturnCode::Serialise() const {
-  protobuf::PmidRegistrationAndReturnCode proto_copy;
-  proto_copy.set_serialised_pmid_registration(pmid_registration.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::PmidRegistrationAndReturnCode> proto_copy;
+  proto_copy->set_serialised_pmid_registration(pmid_registration.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const PmidRegistrationAndReturnCode& lhs,
@@ -558,7 +547,14 @@ DataNameAndContentAndReturnCode::DataNameAndContentAndReturnCode(
     nfs_client::ReturnCode code_in, const NonEmptyString& content_in)
     : name(nfs_vault::DataName(type_in, name_in)),
       return_code(std::move(code_in)),
-      content(content_in) {}
+      content(nfs::SharedBuffer(content_in)) {}
+
+DataNameAndContentAndReturnCode::DataNameAndContentAndReturnCode(
+    const DataTagValue& type_in, const Identity& name_in,
+    nfs_client::ReturnCode code_in, nfs::SharedBuffer content_in)
+    : name(nfs_vault::DataName(type_in, name_in)),
+      return_code(std::move(code_in)),
+      content(std::move(content_in)) {}
 
 DataNameAndContentAndReturnCode::DataNameAndContentAndReturnCode(
     const DataTagValue& type_in, const Identity& name_in,
@@ -580,23 +576,23 @@ DataNameAndContentAndReturnCode::DataNameAndContentAndReturnCode(
 
 DataNameAndContentAndReturnCode::DataNameAndContentAndReturnCode(
     const std::string& serialised_copy) {
-  protobuf::DataNameAndContentAndReturnCode proto;
-  if (!proto.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndContentAndReturnCode> proto;
+  if (!proto->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
 
-  name = nfs_vault::DataName(proto.serialised_name());
-  return_code = nfs_client::ReturnCode(proto.serialised_return_code());
-  if (proto.has_content())
-    content = NonEmptyString(proto.content());
+  name = nfs_vault::DataName(proto->serialised_name());
+  return_code = nfs_client::ReturnCode(proto->serialised_return_code());
+  if (proto->has_content())
+    content = nfs::SharedBuffer(NonEmptyString(proto->content()));
 }
 
 std::string DataNameAndContentAndReturnCode::Serialise() const {
-  protobuf::DataNameAndContentAndReturnCode proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_serialised_return_code(return_code.Serialise());
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndContentAndReturnCode> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_serialised_return_code(return_code.Serialise());
   if (content)
-    proto_copy.set_content(content->string());
-  return proto_copy.SerializeAsString();
+    proto_copy->set_content(content->string());
+  return proto_copy->SerializeAsString();
 }
 
 DataNameAndContentAndReturnCode& DataNameAndContentAndReturnCode::operator=(
@@ -632,6 +628,259 @@ bool operator==(const DataNameAndContentAndReturnCode& lhs,
 
 namespace nfs {
 
+// ==================== ReturnCode =================================================================
+std::size_t DirectCodec<nfs_client::ReturnCode>::Size(const Contents& contents) {
+  typedef nfs_client::protobuf::ReturnCode ProtobufType;
+  const std::error_code& code(contents.value.code());
+  const auto category_id(GetErrorCategoryId(code.category()));
+  std::size_t size(detail::VarintFieldSize(
+      ProtobufType::kErrorValueFieldNumber,
+      static_cast<uint64_t>(static_cast<int64_t>(code.value()))));
+  if (!category_id || !GetErrorCategoryIdsOnly()) {
+    size += detail::BytesFieldSize(ProtobufType::kErrorCategoryNameFieldNumber,
+                                   std::char_traits<char>::length(code.category().name()));
+  }
+  if (category_id) {
+    size += detail::VarintFieldSize(ProtobufType::kErrorCategoryIdFieldNumber,
+                                    static_cast<uint32_t>(*category_id));
+  }
+  return size;
+}
+
+void DirectCodec<nfs_client::ReturnCode>::AppendTo(const Contents& contents,
+                                                   std::string& buffer) {
+  typedef nfs_client::protobuf::ReturnCode ProtobufType;
+  const std::error_code& code(contents.value.code());
+  const auto category_id(GetErrorCategoryId(code.category()));
+  detail::AppendVarintField(ProtobufType::kErrorValueFieldNumber,
+                            static_cast<uint64_t>(static_cast<int64_t>(code.value())), buffer);
+  // Field order matches protobuf's, so that both encodings are byte-identical.
+  if (!category_id || !GetErrorCategoryIdsOnly()) {
+    detail::AppendBytesField(ProtobufType::kErrorCategoryNameFieldNumber,
+                             boost::string_ref(code.category().name()), buffer);
+  }
+  if (category_id) {
+    detail::AppendVarintField(ProtobufType::kErrorCategoryIdFieldNumber,
+                              static_cast<uint32_t>(*category_id), buffer);
+  }
+}
+
+nfs_client::ReturnCode DirectCodec<nfs_client::ReturnCode>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_client::protobuf::ReturnCode ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  const auto error_value(static_cast<int32_t>(fields.varint(ProtobufType::kErrorValueFieldNumber)));
+  if (fields.has_varint(ProtobufType::kErrorCategoryIdFieldNumber)) {
+    return nfs_client::ReturnCode(MakeErrorFromCategory(
+        static_cast<uint32_t>(fields.varint(ProtobufType::kErrorCategoryIdFieldNumber)),
+        error_value));
+  }
+  return nfs_client::ReturnCode(MakeErrorFromCategoryName(
+      fields.bytes(ProtobufType::kErrorCategoryNameFieldNumber).to_string(), error_value));
+}
+
+// ==================== DataNameAndReturnCode ======================================================
+std::size_t DirectCodec<nfs_client::DataNameAndReturnCode>::Size(const Contents& contents) {
+  typedef nfs_client::protobuf::DataNameAndReturnCode ProtobufType;
+  return detail::NestedFieldSize(ProtobufType::kSerialisedNameFieldNumber, contents.name) +
+         detail::NestedFieldSize(ProtobufType::kSerialisedReturnCodeFieldNumber,
+                                 contents.return_code);
+}
+
+void DirectCodec<nfs_client::DataNameAndReturnCode>::AppendTo(const Contents& contents,
+                                                              std::string& buffer) {
+  typedef nfs_client::protobuf::DataNameAndReturnCode ProtobufType;
+  detail::AppendNestedField(ProtobufType::kSerialisedNameFieldNumber, contents.name, buffer);
+  detail::AppendNestedField(ProtobufType::kSerialisedReturnCodeFieldNumber, contents.return_code,
+                            buffer);
+}
+
+nfs_client::DataNameAndReturnCode DirectCodec<nfs_client::DataNameAndReturnCode>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_client::protobuf::DataNameAndReturnCode ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  return nfs_client::DataNameAndReturnCode(
+      DirectCodec<nfs_vault::DataName>::Parse(
+          fields.bytes(ProtobufType::kSerialisedNameFieldNumber)),
+      DirectCodec<nfs_client::ReturnCode>::Parse(
+          fields.bytes(ProtobufType::kSerialisedReturnCodeFieldNumber)));
+}
+
+// ==================== DataNameAndContentOrReturnCode =============================================
+std::size_t DirectCodec<nfs_client::DataNameAndContentOrReturnCode>::Size(
+    const Contents& contents) {
+  typedef nfs_client::protobuf::DataNameAndContentOrReturnCode ProtobufType;
+  if (!CheckMutuallyExclusive(contents.data, contents.data_name_and_return_code)) {
+    assert(false);
+    ThrowError(CommonErrors::serialisation_error);
+  }
+  if (contents.data)
+    return detail::NestedFieldSize(ProtobufType::kSerialisedDataNameAndContentFieldNumber,
+                                   *contents.data);
+  return detail::NestedFieldSize(ProtobufType::kSerialisedDataNameAndReturnCodeFieldNumber,
+                                 *contents.data_name_and_return_code);
+}
+
+void DirectCodec<nfs_client::DataNameAndContentOrReturnCode>::AppendTo(const Contents& contents,
+                                                                       std::string& buffer) {
+  typedef nfs_client::protobuf::DataNameAndContentOrReturnCode ProtobufType;
+  if (!CheckMutuallyExclusive(contents.data, contents.data_name_and_return_code)) {
+    assert(false);
+    ThrowError(CommonErrors::serialisation_error);
+  }
+  if (contents.data) {
+    detail::AppendNestedField(ProtobufType::kSerialisedDataNameAndContentFieldNumber,
+                              *contents.data, buffer);
+  } else {
+    detail::AppendNestedField(ProtobufType::kSerialisedDataNameAndReturnCodeFieldNumber,
+                              *contents.data_name_and_return_code, buffer);
+  }
+}
+
+nfs_client::DataNameAndContentOrReturnCode
+    DirectCodec<nfs_client::DataNameAndContentOrReturnCode>::Parse(
+        const boost::string_ref& serialised_contents) {
+  typedef nfs_client::protobuf::DataNameAndContentOrReturnCode ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_client::DataNameAndContentOrReturnCode result;
+  if (fields.has_bytes(ProtobufType::kSerialisedDataNameAndContentFieldNumber)) {
+    result.data = DirectCodec<nfs_vault::DataNameAndContent>::Parse(
+        fields.bytes(ProtobufType::kSerialisedDataNameAndContentFieldNumber));
+  }
+  if (fields.has_bytes(ProtobufType::kSerialisedDataNameAndReturnCodeFieldNumber)) {
+    result.data_name_and_return_code = DirectCodec<nfs_client::DataNameAndReturnCode>::Parse(
+        fields.bytes(ProtobufType::kSerialisedDataNameAndReturnCodeFieldNumber));
+  }
+  if (!CheckMutuallyExclusive(result.data, result.data_name_and_return_code)) {
+    assert(false);
+    ThrowError(CommonErrors::parsing_error);
+  }
+  return result;
+}
+
+// ==================== StructuredDataNameAndContentOrReturnCode ===================================
+std::size_t DirectCodec<nfs_client::StructuredDataNameAndContentOrReturnCode>::Size(
+    const Contents& contents) {
+  typedef nfs_client::protobuf::StructuredDataNameAndContentOrReturnCode ProtobufType;
+  if (!CheckMutuallyExclusive(contents.structured_data, contents.data_name_and_return_code)) {
+    assert(false);
+    ThrowError(CommonErrors::serialisation_error);
+  }
+  if (contents.structured_data)
+    return detail::NestedFieldSize(ProtobufType::kSerialisedStructuredDataFieldNumber,
+                                   *contents.structured_data);
+  return detail::NestedFieldSize(ProtobufType::kSerialisedDataNameAndReturnCodeFieldNumber,
+                                 *contents.data_name_and_return_code);
+}
+
+void DirectCodec<nfs_client::StructuredDataNameAndContentOrReturnCode>::AppendTo(
+    const Contents& contents, std::string& buffer) {
+  typedef nfs_client::protobuf::StructuredDataNameAndContentOrReturnCode ProtobufType;
+  if (!CheckMutuallyExclusive(contents.structured_data, contents.data_name_and_return_code)) {
+    assert(false);
+    ThrowError(CommonErrors::serialisation_error);
+  }
+  if (contents.structured_data) {
+    detail::AppendNestedField(ProtobufType::kSerialisedStructuredDataFieldNumber,
+                              *contents.structured_data, buffer);
+  } else {
+    detail::AppendNestedField(ProtobufType::kSerialisedDataNameAndReturnCodeFieldNumber,
+                              *contents.data_name_and_return_code, buffer);
+  }
+}
+
+nfs_client::StructuredDataNameAndContentOrReturnCode
+    DirectCodec<nfs_client::StructuredDataNameAndContentOrReturnCode>::Parse(
+        const boost::string_ref& serialised_contents) {
+  typedef nfs_client::protobuf::StructuredDataNameAndContentOrReturnCode ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_client::StructuredDataNameAndContentOrReturnCode result;
+  if (fields.has_bytes(ProtobufType::kSerialisedStructuredDataFieldNumber)) {
+    result.structured_data = DirectCodec<nfs_client::StructuredData>::Parse(
+        fields.bytes(ProtobufType::kSerialisedStructuredDataFieldNumber));
+  }
+  if (fields.has_bytes(ProtobufType::kSerialisedDataNameAndReturnCodeFieldNumber)) {
+    result.data_name_and_return_code = DirectCodec<nfs_client::DataNameAndReturnCode>::Parse(
+        fields.bytes(ProtobufType::kSerialisedDataNameAndReturnCodeFieldNumber));
+  }
+  if (!CheckMutuallyExclusive(result.structured_data, result.data_name_and_return_code)) {
+    assert(false);
+    ThrowError(CommonErrors::parsing_error);
+  }
+  return result;
+}
+
+// ==================== DataPmidHintAndReturnCode ==================================================
+std::size_t DirectCodec<nfs_client::DataPmidHintAndReturnCode>::Size(const Contents& contents) {
+  typedef nfs_client::protobuf::DataPmidHintAndReturnCode ProtobufType;
+  return detail::NestedFieldSize(ProtobufType::kSerialisedDataAndPmidHintFieldNumber,
+                                 contents.data_and_pmid_hint) +
+         detail::NestedFieldSize(ProtobufType::kSerialisedReturnCodeFieldNumber,
+                                 contents.return_code);
+}
+
+void DirectCodec<nfs_client::DataPmidHintAndReturnCode>::AppendTo(const Contents& contents,
+                                                                  std::string& buffer) {
+  typedef nfs_client::protobuf::DataPmidHintAndReturnCode ProtobufType;
+  detail::AppendNestedField(ProtobufType::kSerialisedDataAndPmidHintFieldNumber,
+                            contents.data_and_pmid_hint, buffer);
+  detail::AppendNestedField(ProtobufType::kSerialisedReturnCodeFieldNumber, contents.return_code,
+                            buffer);
+}
+
+nfs_client::DataPmidHintAndReturnCode DirectCodec<nfs_client::DataPmidHintAndReturnCode>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_client::protobuf::DataPmidHintAndReturnCode ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_client::DataPmidHintAndReturnCode result;
+  result.data_and_pmid_hint = DirectCodec<nfs_vault::DataAndPmidHint>::Parse(
+      fields.bytes(ProtobufType::kSerialisedDataAndPmidHintFieldNumber));
+  result.return_code = DirectCodec<nfs_client::ReturnCode>::Parse(
+      fields.bytes(ProtobufType::kSerialisedReturnCodeFieldNumber));
+  return result;
+}
+
+// ==================== DataNameAndContentAndReturnCode ============================================
+std::size_t DirectCodec<nfs_client::DataNameAndContentAndReturnCode>::Size(
+    const Contents& contents) {
+  typedef nfs_client::protobuf::DataNameAndContentAndReturnCode ProtobufType;
+  return detail::NestedFieldSize(ProtobufType::kSerialisedNameFieldNumber, contents.name) +
+         detail::NestedFieldSize(ProtobufType::kSerialisedReturnCodeFieldNumber,
+                                 contents.return_code) +
+         (contents.content ?
+              detail::BytesFieldSize(ProtobufType::kContentFieldNumber, contents.content->size()) :
+              0);
+}
+
+void DirectCodec<nfs_client::DataNameAndContentAndReturnCode>::AppendTo(const Contents& contents,
+                                                                        std::string& buffer) {
+  typedef nfs_client::protobuf::DataNameAndContentAndReturnCode ProtobufType;
+  detail::AppendNestedField(ProtobufType::kSerialisedNameFieldNumber, contents.name, buffer);
+  detail::AppendNestedField(ProtobufType::kSerialisedReturnCodeFieldNumber, contents.return_code,
+                            buffer);
+  if (contents.content) {
+    detail::AppendBytesField(ProtobufType::kContentFieldNumber, contents.content->string(),
+                             buffer);
+  }
+}
+
+nfs_client::DataNameAndContentAndReturnCode
+    DirectCodec<nfs_client::DataNameAndContentAndReturnCode>::Parse(
+        const boost::string_ref& serialised_contents) {
+  typedef nfs_client::protobuf::DataNameAndContentAndReturnCode ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_client::DataNameAndContentAndReturnCode result;
+  result.name = DirectCodec<nfs_vault::DataName>::Parse(
+      fields.bytes(ProtobufType::kSerialisedNameFieldNumber));
+  result.return_code = DirectCodec<nfs_client::ReturnCode>::Parse(
+      fields.bytes(ProtobufType::kSerialisedReturnCodeFieldNumber));
+  if (fields.has_bytes(ProtobufType::kContentFieldNumber)) {
+    result.content =
+        SharedBuffer(NonEmptyString(fields.bytes(ProtobufType::kContentFieldNumber).to_string()));
+  }
+  return result;
+}
+
 template<>
 bool IsSuccess<nfs_client::DataNameAndContentOrReturnCode>(
     const nfs_client::DataNameAndContentOrReturnCode& response) {
@@ -649,6 +898,25 @@ std::error_code ErrorCode<nfs_client::DataNameAndContentOrReturnCode>(
     return std::error_code(NfsErrors::timed_out);
 }
 
+// A default-constructed response (as passed on timeout) has a success return code but no data name.
+template<>
+bool IsSuccess<nfs_client::DataPmidHintAndReturnCode>(
+    const nfs_client::DataPmidHintAndReturnCode& response) {
+  return !response.return_code.value.code() &&
+         response.data_and_pmid_hint.data.name.raw_name.IsInitialised();
+}
+
+template<>
+std::error_code ErrorCode<nfs_client::DataPmidHintAndReturnCode>(
+    const nfs_client::DataPmidHintAndReturnCode& response) {
+  if (response.return_code.value.code())
+    return response.return_code.value.code();
+  else if (response.data_and_pmid_hint.data.name.raw_name.IsInitialised())
+    return std::error_code(CommonErrors::success);
+  else
+    return std::error_code(NfsErrors::timed_out);
+}
+
 template<>
 bool IsSuccess<nfs_client::StructuredDataNameAndContentOrReturnCode>(
     const nfs_client::StructuredDataNameAndContentOrReturnCode& response) {
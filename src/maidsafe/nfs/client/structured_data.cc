@@ -22,6 +22,7 @@
 
 #include "maidsafe/common/error.h"
 
+#include "maidsafe/nfs/protobuf_message.h"
 #include "maidsafe/nfs/client/structured_data.pb.h"
 
 
@@ -45,18 +46,18 @@ StructuredData& StructuredData::operator=(StructuredData other) {
 }
 
 StructuredData::StructuredData(const std::string& serialised_copy) : versions() {
-  protobuf::StructuredData proto_structured_data;
-  if (!proto_structured_data.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::StructuredData> proto_structured_data;
+  if (!proto_structured_data->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  for (auto i(0); i < proto_structured_data.serialised_versions_size(); ++i)
-    versions.emplace_back(proto_structured_data.serialised_versions(i));
+  for (auto i(0); i < proto_structured_data->serialised_versions_size(); ++i)
+    versions.emplace_back(proto_structured_data->serialised_versions(i));
 }
 
 std::string StructuredData::Serialise() const {
-  protobuf::StructuredData proto_structured_data;
+  nfs::detail::ProtobufMessage<protobuf::StructuredData> proto_structured_data;
   for (const auto& version : versions)
-    proto_structured_data.add_serialised_versions(version.Serialise());
-  return proto_structured_data.SerializeAsString();
+    proto_structured_data->add_serialised_versions(version.Serialise());
+  return proto_structured_data->SerializeAsString();
 }
 
 bool operator==(const StructuredData& lhs, const StructuredData& rhs) {
@@ -76,4 +77,40 @@ void swap(StructuredData& lhs, StructuredData& rhs) MAIDSAFE_NOEXCEPT {
 
 }  // namespace nfs_client
 
+
+
+namespace nfs {
+
+std::size_t DirectCodec<nfs_client::StructuredData>::Size(const Contents& contents) {
+  typedef nfs_client::protobuf::StructuredData ProtobufType;
+  std::size_t size(0);
+  for (const auto& version : contents.versions) {
+    size += detail::BytesFieldSize(ProtobufType::kSerialisedVersionsFieldNumber,
+                                   version.Serialise().size());
+  }
+  return size;
+}
+
+void DirectCodec<nfs_client::StructuredData>::AppendTo(const Contents& contents,
+                                                       std::string& buffer) {
+  typedef nfs_client::protobuf::StructuredData ProtobufType;
+  for (const auto& version : contents.versions) {
+    detail::AppendBytesField(ProtobufType::kSerialisedVersionsFieldNumber, version.Serialise(),
+                             buffer);
+  }
+}
+
+nfs_client::StructuredData DirectCodec<nfs_client::StructuredData>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_client::protobuf::StructuredData ProtobufType;
+  nfs_client::StructuredData structured_data;
+  for (const auto& serialised_version : detail::GetRepeatedBytesField(
+           serialised_contents, ProtobufType::kSerialisedVersionsFieldNumber)) {
+    structured_data.versions.emplace_back(serialised_version.to_string());
+  }
+  return structured_data;
+}
+
+}  // namespace nfs
+
 }  // namespace maidsafe
@@ -0,0 +1,115 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/codec_arena.h"
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include "boost/thread/tss.hpp"
+
+#include "maidsafe/nfs/protobuf_message.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace {
+
+std::atomic<CodecMode> g_codec_mode(CodecMode::kDirect);
+
+#ifdef MAIDSAFE_NFS_PROTOBUF_ARENAS
+// Large enough for the protobuf messages and string headers of any nfs message's contents; only
+// the bytes of string fields longer than this (e.g. chunk content) are allocated separately.
+const std::size_t kInitialBlockSize(2048);
+
+google::protobuf::ArenaOptions InitialBlockOptions(char* initial_block) {
+  google::protobuf::ArenaOptions options;
+  options.initial_block = initial_block;
+  options.initial_block_size = kInitialBlockSize;
+  return options;
+}
+
+// Resetting the arena keeps its initial block, so a thread only allocates these once.
+struct ThreadArena {
+  ThreadArena()
+      : initial_block(),
+        arena(InitialBlockOptions(reinterpret_cast<char*>(&initial_block))),
+        in_use(false) {}
+  std::aligned_storage<kInitialBlockSize, 8>::type initial_block;
+  google::protobuf::Arena arena;
+  bool in_use;
+};
+
+boost::thread_specific_ptr<ThreadArena> g_thread_arena;
+#endif
+
+}  // unnamed namespace
+
+void SetCodecMode(CodecMode codec_mode) {
+  g_codec_mode.store(codec_mode);
+}
+
+CodecMode GetCodecMode() {
+  return g_codec_mode.load();
+}
+
+bool ArenaCodecAvailable() {
+#ifdef MAIDSAFE_NFS_PROTOBUF_ARENAS
+  return true;
+#else
+  return false;
+#endif
+}
+
+CodecArena::CodecArena() : owns_arena_(false) {
+#ifdef MAIDSAFE_NFS_PROTOBUF_ARENAS
+  if (GetCodecMode() != CodecMode::kProtobufArena)
+    return;
+  if (!g_thread_arena.get())
+    g_thread_arena.reset(new ThreadArena);
+  if (!g_thread_arena->in_use)
+    g_thread_arena->in_use = owns_arena_ = true;
+#endif
+}
+
+CodecArena::~CodecArena() {
+#ifdef MAIDSAFE_NFS_PROTOBUF_ARENAS
+  if (owns_arena_) {
+    g_thread_arena->arena.Reset();
+    g_thread_arena->in_use = false;
+  }
+#endif
+}
+
+namespace detail {
+
+#ifdef MAIDSAFE_NFS_PROTOBUF_ARENAS
+google::protobuf::Arena* CurrentProtobufArena() {
+  auto thread_arena(g_thread_arena.get());
+  return thread_arena && thread_arena->in_use ? &thread_arena->arena : nullptr;
+}
+#endif
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,95 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/error_categories.h"
+
+#include <atomic>
+
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace {
+
+struct ErrorCategory {
+  const std::error_category& (*category)();
+  maidsafe_error (*make_error)(int);
+};
+
+template<typename ErrorEnum>
+maidsafe_error MakeErrorFromValue(int error_value) {
+  return MakeError(static_cast<ErrorEnum>(error_value));
+}
+
+// Indexed by ErrorCategoryId - 1.
+const ErrorCategory kErrorCategories[] = {
+  { &GetCommonCategory, &MakeErrorFromValue<CommonErrors> },
+  { &GetAsymmCategory, &MakeErrorFromValue<AsymmErrors> },
+  { &GetPassportCategory, &MakeErrorFromValue<PassportErrors> },
+  { &GetNfsCategory, &MakeErrorFromValue<NfsErrors> },
+  { &GetRoutingCategory, &MakeErrorFromValue<RoutingErrors> },
+  { &GetDriveCategory, &MakeErrorFromValue<DriveErrors> },
+  { &GetVaultCategory, &MakeErrorFromValue<VaultErrors> },
+  { &GetLifeStuffCategory, &MakeErrorFromValue<LifeStuffErrors> }
+};
+
+const uint32_t kErrorCategoryCount(sizeof(kErrorCategories) / sizeof(kErrorCategories[0]));
+
+static_assert(kErrorCategoryCount == static_cast<uint32_t>(ErrorCategoryId::kLifeStuff),
+              "Each ErrorCategoryId must have an entry in kErrorCategories.");
+
+std::atomic<bool> g_ids_only(false);
+
+}  // unnamed namespace
+
+boost::optional<ErrorCategoryId> GetErrorCategoryId(const std::error_category& category) {
+  for (uint32_t i(0); i != kErrorCategoryCount; ++i) {
+    if (category == kErrorCategories[i].category())
+      return static_cast<ErrorCategoryId>(i + 1);
+  }
+  return boost::none;
+}
+
+void SetErrorCategoryIdsOnly(bool ids_only) { g_ids_only.store(ids_only); }
+
+bool GetErrorCategoryIdsOnly() { return g_ids_only.load(); }
+
+maidsafe_error MakeErrorFromCategory(uint32_t category_id, int error_value) {
+  if (category_id == 0 || category_id > kErrorCategoryCount) {
+    LOG(kError) << "Unknown error category ID " << category_id;
+    ThrowError(CommonErrors::parsing_error);
+  }
+  return kErrorCategories[category_id - 1].make_error(error_value);
+}
+
+maidsafe_error MakeErrorFromCategoryName(const std::string& category_name, int error_value) {
+  for (uint32_t i(0); i != kErrorCategoryCount; ++i) {
+    if (category_name == kErrorCategories[i].category().name())
+      return kErrorCategories[i].make_error(error_value);
+  }
+  LOG(kError) << "Unknown error category " << category_name;
+  ThrowError(CommonErrors::parsing_error);
+  return MakeError(CommonErrors::parsing_error);
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,91 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/hedge_policy.h"
+
+#include <algorithm>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+HedgePolicy::Config::Config()
+    : max_hedges(0),
+      delay_fraction(0.25),
+      latency_percentile(0.95),
+      budget_percent(5.0) {}
+
+HedgePolicy::HedgePolicy()
+    : kConfig_(),
+      requests_(0),
+      hedges_(0),
+      hedges_over_budget_(0),
+      hedge_wins_(0) {}
+
+HedgePolicy::HedgePolicy(const Config& config)
+    : kConfig_(config),
+      requests_(0),
+      hedges_(0),
+      hedges_over_budget_(0),
+      hedge_wins_(0) {
+  if (config.max_hedges < 0 || config.delay_fraction <= 0.0 || config.delay_fraction > 1.0 ||
+      config.latency_percentile <= 0.0 || config.latency_percentile > 1.0 ||
+      config.budget_percent < 0.0 || config.budget_percent > 100.0) {
+    LOG(kError) << "Invalid HedgePolicy configuration.";
+    ThrowError(CommonErrors::invalid_parameter);
+  }
+}
+
+std::chrono::steady_clock::duration HedgePolicy::Delay(
+    const std::chrono::steady_clock::duration& timeout,
+    const std::chrono::steady_clock::duration& latency_estimate) const {
+  auto delay(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      timeout * kConfig_.delay_fraction));
+  if (latency_estimate != std::chrono::steady_clock::duration::zero())
+    delay = std::min(delay, latency_estimate);
+  return delay;
+}
+
+bool HedgePolicy::TryAddHedge() {
+  const double budget(requests_.load() * kConfig_.budget_percent / 100.0);
+  uint64_t hedges(hedges_.load());
+  do {
+    if (static_cast<double>(hedges + 1) > budget) {
+      ++hedges_over_budget_;
+      return false;
+    }
+  } while (!hedges_.compare_exchange_weak(hedges, hedges + 1));
+  return true;
+}
+
+HedgePolicy::Stats HedgePolicy::stats() const {
+  Stats stats;
+  stats.requests = requests_.load();
+  stats.hedges = hedges_.load();
+  stats.hedges_over_budget = hedges_over_budget_.load();
+  stats.hedge_wins = hedge_wins_.load();
+  return stats;
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,126 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/latency_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace {
+
+// Once a histogram holds this many samples, its counts are halved.
+const uint32_t kDecayThreshold(1024);
+
+typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+int BucketIndex(const std::chrono::steady_clock::duration& latency, int bucket_count) {
+  const double milliseconds(std::chrono::duration_cast<Milliseconds>(latency).count());
+  if (milliseconds <= 1.0)
+    return 0;
+  const int index(static_cast<int>(std::ceil(2.0 * std::log2(milliseconds))));
+  return std::min(index, bucket_count - 1);
+}
+
+std::chrono::steady_clock::duration BucketUpperBound(int index) {
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      Milliseconds(std::pow(2.0, index / 2.0)));
+}
+
+}  // unnamed namespace
+
+LatencyEstimator::Config::Config()
+    : percentile(0.99),
+      margin(std::chrono::milliseconds(250)),
+      min_timeout(std::chrono::seconds(1)),
+      max_timeout(std::chrono::seconds(60)),
+      default_timeout(std::chrono::seconds(10)),
+      min_samples(20) {}
+
+LatencyEstimator::LatencyEstimator() : kConfig_(), adaptive_(false), mutex_(), histograms_() {}
+
+LatencyEstimator::LatencyEstimator(const Config& config)
+    : kConfig_(config),
+      adaptive_(false),
+      mutex_(),
+      histograms_() {
+  if (config.percentile <= 0.0 || config.percentile > 1.0 ||
+      config.min_timeout > config.max_timeout ||
+      config.default_timeout < std::chrono::steady_clock::duration::zero()) {
+    LOG(kError) << "Invalid LatencyEstimator configuration.";
+    ThrowError(CommonErrors::invalid_parameter);
+  }
+}
+
+void LatencyEstimator::AddSample(MessageAction action, Persona destination_persona,
+                                 const std::chrono::steady_clock::duration& latency) {
+  const int index(BucketIndex(latency, kBucketCount));
+  std::lock_guard<std::mutex> lock(mutex_);
+  Histogram& histogram(histograms_[std::make_pair(action, destination_persona)]);
+  ++histogram.counts[index];
+  if (++histogram.total < kDecayThreshold)
+    return;
+  histogram.total = 0;
+  for (auto& count : histogram.counts) {
+    count /= 2;
+    histogram.total += count;
+  }
+}
+
+std::chrono::steady_clock::duration LatencyEstimator::Timeout(
+    MessageAction action, Persona destination_persona,
+    const std::chrono::steady_clock::duration& timeout) const {
+  if (timeout != kUnspecifiedTimeout)
+    return timeout;
+  if (!adaptive_)
+    return kConfig_.default_timeout;
+  auto estimate(Percentile(action, destination_persona, kConfig_.percentile));
+  if (estimate == std::chrono::steady_clock::duration::zero())
+    return kConfig_.default_timeout;
+  return std::min(std::max(estimate + kConfig_.margin, kConfig_.min_timeout),
+                  kConfig_.max_timeout);
+}
+
+std::chrono::steady_clock::duration LatencyEstimator::Percentile(MessageAction action,
+                                                                 Persona destination_persona,
+                                                                 double percentile) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(histograms_.find(std::make_pair(action, destination_persona)));
+  if (itr == histograms_.end() || itr->second.total < kConfig_.min_samples)
+    return std::chrono::steady_clock::duration::zero();
+  const Histogram& histogram(itr->second);
+  const double target(percentile * histogram.total);
+  uint32_t cumulative(0);
+  for (int i(0); i != kBucketCount; ++i) {
+    cumulative += histogram.counts[i];
+    if (cumulative >= target)
+      return BucketUpperBound(i);
+  }
+  return BucketUpperBound(kBucketCount - 1);
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
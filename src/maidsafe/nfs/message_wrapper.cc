@@ -18,6 +18,14 @@
 
 #include "maidsafe/nfs/message_wrapper.h"
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "boost/thread/tss.hpp"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/utils.h"
 
@@ -30,20 +38,219 @@ namespace nfs {
 
 namespace detail {
 
+namespace {
+
+typedef google::protobuf::internal::WireFormatLite WireFormat;
+
+// Each int32 or int64 field needs at most a one-byte tag plus a ten-byte (sign-extended) varint,
+// and the contents field needs at most a one-byte tag plus a five-byte length prefix.
+const int kMaxHeaderSize(5 * 11 + 6);
+
+// Message IDs are a random per-process prefix in the top bits (leaving the sign bit clear) and a
+// counter in the low 40 bits.  Each thread takes a block of counter values at a time from the
+// shared atomic, so allocating an ID only touches shared state once per block.
+const int kMessageIdCounterBits(40);
+const uint64_t kMessageIdCounterMask((uint64_t(1) << kMessageIdCounterBits) - 1);
+const uint64_t kMessageIdPrefixMask((uint64_t(1) << (63 - kMessageIdCounterBits)) - 1);
+const uint64_t kMessageIdBlockSize(1024);
+
+struct MessageIdBlock {
+  MessageIdBlock() : next(0), end(0) {}
+  uint64_t next, end;
+};
+
+std::atomic<uint64_t> g_next_message_id_block(0);
+boost::thread_specific_ptr<MessageIdBlock> g_message_id_block;
+
+uint64_t MessageIdPrefix() {
+  static const uint64_t kPrefix((RandomUint32() & kMessageIdPrefixMask) << kMessageIdCounterBits);
+  return kPrefix;
+}
+
+// Walks the top-level fields of a protobuf-encoded message without copying any of it.  For each
+// varint field, 'varint_functor(field_number, value)' is invoked, and for each length-delimited
+// field, 'bytes_functor(field_number, view_of_field)' is invoked.  Other fields are skipped.
+template<typename VarintFunctor, typename BytesFunctor>
+void ParseFields(const boost::string_ref& serialised_message, VarintFunctor varint_functor,
+                 BytesFunctor bytes_functor) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const google::protobuf::uint8*>(serialised_message.data()),
+      static_cast<int>(serialised_message.size()));
+  for (;;) {
+    const google::protobuf::uint32 tag(input.ReadTag());
+    if (tag == 0) {
+      if (!input.ConsumedEntireMessage())
+        ThrowError(CommonErrors::parsing_error);
+      return;
+    }
+    const int field_number(WireFormat::GetTagFieldNumber(tag));
+    switch (WireFormat::GetTagWireType(tag)) {
+      case WireFormat::WIRETYPE_VARINT: {
+        google::protobuf::uint64 value;
+        if (!input.ReadVarint64(&value))
+          ThrowError(CommonErrors::parsing_error);
+        varint_functor(field_number, value);
+        break;
+      }
+      case WireFormat::WIRETYPE_LENGTH_DELIMITED: {
+        google::protobuf::uint32 length;
+        if (!input.ReadVarint32(&length))
+          ThrowError(CommonErrors::parsing_error);
+        const int offset(input.CurrentPosition());
+        if (!input.Skip(static_cast<int>(length)))
+          ThrowError(CommonErrors::parsing_error);
+        bytes_functor(field_number, serialised_message.substr(offset, length));
+        break;
+      }
+      default:
+        if (!WireFormat::SkipField(&input, tag))
+          ThrowError(CommonErrors::parsing_error);
+    }
+  }
+}
+
+}  // unnamed namespace
+
 MessageId GetNewMessageId() {
-  static int32_t random_element(RandomInt32());
-  return MessageId(random_element++);
+  MessageIdBlock* block(g_message_id_block.get());
+  if (!block) {
+    block = new MessageIdBlock;
+    g_message_id_block.reset(block);
+  }
+  if (block->next == block->end) {
+    block->next = g_next_message_id_block.fetch_add(kMessageIdBlockSize);
+    block->end = block->next + kMessageIdBlockSize;
+  }
+  const uint64_t counter(block->next++ & kMessageIdCounterMask);
+  return MessageId(static_cast<int64_t>(MessageIdPrefix() | counter));
+}
+
+std::string SerialiseMessageWrapperHeader(MessageAction action,
+                                          Persona source_persona,
+                                          Persona destination_persona,
+                                          MessageId message_id,
+                                          std::size_t contents_size,
+                                          PayloadEncoding payload_encoding) {
+  google::protobuf::uint8 header[kMaxHeaderSize];
+  auto header_end(WireFormat::WriteInt32ToArray(protobuf::MessageWrapper::kActionFieldNumber,
+                                                static_cast<int32_t>(action), header));
+  header_end = WireFormat::WriteInt32ToArray(protobuf::MessageWrapper::kSourcePersonaFieldNumber,
+                                             static_cast<int32_t>(source_persona), header_end);
+  header_end = WireFormat::WriteInt32ToArray(
+      protobuf::MessageWrapper::kDestinationPersonaFieldNumber,
+      static_cast<int32_t>(destination_persona), header_end);
+  header_end = WireFormat::WriteInt64ToArray(protobuf::MessageWrapper::kMessageIdFieldNumber,
+                                             message_id.data, header_end);
+  // Written before the contents field, since the contents are appended after the header.
+  if (payload_encoding != PayloadEncoding::kNone) {
+    header_end = WireFormat::WriteInt32ToArray(
+        protobuf::MessageWrapper::kPayloadEncodingFieldNumber,
+        static_cast<int32_t>(payload_encoding), header_end);
+  }
+  header_end = WireFormat::WriteTagToArray(
+      protobuf::MessageWrapper::kSerialisedContentsFieldNumber,
+      WireFormat::WIRETYPE_LENGTH_DELIMITED, header_end);
+  header_end = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      static_cast<google::protobuf::uint32>(contents_size), header_end);
+
+  const auto header_size(header_end - header);
+  std::string serialised_message_wrapper;
+  serialised_message_wrapper.reserve(header_size + contents_size);
+  serialised_message_wrapper.append(reinterpret_cast<const char*>(header), header_size);
+  return serialised_message_wrapper;
+}
+
+std::string SerialiseMessageWrapper(MessageAction action,
+                                    Persona source_persona,
+                                    Persona destination_persona,
+                                    MessageId message_id,
+                                    const std::string& serialised_contents,
+                                    PayloadEncoding payload_encoding) {
+  auto serialised_message_wrapper(SerialiseMessageWrapperHeader(
+      action, source_persona, destination_persona, message_id, serialised_contents.size(),
+      payload_encoding));
+  serialised_message_wrapper.append(serialised_contents);
+  return serialised_message_wrapper;
+}
+
+boost::optional<boost::string_ref> GetBytesField(const boost::string_ref& serialised_message,
+                                                 int field_number) {
+  boost::optional<boost::string_ref> field;
+  ParseFields(serialised_message, [](int, google::protobuf::uint64) {},
+              [&](int this_field_number, const boost::string_ref& bytes) {
+                if (this_field_number == field_number)
+                  field = bytes;
+              });
+  return field;
 }
 
-std::string SerialiseMessageWrapper(const TypeErasedMessageWrapper& message_tuple) {
-  protobuf::MessageWrapper proto_message_wrapper;
-  proto_message_wrapper.set_action(static_cast<int32_t>(std::get<0>(message_tuple)));
-  proto_message_wrapper.set_source_persona(static_cast<int32_t>(std::get<1>(message_tuple).data));
-  proto_message_wrapper.set_destination_persona(
-      static_cast<int32_t>(std::get<2>(message_tuple).data));
-  proto_message_wrapper.set_message_id(std::get<3>(message_tuple));
-  proto_message_wrapper.set_serialised_contents(std::get<4>(message_tuple));
-  return proto_message_wrapper.SerializeAsString();
+std::size_t BytesFieldSize(int field_number, std::size_t value_size) {
+  return WireFormat::TagSize(field_number, WireFormat::TYPE_BYTES) +
+         google::protobuf::io::CodedOutputStream::VarintSize32(
+             static_cast<google::protobuf::uint32>(value_size)) +
+         value_size;
+}
+
+void AppendBytesFieldHeader(int field_number, std::size_t value_size, std::string& buffer) {
+  // The tag and the length prefix each need at most five bytes.
+  google::protobuf::uint8 header[16];
+  auto header_end(WireFormat::WriteTagToArray(field_number, WireFormat::WIRETYPE_LENGTH_DELIMITED,
+                                              header));
+  header_end = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      static_cast<google::protobuf::uint32>(value_size), header_end);
+  buffer.append(reinterpret_cast<const char*>(header), header_end - header);
+}
+
+void AppendBytesField(int field_number, const boost::string_ref& value, std::string& buffer) {
+  AppendBytesFieldHeader(field_number, value.size(), buffer);
+  buffer.append(value.data(), value.size());
+}
+
+std::size_t VarintFieldSize(int field_number, uint64_t value) {
+  return WireFormat::TagSize(field_number, WireFormat::TYPE_UINT64) +
+         google::protobuf::io::CodedOutputStream::VarintSize64(value);
+}
+
+void AppendVarintField(int field_number, uint64_t value, std::string& buffer) {
+  // The tag needs at most five bytes and the value at most ten.
+  google::protobuf::uint8 field[16];
+  auto field_end(WireFormat::WriteUInt64ToArray(field_number, value, field));
+  buffer.append(reinterpret_cast<const char*>(field), field_end - field);
+}
+
+MessageFields::MessageFields(const boost::string_ref& serialised_message) : bytes_(), varints_() {
+  ParseFields(serialised_message,
+              [this](int field_number, google::protobuf::uint64 value) {
+                if (field_number <= kMaxFieldNumber)
+                  varints_[field_number] = value;
+              },
+              [this](int field_number, const boost::string_ref& bytes) {
+                if (field_number <= kMaxFieldNumber)
+                  bytes_[field_number] = bytes;
+              });
+}
+
+boost::string_ref MessageFields::bytes(int field_number) const {
+  if (!has_bytes(field_number))
+    ThrowError(CommonErrors::parsing_error);
+  return *bytes_[field_number];
+}
+
+uint64_t MessageFields::varint(int field_number) const {
+  if (!has_varint(field_number))
+    ThrowError(CommonErrors::parsing_error);
+  return *varints_[field_number];
+}
+
+std::vector<boost::string_ref> GetRepeatedBytesField(const boost::string_ref& serialised_message,
+                                                     int field_number) {
+  std::vector<boost::string_ref> fields;
+  ParseFields(serialised_message, [](int, google::protobuf::uint64) {},
+              [&](int this_field_number, const boost::string_ref& bytes) {
+                if (this_field_number == field_number)
+                  fields.push_back(bytes);
+              });
+  return fields;
 }
 
 }  // namespace detail
@@ -51,17 +258,51 @@ std::string SerialiseMessageWrapper(const TypeErasedMessageWrapper& message_tupl
 
 
 TypeErasedMessageWrapper ParseMessageWrapper(const std::string& serialised_message_wrapper) {
-  protobuf::MessageWrapper proto_message_wrapper;
-  if (!proto_message_wrapper.ParseFromString(serialised_message_wrapper))
+  // Varint-encoded int32 fields are read as 64-bit values, since negative ones are sign-extended.
+  int32_t action(0), source_persona(0), destination_persona(0), payload_encoding(0);
+  int64_t message_id(0);
+  boost::string_ref serialised_contents;
+  int fields_found(0);
+  detail::ParseFields(serialised_message_wrapper,
+      [&](int field_number, google::protobuf::uint64 value) {
+        switch (field_number) {
+          case protobuf::MessageWrapper::kActionFieldNumber:
+            action = static_cast<int32_t>(value);
+            break;
+          case protobuf::MessageWrapper::kSourcePersonaFieldNumber:
+            source_persona = static_cast<int32_t>(value);
+            break;
+          case protobuf::MessageWrapper::kDestinationPersonaFieldNumber:
+            destination_persona = static_cast<int32_t>(value);
+            break;
+          case protobuf::MessageWrapper::kMessageIdFieldNumber:
+            message_id = static_cast<int64_t>(value);
+            break;
+          case protobuf::MessageWrapper::kPayloadEncodingFieldNumber:
+            // Optional, so not recorded in 'fields_found'.
+            payload_encoding = static_cast<int32_t>(value);
+            return;
+          default:
+            return;
+        }
+        fields_found |= (1 << field_number);
+      },
+      [&](int field_number, const boost::string_ref& bytes) {
+        if (field_number == protobuf::MessageWrapper::kSerialisedContentsFieldNumber) {
+          serialised_contents = bytes;
+          fields_found |= (1 << field_number);
+        }
+      });
+
+  // All five fields are required.
+  if (fields_found != 0x3e)
     ThrowError(CommonErrors::parsing_error);
 
-  return std::make_tuple(
-      static_cast<MessageAction>(proto_message_wrapper.action()),
-      detail::SourceTaggedValue(static_cast<Persona>(proto_message_wrapper.source_persona())),
-      detail::DestinationTaggedValue(
-          static_cast<Persona>(proto_message_wrapper.destination_persona())),
-      MessageId(proto_message_wrapper.message_id()),
-      proto_message_wrapper.serialised_contents());
+  return std::make_tuple(static_cast<MessageAction>(action),
+                         detail::SourceTaggedValue(static_cast<Persona>(source_persona)),
+                         detail::DestinationTaggedValue(static_cast<Persona>(destination_persona)),
+                         MessageId(message_id), serialised_contents,
+                         static_cast<PayloadEncoding>(payload_encoding));
 }
 
 }  // namespace nfs
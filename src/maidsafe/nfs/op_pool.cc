@@ -0,0 +1,121 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/op_pool.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace {
+
+// Blocks are rounded up to a multiple of this, so that each is suitably aligned for any op.
+const std::size_t kBlockAlignment(16);
+
+std::size_t RoundedBlockSize(std::size_t block_size) {
+  return (block_size + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+}
+
+}  // unnamed namespace
+
+OpPool::OpPool(std::size_t block_size, std::size_t blocks_per_chunk)
+    : slabs_(std::make_shared<detail::OpSlabs>(block_size, blocks_per_chunk)) {}
+
+OpPool::Stats OpPool::stats() const {
+  return slabs_->stats();
+}
+
+namespace detail {
+
+struct OpSlabs::Impl {
+  explicit Impl(std::size_t blocks_per_chunk_in)
+      : blocks_per_chunk(blocks_per_chunk_in), mutex(), chunks(), free_blocks(nullptr),
+        blocks_in_use(0), heap_allocations(0) {}
+  const std::size_t blocks_per_chunk;
+  mutable std::mutex mutex;
+  std::vector<std::unique_ptr<char[]>> chunks;
+  FreeBlock* free_blocks;
+  uint64_t blocks_in_use, heap_allocations;
+};
+
+OpSlabs::OpSlabs(std::size_t block_size, std::size_t blocks_per_chunk)
+    : kBlockSize_(RoundedBlockSize(std::max(block_size, sizeof(FreeBlock)))),
+      impl_(new Impl(blocks_per_chunk)) {
+  if (block_size == 0 || blocks_per_chunk == 0) {
+    LOG(kError) << "OpPool block size and blocks per chunk must be positive.";
+    ThrowError(CommonErrors::invalid_parameter);
+  }
+}
+
+OpSlabs::~OpSlabs() {}
+
+void* OpSlabs::Allocate(std::size_t size) {
+  if (size > kBlockSize_)
+    return nullptr;
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  if (!impl_->free_blocks) {
+    // Thread the new chunk's blocks onto the free list.
+    std::unique_ptr<char[]> chunk(new char[kBlockSize_ * impl_->blocks_per_chunk]);
+    for (std::size_t i(impl_->blocks_per_chunk); i != 0; --i) {
+      FreeBlock* block(reinterpret_cast<FreeBlock*>(chunk.get() + (i - 1) * kBlockSize_));
+      block->next = impl_->free_blocks;
+      impl_->free_blocks = block;
+    }
+    impl_->chunks.push_back(std::move(chunk));
+  }
+  FreeBlock* block(impl_->free_blocks);
+  impl_->free_blocks = block->next;
+  ++impl_->blocks_in_use;
+  return block;
+}
+
+void OpSlabs::Free(void* block) {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  FreeBlock* free_block(static_cast<FreeBlock*>(block));
+  free_block->next = impl_->free_blocks;
+  impl_->free_blocks = free_block;
+  --impl_->blocks_in_use;
+}
+
+void OpSlabs::AddHeapAllocation() {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  ++impl_->heap_allocations;
+}
+
+OpPool::Stats OpSlabs::stats() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  OpPool::Stats stats;
+  stats.chunks = impl_->chunks.size();
+  stats.blocks_in_use = impl_->blocks_in_use;
+  stats.heap_allocations = impl_->heap_allocations;
+  return stats;
+}
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe
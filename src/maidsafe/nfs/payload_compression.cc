@@ -0,0 +1,224 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/payload_compression.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "zlib.h"
+#ifdef MAIDSAFE_NFS_LZ4
+#include "lz4.h"
+#endif
+
+#include "google/protobuf/io/coded_stream.h"
+
+#include "maidsafe/common/error.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace {
+
+// Content larger than twice this is probed by compressing this many bytes from its middle, so that
+// content which is already compressed or encrypted costs little more than the probe.
+const std::size_t kProbeSize(4096);
+
+// The largest expansion either codec can achieve, used to reject a declared decompressed size which
+// couldn't have been produced from the given compressed bytes.
+const std::size_t kMaxZlibRatio(1032), kMaxLz4Ratio(255), kMaxRatioSlack(64);
+
+std::mutex g_policy_mutex;
+CompressionPolicy g_policy;
+// Copies of the policy's fields which are checked for every outbound message.
+std::atomic<bool> g_enabled(false);
+std::atomic<std::size_t> g_min_size(0);
+
+typedef google::protobuf::io::CodedOutputStream CodedOutputStream;
+
+void AppendSizePrefix(std::size_t size, std::string& buffer) {
+  google::protobuf::uint8 prefix[8];
+  auto prefix_end(CodedOutputStream::WriteVarint32ToArray(
+      static_cast<google::protobuf::uint32>(size), prefix));
+  buffer.append(reinterpret_cast<const char*>(prefix), prefix_end - prefix);
+}
+
+// Appends the compressed form of 'input' to 'output', returning false if it fails or would be
+// larger than 'max_size' bytes.
+bool ZlibCompress(const boost::string_ref& input, int level, std::size_t max_size,
+                  std::string& output) {
+  const std::size_t offset(output.size());
+  uLongf compressed_size(compressBound(static_cast<uLong>(input.size())));
+  output.resize(offset + compressed_size);
+  if (compress2(reinterpret_cast<Bytef*>(&output[offset]), &compressed_size,
+                reinterpret_cast<const Bytef*>(input.data()), static_cast<uLong>(input.size()),
+                level) != Z_OK || compressed_size > max_size) {
+    return false;
+  }
+  output.resize(offset + compressed_size);
+  return true;
+}
+
+#ifdef MAIDSAFE_NFS_LZ4
+bool Lz4Compress(const boost::string_ref& input, std::size_t max_size, std::string& output) {
+  const std::size_t offset(output.size());
+  const int bound(LZ4_compressBound(static_cast<int>(input.size())));
+  output.resize(offset + bound);
+  const int compressed_size(LZ4_compress_default(input.data(), &output[offset],
+                                                 static_cast<int>(input.size()), bound));
+  if (compressed_size <= 0 || static_cast<std::size_t>(compressed_size) > max_size)
+    return false;
+  output.resize(offset + compressed_size);
+  return true;
+}
+#endif
+
+bool Compress(PayloadEncoding encoding, const boost::string_ref& input, int zlib_level,
+              std::size_t max_size, std::string& output) {
+#ifdef MAIDSAFE_NFS_LZ4
+  if (encoding == PayloadEncoding::kLz4)
+    return Lz4Compress(input, max_size, output);
+#else
+  static_cast<void>(encoding);
+#endif
+  return ZlibCompress(input, zlib_level, max_size, output);
+}
+
+std::size_t MaxCompressedSize(std::size_t size, double max_compressed_ratio) {
+  return static_cast<std::size_t>(static_cast<double>(size) * max_compressed_ratio);
+}
+
+}  // unnamed namespace
+
+bool PayloadEncodingAvailable(PayloadEncoding encoding) {
+  switch (encoding) {
+    case PayloadEncoding::kNone:
+    case PayloadEncoding::kZlib:
+      return true;
+    case PayloadEncoding::kLz4:
+#ifdef MAIDSAFE_NFS_LZ4
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return false;
+  }
+}
+
+CompressionPolicy::CompressionPolicy()
+    : enabled(false),
+      encoding(PayloadEncoding::kZlib),
+      min_size(512),
+      max_compressed_ratio(0.875),
+      zlib_level(Z_BEST_SPEED) {}
+
+void SetCompressionPolicy(const CompressionPolicy& policy) {
+  std::lock_guard<std::mutex> lock(g_policy_mutex);
+  g_policy = policy;
+  if (g_policy.encoding == PayloadEncoding::kNone || !PayloadEncodingAvailable(g_policy.encoding))
+    g_policy.encoding = PayloadEncoding::kZlib;
+  g_min_size.store(policy.min_size);
+  g_enabled.store(policy.enabled);
+}
+
+CompressionPolicy GetCompressionPolicy() {
+  std::lock_guard<std::mutex> lock(g_policy_mutex);
+  return g_policy;
+}
+
+namespace detail {
+
+bool CompressionWanted(std::size_t payload_size) {
+  return g_enabled.load() && payload_size >= g_min_size.load();
+}
+
+bool ContentLooksCompressible(const boost::string_ref& content) {
+  if (content.size() <= 2 * kProbeSize)
+    return true;
+  const CompressionPolicy policy(GetCompressionPolicy());
+  const boost::string_ref probe(content.substr((content.size() - kProbeSize) / 2, kProbeSize));
+  std::string compressed;
+  return Compress(policy.encoding, probe, policy.zlib_level,
+                  MaxCompressedSize(kProbeSize, policy.max_compressed_ratio), compressed);
+}
+
+boost::optional<std::string> CompressPayload(const boost::string_ref& payload,
+                                             PayloadEncoding& encoding) {
+  const CompressionPolicy policy(GetCompressionPolicy());
+  std::string compressed;
+  AppendSizePrefix(payload.size(), compressed);
+  const std::size_t max_size(MaxCompressedSize(payload.size(), policy.max_compressed_ratio));
+  if (compressed.size() >= max_size ||
+      !Compress(policy.encoding, payload, policy.zlib_level, max_size - compressed.size(),
+                compressed)) {
+    return boost::none;
+  }
+  encoding = policy.encoding;
+  return compressed;
+}
+
+std::string DecompressPayload(PayloadEncoding encoding,
+                              const boost::string_ref& compressed_payload) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const google::protobuf::uint8*>(compressed_payload.data()),
+      static_cast<int>(compressed_payload.size()));
+  google::protobuf::uint32 size(0);
+  if (!input.ReadVarint32(&size))
+    ThrowError(CommonErrors::parsing_error);
+  const boost::string_ref compressed(compressed_payload.substr(input.CurrentPosition()));
+
+  std::string payload;
+  switch (encoding) {
+    case PayloadEncoding::kZlib: {
+      if (size > kMaxZlibRatio * compressed.size() + kMaxRatioSlack)
+        ThrowError(CommonErrors::parsing_error);
+      payload.resize(size);
+      uLongf payload_size(size);
+      if (uncompress(reinterpret_cast<Bytef*>(&payload[0]), &payload_size,
+                     reinterpret_cast<const Bytef*>(compressed.data()),
+                     static_cast<uLong>(compressed.size())) != Z_OK || payload_size != size) {
+        ThrowError(CommonErrors::parsing_error);
+      }
+      break;
+    }
+#ifdef MAIDSAFE_NFS_LZ4
+    case PayloadEncoding::kLz4: {
+      if (size > kMaxLz4Ratio * compressed.size() + kMaxRatioSlack)
+        ThrowError(CommonErrors::parsing_error);
+      payload.resize(size);
+      if (LZ4_decompress_safe(compressed.data(), &payload[0], static_cast<int>(compressed.size()),
+                              static_cast<int>(size)) != static_cast<int>(size)) {
+        ThrowError(CommonErrors::parsing_error);
+      }
+      break;
+    }
+#endif
+    default:
+      ThrowError(CommonErrors::parsing_error);
+  }
+  return payload;
+}
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,86 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_PROTOBUF_MESSAGE_H_
+#define MAIDSAFE_NFS_PROTOBUF_MESSAGE_H_
+
+#include "boost/optional/optional.hpp"
+#include "boost/utility/in_place_factory.hpp"
+#include "google/protobuf/stubs/common.h"
+
+// From protobuf 3.14, every generated message type can be allocated on an arena without needing
+// 'option cc_enable_arenas' in its .proto file.
+#if GOOGLE_PROTOBUF_VERSION >= 3014000
+#  define MAIDSAFE_NFS_PROTOBUF_ARENAS
+#  include "google/protobuf/arena.h"
+#endif
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace detail {
+
+#ifdef MAIDSAFE_NFS_PROTOBUF_ARENAS
+// Returns the calling thread's codec arena if a CodecArena is current on it, otherwise nullptr.
+google::protobuf::Arena* CurrentProtobufArena();
+#endif
+
+// Holds a protobuf message used while encoding or decoding nfs message contents.  The message is
+// allocated from the current codec arena if there is one (see maidsafe/nfs/codec_arena.h), and is
+// otherwise held in place.
+template<typename ProtobufType>
+class ProtobufMessage {
+ public:
+  ProtobufMessage();
+
+  ProtobufType& operator*() { return *message_; }
+  ProtobufType* operator->() { return message_; }
+
+ private:
+  ProtobufMessage(const ProtobufMessage&);
+  ProtobufMessage(ProtobufMessage&&);
+  ProtobufMessage& operator=(ProtobufMessage);
+
+  boost::optional<ProtobufType> in_place_;
+  ProtobufType* message_;
+};
+
+
+
+// ==================== Implementation =============================================================
+template<typename ProtobufType>
+ProtobufMessage<ProtobufType>::ProtobufMessage() : in_place_(), message_(nullptr) {
+#ifdef MAIDSAFE_NFS_PROTOBUF_ARENAS
+  if (auto arena = CurrentProtobufArena()) {
+    message_ = google::protobuf::Arena::CreateMessage<ProtobufType>(arena);
+    return;
+  }
+#endif
+  in_place_ = boost::in_place();
+  message_ = &*in_place_;
+}
+
+}  // namespace detail
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_PROTOBUF_MESSAGE_H_
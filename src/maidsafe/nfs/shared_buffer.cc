@@ -0,0 +1,72 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/shared_buffer.h"
+
+#include <utility>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+SharedBuffer::SharedBuffer() : content_() {}
+
+SharedBuffer::SharedBuffer(NonEmptyString content)
+    : content_(std::make_shared<const NonEmptyString>(std::move(content))) {}
+
+SharedBuffer::SharedBuffer(const SharedBuffer& other) : content_(other.content_) {}
+
+SharedBuffer::SharedBuffer(SharedBuffer&& other) : content_(std::move(other.content_)) {}
+
+SharedBuffer& SharedBuffer::operator=(SharedBuffer other) {
+  swap(*this, other);
+  return *this;
+}
+
+const NonEmptyString& SharedBuffer::non_empty_string() const {
+  if (!content_) {
+    LOG(kError) << "SharedBuffer is uninitialised.";
+    ThrowError(CommonErrors::uninitialised);
+  }
+  return *content_;
+}
+
+bool operator==(const SharedBuffer& lhs, const SharedBuffer& rhs) {
+  if (lhs.content_ == rhs.content_)
+    return true;
+  if (!lhs.content_ || !rhs.content_)
+    return false;
+  return *lhs.content_ == *rhs.content_;
+}
+
+bool operator!=(const SharedBuffer& lhs, const SharedBuffer& rhs) {
+  return !(lhs == rhs);
+}
+
+void swap(SharedBuffer& lhs, SharedBuffer& rhs) MAIDSAFE_NOEXCEPT {
+  using std::swap;
+  swap(lhs.content_, rhs.content_);
+}
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,70 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/tests/allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "maidsafe/common/config.h"
+
+
+namespace {
+
+std::atomic<bool> g_counting(false);
+std::atomic<uint64_t> g_allocation_count(0);
+
+}  // unnamed namespace
+
+void* operator new(std::size_t size) {
+  if (g_counting.load(std::memory_order_relaxed))
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc(size == 0 ? 1 : size))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) MAIDSAFE_NOEXCEPT {
+  std::free(memory);
+}
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+ScopedAllocationCounter::ScopedAllocationCounter() {
+  g_allocation_count.store(0);
+  g_counting.store(true);
+}
+
+ScopedAllocationCounter::~ScopedAllocationCounter() {
+  g_counting.store(false);
+}
+
+uint64_t ScopedAllocationCounter::count() const {
+  return g_allocation_count.load();
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
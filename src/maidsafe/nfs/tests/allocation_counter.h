@@ -0,0 +1,51 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_TESTS_ALLOCATION_COUNTER_H_
+#define MAIDSAFE_NFS_TESTS_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+// Counts the calls to the global operator new (from any thread) while an instance exists.  The
+// replacement operator new is defined in allocation_counter.cc.  Instances mustn't overlap.
+class ScopedAllocationCounter {
+ public:
+  ScopedAllocationCounter();
+  ~ScopedAllocationCounter();
+  uint64_t count() const;
+
+ private:
+  ScopedAllocationCounter(const ScopedAllocationCounter&);
+  ScopedAllocationCounter(ScopedAllocationCounter&&);
+  ScopedAllocationCounter& operator=(ScopedAllocationCounter);
+};
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_TESTS_ALLOCATION_COUNTER_H_
@@ -0,0 +1,175 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/awaitables.h"
+
+#ifdef MAIDSAFE_NFS_HAS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+// A coroutine which starts eagerly and whose frame is destroyed when it finishes.
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return DetachedTask(); }
+    std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+    std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Stands in for MaidNodeNfs, holding on to the completion handler of each Get and Put.  If
+// 'send_fails' is set, Get throws after registering its handler, as an op whose request couldn't
+// be sent would.
+class FakeClient {
+ public:
+  typedef std::function<void(nfs::Expected<ImmutableData>)> GetHandler;
+  typedef std::function<void(nfs::Expected<void>)> PutHandler;
+
+  FakeClient() : get_handlers(), put_handlers(), cached_data(), send_fails(false) {}
+
+  template<typename Data, typename Executor, typename Handler>
+  void Get(const typename Data::Name& /*data_name*/, Executor& executor, Handler handler,
+           const std::chrono::steady_clock::duration& /*timeout*/) {
+    if (cached_data)
+      return PostCompletion(executor, std::move(handler), nfs::Expected<Data>(*cached_data));
+    get_handlers.push_back([&executor, handler](nfs::Expected<ImmutableData> outcome) {
+                             PostCompletion(executor, handler, std::move(outcome));
+                           });
+    if (send_fails)
+      ThrowError(CommonErrors::invalid_parameter);
+  }
+
+  template<typename Data, typename Executor, typename Handler>
+  void Put(const Data& /*data*/, Executor& executor, Handler handler,
+           const std::chrono::steady_clock::duration& /*timeout*/) {
+    put_handlers.push_back([&executor, handler](nfs::Expected<void> outcome) {
+                             PostCompletion(executor, handler, std::move(outcome));
+                           });
+  }
+
+  std::vector<GetHandler> get_handlers;
+  std::vector<PutHandler> put_handlers;
+  std::unique_ptr<ImmutableData> cached_data;
+  bool send_fails;
+};
+
+DetachedTask GetAndPut(FakeClient& client, const ImmutableData::Name& name,
+                       std::vector<std::string>* events) {
+  boost::optional<ImmutableData> got;
+  try {
+    got = co_await AwaitGet<ImmutableData>(client, name);
+  }
+  catch(const maidsafe_error&) {
+    events->push_back("get threw");
+    co_return;
+  }
+  ImmutableData data(std::move(*got));
+  events->push_back("got " + data.data().string());
+  try {
+    co_await AwaitPut(client, data);
+    events->push_back("put");
+  }
+  catch(const maidsafe_error& error) {
+    events->push_back(error.code() == make_error_code(NfsErrors::timed_out) ? "put timed out" :
+                                                                              "put failed");
+  }
+}
+
+}  // unnamed namespace
+
+TEST(AwaitablesTest, BEH_ResumeFromHandler) {
+  FakeClient client;
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  std::vector<std::string> events;
+  GetAndPut(client, data.name(), &events);
+  // Suspended awaiting the Get.
+  ASSERT_EQ(1U, client.get_handlers.size());
+  EXPECT_TRUE(events.empty());
+
+  // Resume on another thread, as the response would arrive on a routing thread.
+  std::thread responder([&] { client.get_handlers.front()(nfs::Expected<ImmutableData>(data)); });
+  responder.join();
+  ASSERT_EQ(1U, events.size());
+  EXPECT_EQ("got " + data.data().string(), events.front());
+  ASSERT_EQ(1U, client.put_handlers.size());
+
+  client.put_handlers.front()(nfs::Expected<void>(MakeError(NfsErrors::timed_out)));
+  ASSERT_EQ(2U, events.size());
+  EXPECT_EQ("put timed out", events.back());
+}
+
+TEST(AwaitablesTest, BEH_CompleteWithoutSuspending) {
+  // A cache hit completes the Get before 'await_suspend' returns.
+  FakeClient client;
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  client.cached_data.reset(new ImmutableData(data));
+  std::vector<std::string> events;
+  GetAndPut(client, data.name(), &events);
+  ASSERT_EQ(1U, events.size());
+  EXPECT_EQ("got " + data.data().string(), events.front());
+  ASSERT_EQ(1U, client.put_handlers.size());
+  client.put_handlers.front()(nfs::Expected<void>());
+  ASSERT_EQ(2U, events.size());
+  EXPECT_EQ("put", events.back());
+}
+
+TEST(AwaitablesTest, BEH_StartThrowsAfterRegistering) {
+  FakeClient client;
+  client.send_fails = true;
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  std::vector<std::string> events;
+  GetAndPut(client, data.name(), &events);
+  // The coroutine has finished, and so its frame and the awaitable have been destroyed.
+  ASSERT_EQ(1U, events.size());
+  EXPECT_EQ("get threw", events.front());
+  ASSERT_EQ(1U, client.get_handlers.size());
+
+  // The op still times out later, which mustn't resume the finished coroutine.
+  client.get_handlers.front()(nfs::Expected<ImmutableData>(MakeError(NfsErrors::timed_out)));
+  EXPECT_EQ(1U, events.size());
+  EXPECT_TRUE(client.put_handlers.empty());
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_HAS_COROUTINES
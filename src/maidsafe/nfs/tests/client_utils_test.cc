@@ -0,0 +1,136 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/client_utils.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/expected.h"
+#include "maidsafe/nfs/op_pool.h"
+#include "maidsafe/nfs/tests/allocation_counter.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+// Queues posted functors until 'Run' is called.
+class FakeExecutor {
+ public:
+  FakeExecutor() : functors_() {}
+  void post(std::function<void()> functor) { functors_.push_back(functor); }
+  std::size_t Run() {
+    std::size_t count(functors_.size());
+    for (auto& functor : functors_)
+      functor();
+    functors_.clear();
+    return count;
+  }
+
+ private:
+  std::vector<std::function<void()>> functors_;
+};
+
+struct RecordOutcome {
+  explicit RecordOutcome(std::unique_ptr<nfs::Expected<ImmutableData>>* outcome_in)
+      : outcome(outcome_in) {}
+  void operator()(nfs::Expected<ImmutableData> result) const {
+    outcome->reset(new nfs::Expected<ImmutableData>(std::move(result)));
+  }
+  std::unique_ptr<nfs::Expected<ImmutableData>>* outcome;
+};
+
+struct ToGetResult {
+  nfs::Expected<ImmutableData> operator()(const DataNameAndContentOrReturnCode& result) const {
+    return GetResult<ImmutableData>(result);
+  }
+};
+
+}  // unnamed namespace
+
+TEST(ClientUtilsTest, BEH_CompletionOpSuccess) {
+  FakeExecutor executor;
+  std::unique_ptr<nfs::Expected<ImmutableData>> outcome;
+  nfs::OpPool op_pool;
+  // The first op carves a chunk out of the heap; once it's released, its block is reused.
+  MakeCompletionOp<DataNameAndContentOrReturnCode>(op_pool, 1, executor, RecordOutcome(&outcome),
+                                                   ToGetResult());
+  std::shared_ptr<nfs::OpData<DataNameAndContentOrReturnCode>> op_data;
+  {
+    nfs::test::ScopedAllocationCounter allocation_counter;
+    op_data = MakeCompletionOp<DataNameAndContentOrReturnCode>(op_pool, 1, executor,
+                                                               RecordOutcome(&outcome),
+                                                               ToGetResult());
+    EXPECT_EQ(0U, allocation_counter.count());
+  }
+  EXPECT_EQ(0U, op_pool.stats().heap_allocations);
+
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  EXPECT_TRUE(op_data->HandleResponseContents(DataNameAndContentOrReturnCode(data)));
+  // The handler is only invoked via the executor.
+  EXPECT_FALSE(outcome);
+  EXPECT_EQ(1U, executor.Run());
+  ASSERT_TRUE(outcome);
+  ASSERT_TRUE(outcome->has_value());
+  EXPECT_EQ(data.name(), (*outcome)->name());
+  EXPECT_EQ(data.data(), outcome->value().data());
+
+  EXPECT_FALSE(op_data->HandleResponseContents(DataNameAndContentOrReturnCode(data)));
+  EXPECT_EQ(0U, executor.Run());
+}
+
+TEST(ClientUtilsTest, BEH_CompletionOpFailure) {
+  FakeExecutor executor;
+  std::unique_ptr<nfs::Expected<ImmutableData>> outcome;
+  nfs::OpPool op_pool;
+  auto op_data(MakeCompletionOp<DataNameAndContentOrReturnCode>(op_pool, 1, executor,
+                                                                RecordOutcome(&outcome),
+                                                                ToGetResult()));
+  EXPECT_TRUE(op_data->HandleTimeout(DataNameAndContentOrReturnCode()));
+  EXPECT_EQ(1U, executor.Run());
+  ASSERT_TRUE(outcome);
+  EXPECT_FALSE(*outcome);
+  EXPECT_EQ(make_error_code(CommonErrors::uninitialised), outcome->error().code());
+  EXPECT_THROW(outcome->value(), maidsafe_error);
+}
+
+TEST(ClientUtilsTest, BEH_PutResult) {
+  EXPECT_FALSE(PutResult(DataPmidHintAndReturnCode()));
+  EXPECT_EQ(make_error_code(NfsErrors::timed_out),
+            PutResult(DataPmidHintAndReturnCode()).error().code());
+  EXPECT_NO_THROW(nfs::Expected<void>().value());
+  EXPECT_THROW(nfs::Expected<void>(MakeError(CommonErrors::invalid_parameter)).value(),
+               maidsafe_error);
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
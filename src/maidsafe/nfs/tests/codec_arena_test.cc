@@ -0,0 +1,180 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/codec_arena.h"
+
+#include <cstdint>
+#include <string>
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/client/messages.h"
+#include "maidsafe/nfs/tests/allocation_counter.h"
+#include "maidsafe/nfs/vault/messages.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+namespace {
+
+struct AllocationCounts {
+  AllocationCounts() : serialise(0), parse(0) {}
+  uint64_t serialise, parse;
+};
+
+// Counts the allocations made serialising 'message', and parsing it back and decoding its contents,
+// in the current codec mode.
+template<typename Message>
+AllocationCounts CountAllocations(const Message& message) {
+  // Warm up, so that one-off allocations (e.g. of the thread's codec arena) aren't counted.
+  auto serialised_message(message.Serialise());
+  EXPECT_EQ(message, Message(ParseMessageWrapper(serialised_message)));
+
+  AllocationCounts counts;
+  {
+    ScopedAllocationCounter allocation_counter;
+    serialised_message = message.Serialise();
+    counts.serialise = allocation_counter.count();
+  }
+  auto parsed_message_wrapper(ParseMessageWrapper(serialised_message));
+  {
+    ScopedAllocationCounter allocation_counter;
+    {
+      Message parsed_message(parsed_message_wrapper);
+      EXPECT_TRUE(parsed_message.contents.get() != nullptr);
+    }
+    counts.parse = allocation_counter.count();
+  }
+  return counts;
+}
+
+template<typename Message>
+void CompareCodecModes(const std::string& message_type, const Message& message) {
+  SetCodecMode(CodecMode::kProtobuf);
+  auto protobuf_counts(CountAllocations(message));
+  SetCodecMode(CodecMode::kProtobufArena);
+  auto arena_counts(CountAllocations(message));
+  SetCodecMode(CodecMode::kDirect);
+  auto direct_counts(CountAllocations(message));
+
+  LOG(kInfo) << message_type << " allocations (protobuf/arena/direct) - serialise: "
+             << protobuf_counts.serialise << '/' << arena_counts.serialise << '/'
+             << direct_counts.serialise << ", parse: " << protobuf_counts.parse << '/'
+             << arena_counts.parse << '/' << direct_counts.parse;
+  if (ArenaCodecAvailable()) {
+    EXPECT_LE(arena_counts.serialise, protobuf_counts.serialise) << message_type;
+    EXPECT_LT(arena_counts.parse, protobuf_counts.parse) << message_type;
+  } else {
+    EXPECT_EQ(protobuf_counts.serialise, arena_counts.serialise) << message_type;
+    EXPECT_EQ(protobuf_counts.parse, arena_counts.parse) << message_type;
+  }
+  EXPECT_LT(direct_counts.serialise, protobuf_counts.serialise) << message_type;
+  EXPECT_LT(direct_counts.parse, protobuf_counts.parse) << message_type;
+}
+
+nfs_client::DataNameAndReturnCode NotFound(const ImmutableData::Name& name) {
+  return nfs_client::DataNameAndReturnCode(
+      nfs_vault::DataName(name), nfs_client::ReturnCode(CommonErrors::no_such_element));
+}
+
+}  // unnamed namespace
+
+TEST(CodecArenaTest, BEH_NestedScopesShareArena) {
+  SetCodecMode(CodecMode::kProtobufArena);
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  GetResponse get_response((GetResponse::Contents(data)));
+  std::string serialised_get_response;
+  {
+    CodecArena codec_arena;
+    // Serialise opens a nested scope, which mustn't free the outer scope's protobuf messages.
+    serialised_get_response = get_response.Serialise();
+    EXPECT_EQ(serialised_get_response, get_response.Serialise());
+  }
+  SetCodecMode(CodecMode::kDirect);
+  EXPECT_EQ(serialised_get_response, get_response.Serialise());
+  EXPECT_EQ(get_response, GetResponse(ParseMessageWrapper(serialised_get_response)));
+}
+
+TEST(CodecArenaTest, BEH_MalformedContentsReleaseArena) {
+  SetCodecMode(CodecMode::kProtobufArena);
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  const std::string serialised_get_response(detail::SerialiseMessageWrapper(
+      MessageAction::kGetResponse, Persona::kDataManager, Persona::kMaidNode,
+      MessageId(RandomInt32()), RandomString(100)));
+  GetResponse get_response(ParseMessageWrapper(serialised_get_response));
+  EXPECT_THROW(*get_response.contents, std::exception);
+
+  // The arena must have been released by the failed parse for this to use it again.
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  GetResponse valid_get_response((GetResponse::Contents(data)));
+  auto serialised_valid_get_response(valid_get_response.Serialise());
+  EXPECT_EQ(valid_get_response, GetResponse(ParseMessageWrapper(serialised_valid_get_response)));
+  SetCodecMode(CodecMode::kDirect);
+}
+
+TEST(CodecArenaTest, BEH_AllocationsPerMessageType) {
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  const MessageId message_id(RandomInt32());
+
+  CompareCodecModes("GetRequest (DataName)",
+                    GetRequestFromMaidNodeToDataManager(
+                        message_id, nfs_vault::DataName(data.name())));
+  CompareCodecModes("PutRequest (DataAndPmidHint)",
+                    PutRequestFromMaidNodeToMaidManager(
+                        message_id, nfs_vault::DataAndPmidHint(
+                                        nfs_vault::DataName(data.name()), data.Serialise().data,
+                                        Identity(RandomString(crypto::SHA512::DIGESTSIZE)))));
+  CompareCodecModes("GetResponse (DataNameAndContentOrReturnCode with content)",
+                    GetResponseFromDataManagerToMaidNode(
+                        message_id, nfs_client::DataNameAndContentOrReturnCode(data)));
+
+  nfs_client::DataNameAndContentOrReturnCode not_found;
+  not_found.data_name_and_return_code = NotFound(data.name());
+  CompareCodecModes("GetResponse (DataNameAndContentOrReturnCode with return code)",
+                    GetResponseFromDataManagerToMaidNode(message_id, not_found));
+
+  nfs_client::DataPmidHintAndReturnCode put_failure;
+  put_failure.data_and_pmid_hint = nfs_vault::DataAndPmidHint(
+      nfs_vault::DataName(data.name()), data.Serialise().data,
+      Identity(RandomString(crypto::SHA512::DIGESTSIZE)));
+  put_failure.return_code = nfs_client::ReturnCode(CommonErrors::cannot_exceed_limit);
+  CompareCodecModes("PutResponse (DataPmidHintAndReturnCode)",
+                    PutResponseFromMaidManagerToMaidNode(message_id, put_failure));
+
+  nfs_client::StructuredDataNameAndContentOrReturnCode versions_not_found;
+  versions_not_found.data_name_and_return_code = NotFound(data.name());
+  CompareCodecModes("GetVersionsResponse (StructuredDataNameAndContentOrReturnCode)",
+                    GetVersionsResponseFromVersionManagerToMaidNode(message_id,
+                                                                    versions_not_found));
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
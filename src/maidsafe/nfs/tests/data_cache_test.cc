@@ -0,0 +1,129 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/data_cache.h"
+
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+#include "maidsafe/passport/types.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+TEST(DataCacheTest, BEH_InvalidParameters) {
+  EXPECT_THROW(DataCache(DataCache::Config(1024, 0)), maidsafe_error);
+  EXPECT_THROW(DataCache(DataCache::Config(1024, -1)), maidsafe_error);
+}
+
+TEST(DataCacheTest, BEH_Disabled) {
+  DataCache data_cache((DataCache::Config()));
+  EXPECT_FALSE(data_cache.enabled());
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  data_cache.Put(data);
+  EXPECT_FALSE(data_cache.Get<ImmutableData>(data.name()));
+  auto stats(data_cache.stats());
+  EXPECT_EQ(0U, stats.hits + stats.misses + stats.insertions + stats.entry_count);
+}
+
+TEST(DataCacheTest, BEH_HitsAndMisses) {
+  DataCache data_cache(DataCache::Config(1024 * 1024, 4));
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  EXPECT_FALSE(data_cache.Get<ImmutableData>(data.name()));
+  data_cache.Put(data);
+  data_cache.Put(data);
+  auto cached(data_cache.Get<ImmutableData>(data.name()));
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(data.name(), cached->name());
+  EXPECT_EQ(data.Serialise().data, cached->Serialise().data);
+
+  // Non-cacheable types are neither admitted nor counted.
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  passport::PublicMaid public_maid(maid);
+  data_cache.Put(public_maid);
+  EXPECT_FALSE(data_cache.Get<passport::PublicMaid>(public_maid.name()));
+
+  auto stats(data_cache.stats());
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.insertions);
+  EXPECT_EQ(1U, stats.entry_count);
+  EXPECT_EQ(0U, stats.evictions);
+}
+
+TEST(DataCacheTest, BEH_PutSerialisedSharesContent) {
+  DataCache data_cache(DataCache::Config(1024 * 1024, 4));
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  nfs::SharedBuffer content(data.Serialise().data);
+  data_cache.PutSerialised<ImmutableData>(data.name(), content);
+  EXPECT_EQ(2, content.use_count());
+  auto cached(data_cache.Get<ImmutableData>(data.name()));
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(data.Serialise().data, cached->Serialise().data);
+  EXPECT_EQ(2, content.use_count());
+
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  passport::PublicMaid public_maid(maid);
+  data_cache.PutSerialised<passport::PublicMaid>(
+      public_maid.name(), nfs::SharedBuffer(public_maid.Serialise().data));
+  EXPECT_EQ(1U, data_cache.stats().insertions);
+}
+
+TEST(DataCacheTest, BEH_EvictLeastRecentlyUsed) {
+  // A single shard with room for a few small chunks, so that eviction order is deterministic.
+  const uint64_t kMaxBytes(4096);
+  DataCache data_cache(DataCache::Config(kMaxBytes, 1));
+  std::vector<ImmutableData> chunks;
+  for (int i(0); i != 40; ++i)
+    chunks.push_back(ImmutableData(NonEmptyString(RandomString(200))));
+
+  data_cache.Put(chunks[0]);
+  for (std::size_t i(1); i != chunks.size(); ++i) {
+    data_cache.Put(chunks[i]);
+    // Keep the first chunk recently used.
+    EXPECT_TRUE(data_cache.Get<ImmutableData>(chunks[0].name()));
+  }
+  EXPECT_FALSE(data_cache.Get<ImmutableData>(chunks[1].name()));
+  EXPECT_TRUE(data_cache.Get<ImmutableData>(chunks.back().name()));
+
+  auto stats(data_cache.stats());
+  EXPECT_LE(stats.bytes, kMaxBytes);
+  EXPECT_GT(stats.evictions, 0U);
+  EXPECT_EQ(chunks.size(), stats.insertions);
+  EXPECT_EQ(stats.insertions - stats.evictions, stats.entry_count);
+
+  // Content larger than a shard's share is never admitted.
+  ImmutableData large_chunk(NonEmptyString(RandomString(kMaxBytes)));
+  data_cache.Put(large_chunk);
+  EXPECT_FALSE(data_cache.Get<ImmutableData>(large_chunk.name()));
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
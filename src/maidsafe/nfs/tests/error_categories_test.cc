@@ -0,0 +1,124 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/error_categories.h"
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/nfs/client/messages.h"
+#include "maidsafe/nfs/client/messages.pb.h"
+#include "maidsafe/nfs/tests/scoped_error_category_ids_only.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+namespace {
+
+std::vector<maidsafe_error> OneErrorPerCategory() {
+  std::vector<maidsafe_error> errors;
+  errors.push_back(MakeError(CommonErrors::no_such_element));
+  errors.push_back(MakeError(AsymmErrors::keys_generation_error));
+  errors.push_back(MakeError(PassportErrors::id_already_exists));
+  errors.push_back(MakeError(NfsErrors::failed_to_get_data));
+  errors.push_back(MakeError(RoutingErrors::timed_out));
+  errors.push_back(MakeError(DriveErrors::no_drive_letter_available));
+  errors.push_back(MakeError(VaultErrors::failed_to_join_network));
+  errors.push_back(MakeError(LifeStuffErrors::login_failure));
+  return errors;
+}
+
+}  // unnamed namespace
+
+TEST(ErrorCategoriesTest, BEH_RegisteredCategories) {
+  EXPECT_EQ(ErrorCategoryId::kCommon, *GetErrorCategoryId(GetCommonCategory()));
+  EXPECT_EQ(ErrorCategoryId::kNfs, *GetErrorCategoryId(GetNfsCategory()));
+  EXPECT_EQ(ErrorCategoryId::kLifeStuff, *GetErrorCategoryId(GetLifeStuffCategory()));
+  for (const auto& error : OneErrorPerCategory()) {
+    const auto category_id(GetErrorCategoryId(error.code().category()));
+    ASSERT_TRUE(static_cast<bool>(category_id));
+    EXPECT_EQ(error.code(), MakeErrorFromCategory(static_cast<uint32_t>(*category_id),
+                                                  error.code().value()).code());
+    EXPECT_EQ(error.code(), MakeErrorFromCategoryName(error.code().category().name(),
+                                                      error.code().value()).code());
+  }
+  EXPECT_FALSE(GetErrorCategoryId(std::generic_category()));
+  EXPECT_THROW(MakeErrorFromCategory(0, 1), maidsafe_error);
+  EXPECT_THROW(MakeErrorFromCategory(9, 1), maidsafe_error);
+  EXPECT_THROW(MakeErrorFromCategoryName("unknown", 1), maidsafe_error);
+}
+
+TEST(ErrorCategoriesTest, BEH_ReturnCodeEncoding) {
+  // By default, the category's name is sent alongside its ID for peers which predate the registry.
+  ASSERT_FALSE(GetErrorCategoryIdsOnly());
+  for (const auto& error : OneErrorPerCategory()) {
+    nfs_client::ReturnCode return_code(error);
+    const auto serialised(return_code.Serialise());
+    nfs_client::protobuf::ReturnCode parsed;
+    ASSERT_TRUE(parsed.ParseFromString(serialised));
+    EXPECT_EQ(std::string(error.code().category().name()), parsed.error_category_name());
+    EXPECT_EQ(static_cast<uint32_t>(*GetErrorCategoryId(error.code().category())),
+              parsed.error_category_id());
+    EXPECT_EQ(return_code, nfs_client::ReturnCode(serialised));
+  }
+
+  {
+    ScopedErrorCategoryIdsOnly ids_only(true);
+    for (const auto& error : OneErrorPerCategory()) {
+      nfs_client::ReturnCode return_code(error);
+      const auto serialised(return_code.Serialise());
+      // A tag and a one-byte varint for each of the value and the category ID.
+      EXPECT_EQ(4U, serialised.size());
+      EXPECT_EQ(return_code, nfs_client::ReturnCode(serialised));
+    }
+
+    // Unregistered categories can only be sent by name.
+    nfs_client::ReturnCode unregistered(
+        maidsafe_error(std::make_error_code(std::errc::invalid_argument)));
+    nfs_client::protobuf::ReturnCode parsed;
+    ASSERT_TRUE(parsed.ParseFromString(unregistered.Serialise()));
+    EXPECT_EQ(std::string(std::generic_category().name()), parsed.error_category_name());
+    EXPECT_FALSE(parsed.has_error_category_id());
+  }
+
+  // Return codes from peers which only send the category's name are still parsed.
+  nfs_client::protobuf::ReturnCode proto_return_code;
+  proto_return_code.set_error_value(static_cast<int>(NfsErrors::timed_out));
+  proto_return_code.set_error_category_name(GetNfsCategory().name());
+  EXPECT_EQ(make_error_code(NfsErrors::timed_out),
+            nfs_client::ReturnCode(proto_return_code.SerializeAsString()).value.code());
+
+  proto_return_code.clear_error_category_name();
+  EXPECT_THROW(nfs_client::ReturnCode(proto_return_code.SerializeAsString()), maidsafe_error);
+  proto_return_code.set_error_category_id(100);
+  EXPECT_THROW(nfs_client::ReturnCode(proto_return_code.SerializeAsString()), maidsafe_error);
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,205 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/get_many.h"
+
+#include <chrono>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/client/messages.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+namespace {
+
+// Records each request sent, or throws for those attempts listed in 'failing_attempts'.
+struct FakeDispatcher {
+  FakeDispatcher() : requests(), attempts(0), failing_attempts() {}
+  template<typename Data>
+  void SendGetRequest(nfs::MessageId message_id, const typename Data::Name& data_name) {
+    if (failing_attempts.count(attempts++) != 0)
+      ThrowError(CommonErrors::unable_to_handle_request);
+    requests.push_back(std::make_pair(message_id, data_name.value));
+  }
+  std::vector<std::pair<nfs::MessageId, Identity>> requests;
+  std::size_t attempts;
+  std::set<std::size_t> failing_attempts;
+};
+
+}  // unnamed namespace
+
+class GetManyTest : public testing::Test {
+ protected:
+  GetManyTest()
+      : asio_service_(1),
+        data_cache_(DataCache::Config(1024 * 1024, 4)),
+        in_flight_gets_(),
+        op_pool_(),
+        get_ops_(asio_service_),
+        dispatcher_() {}
+
+  std::vector<boost::future<ImmutableData>> GetMany(
+      const std::vector<ImmutableData>& chunks, int max_in_flight,
+      const std::chrono::steady_clock::duration& timeout = std::chrono::seconds(10)) {
+    std::vector<ImmutableData::Name> names;
+    for (const auto& chunk : chunks)
+      names.push_back(chunk.name());
+    return PipelinedGetMany<ImmutableData>(names, timeout, max_in_flight, data_cache_,
+                                           in_flight_gets_, op_pool_, get_ops_, dispatcher_);
+  }
+
+  // Responds to the request at 'index' with the chunk it asked for.
+  void Respond(std::size_t index, const std::vector<ImmutableData>& chunks) {
+    const auto& request(dispatcher_.requests.at(index));
+    for (const auto& chunk : chunks) {
+      if (chunk.name().value == request.second) {
+        get_ops_.AddResponse(request.first, DataNameAndContentOrReturnCode(chunk));
+        return;
+      }
+    }
+    FAIL() << "No chunk for request " << index;
+  }
+
+  AsioService asio_service_;
+  DataCache data_cache_;
+  InFlightGets in_flight_gets_;
+  nfs::OpPool op_pool_;
+  nfs::PendingOps<DataNameAndContentOrReturnCode> get_ops_;
+  FakeDispatcher dispatcher_;
+};
+
+TEST_F(GetManyTest, BEH_InvalidParameters) {
+  EXPECT_THROW(GetMany(std::vector<ImmutableData>(), 0), maidsafe_error);
+}
+
+TEST_F(GetManyTest, BEH_PipelinedWithinWindow) {
+  const int kMaxInFlight(4);
+  std::vector<ImmutableData> chunks;
+  for (int i(0); i != 10; ++i)
+    chunks.push_back(ImmutableData(NonEmptyString(RandomString(100))));
+
+  auto futures(GetMany(chunks, kMaxInFlight));
+  ASSERT_EQ(chunks.size(), futures.size());
+  EXPECT_EQ(kMaxInFlight, dispatcher_.requests.size());
+
+  // Each response allows one further request to be sent.
+  for (std::size_t i(0); i != chunks.size(); ++i) {
+    Respond(i, chunks);
+    EXPECT_EQ(std::min(chunks.size(), i + 1 + kMaxInFlight), dispatcher_.requests.size());
+  }
+  for (std::size_t i(0); i != chunks.size(); ++i) {
+    ASSERT_TRUE(futures[i].is_ready());
+    EXPECT_EQ(chunks[i].name(), futures[i].get().name());
+  }
+  EXPECT_EQ(0U, in_flight_gets_.size());
+}
+
+TEST_F(GetManyTest, BEH_CachedAndDuplicateNames) {
+  ImmutableData cached_chunk(NonEmptyString(RandomString(100)));
+  ImmutableData chunk(NonEmptyString(RandomString(100)));
+  data_cache_.Put(cached_chunk);
+
+  std::vector<ImmutableData> chunks;
+  chunks.push_back(cached_chunk);
+  chunks.push_back(chunk);
+  chunks.push_back(chunk);
+  auto futures(GetMany(chunks, 8));
+  ASSERT_EQ(3U, futures.size());
+  EXPECT_TRUE(futures[0].is_ready());
+  ASSERT_EQ(1U, dispatcher_.requests.size());
+  EXPECT_FALSE(futures[1].is_ready());
+
+  Respond(0, chunks);
+  for (auto& future : futures) {
+    ASSERT_TRUE(future.is_ready());
+    EXPECT_NO_THROW(future.get());
+  }
+  EXPECT_EQ(1U, in_flight_gets_.coalesced_count());
+}
+
+TEST_F(GetManyTest, BEH_BatchTimeoutSendsNoFurtherRequests) {
+  const int kMaxInFlight(2);
+  std::vector<ImmutableData> chunks;
+  for (int i(0); i != 6; ++i)
+    chunks.push_back(ImmutableData(NonEmptyString(RandomString(100))));
+
+  auto futures(GetMany(chunks, kMaxInFlight, std::chrono::milliseconds(100)));
+  EXPECT_EQ(kMaxInFlight, dispatcher_.requests.size());
+  for (auto& future : futures) {
+    ASSERT_EQ(boost::future_status::ready, future.wait_for(boost::chrono::seconds(10)));
+    EXPECT_THROW(future.get(), maidsafe_error);
+  }
+  // The ops resolved by the batch timeout don't each send the next request.
+  EXPECT_EQ(kMaxInFlight, dispatcher_.requests.size());
+  EXPECT_EQ(0U, in_flight_gets_.size());
+}
+
+TEST_F(GetManyTest, BEH_FailedSendMovesOnToNextRequest) {
+  const int kMaxInFlight(2);
+  std::vector<ImmutableData> chunks;
+  for (int i(0); i != 6; ++i)
+    chunks.push_back(ImmutableData(NonEmptyString(RandomString(100))));
+
+  // The second and third requests fail to send, so the fourth takes their place in the window.
+  dispatcher_.failing_attempts.insert(1);
+  dispatcher_.failing_attempts.insert(2);
+  auto futures(GetMany(chunks, kMaxInFlight));
+  ASSERT_EQ(chunks.size(), futures.size());
+  ASSERT_EQ(kMaxInFlight, dispatcher_.requests.size());
+  EXPECT_EQ(chunks[0].name().value, dispatcher_.requests[0].second);
+  EXPECT_EQ(chunks[3].name().value, dispatcher_.requests[1].second);
+  for (std::size_t i(1); i != 3; ++i) {
+    ASSERT_TRUE(futures[i].is_ready());
+    try {
+      futures[i].get();
+      ADD_FAILURE() << "Expected an error for chunk " << i;
+    }
+    catch(const maidsafe_error& error) {
+      EXPECT_EQ(make_error_code(CommonErrors::unable_to_handle_request), error.code());
+    }
+  }
+
+  for (std::size_t i(0); i != chunks.size() - 2; ++i)
+    Respond(i, chunks);
+  EXPECT_EQ(chunks.size() - 2, dispatcher_.requests.size());
+  for (std::size_t i(0); i != chunks.size(); ++i) {
+    if (i == 1 || i == 2)
+      continue;
+    ASSERT_TRUE(futures[i].is_ready());
+    EXPECT_EQ(chunks[i].name(), futures[i].get().name());
+  }
+  EXPECT_EQ(0U, in_flight_gets_.size());
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
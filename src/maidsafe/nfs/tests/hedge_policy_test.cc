@@ -0,0 +1,84 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/hedge_policy.h"
+
+#include <chrono>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+TEST(HedgePolicyTest, BEH_Delay) {
+  HedgePolicy::Config config;
+  config.delay_fraction = 0.25;
+  HedgePolicy hedge_policy(config);
+  EXPECT_EQ(std::chrono::steady_clock::duration(std::chrono::milliseconds(2500)),
+            hedge_policy.Delay(std::chrono::seconds(10),
+                               std::chrono::steady_clock::duration::zero()));
+  EXPECT_EQ(std::chrono::steady_clock::duration(std::chrono::milliseconds(300)),
+            hedge_policy.Delay(std::chrono::seconds(10), std::chrono::milliseconds(300)));
+  EXPECT_EQ(std::chrono::steady_clock::duration(std::chrono::milliseconds(2500)),
+            hedge_policy.Delay(std::chrono::seconds(10), std::chrono::seconds(5)));
+}
+
+TEST(HedgePolicyTest, BEH_Budget) {
+  HedgePolicy::Config config;
+  EXPECT_FALSE(HedgePolicy(config).enabled());
+  config.max_hedges = 1;
+  config.budget_percent = 10.0;
+  HedgePolicy hedge_policy(config);
+  EXPECT_TRUE(hedge_policy.enabled());
+  EXPECT_FALSE(hedge_policy.TryAddHedge());
+  for (int i(0); i != 20; ++i)
+    hedge_policy.AddRequest();
+  EXPECT_TRUE(hedge_policy.TryAddHedge());
+  EXPECT_TRUE(hedge_policy.TryAddHedge());
+  EXPECT_FALSE(hedge_policy.TryAddHedge());
+  hedge_policy.AddHedgeWin();
+
+  const auto stats(hedge_policy.stats());
+  EXPECT_EQ(20U, stats.requests);
+  EXPECT_EQ(2U, stats.hedges);
+  EXPECT_EQ(2U, stats.hedges_over_budget);
+  EXPECT_EQ(1U, stats.hedge_wins);
+}
+
+TEST(HedgePolicyTest, BEH_InvalidConfig) {
+  HedgePolicy::Config config;
+  config.max_hedges = -1;
+  EXPECT_THROW(HedgePolicy hedge_policy(config), maidsafe_error);
+  config = HedgePolicy::Config();
+  config.delay_fraction = 0.0;
+  EXPECT_THROW(HedgePolicy hedge_policy(config), maidsafe_error);
+  config = HedgePolicy::Config();
+  config.budget_percent = 101.0;
+  EXPECT_THROW(HedgePolicy hedge_policy(config), maidsafe_error);
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,111 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/in_flight_gets.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/client/data_cache.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+TEST(InFlightGetsTest, BEH_JoinAndResolve) {
+  InFlightGets in_flight_gets;
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  const std::string key(DataCache::Key(ImmutableData::Tag::kValue, data.name().value));
+  const std::string other_key(DataCache::Key(ImmutableData::Tag::kValue,
+                                             Identity(RandomString(64))));
+  int call_count(0);
+  auto functor([&](const DataNameAndContentOrReturnCode& result) {
+                 ++call_count;
+                 ASSERT_TRUE(result.data);
+                 EXPECT_EQ(data.name().value, result.data->name.raw_name);
+               });
+
+  EXPECT_FALSE(in_flight_gets.Join(key, functor));
+  EXPECT_TRUE(in_flight_gets.Join(key, functor));
+  EXPECT_TRUE(in_flight_gets.Join(key, functor));
+  EXPECT_FALSE(in_flight_gets.Join(other_key, [](const DataNameAndContentOrReturnCode&) {}));
+  EXPECT_EQ(2U, in_flight_gets.size());
+  EXPECT_EQ(2U, in_flight_gets.coalesced_count());
+
+  in_flight_gets.Resolve(key, DataNameAndContentOrReturnCode(data));
+  EXPECT_EQ(3, call_count);
+  EXPECT_EQ(1U, in_flight_gets.size());
+
+  // Resolving again is a no-op, and a later Join starts a new Get.
+  in_flight_gets.Resolve(key, DataNameAndContentOrReturnCode(data));
+  EXPECT_EQ(3, call_count);
+  EXPECT_FALSE(in_flight_gets.Join(key, functor));
+}
+
+TEST(InFlightGetsTest, BEH_JoinFromFunctor) {
+  InFlightGets in_flight_gets;
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  const std::string key(DataCache::Key(ImmutableData::Tag::kValue, data.name().value));
+  bool started_new_get(false);
+  in_flight_gets.Join(key, [&](const DataNameAndContentOrReturnCode&) {
+                             started_new_get = !in_flight_gets.Join(
+                                 key, [](const DataNameAndContentOrReturnCode&) {});
+                           });
+  in_flight_gets.Resolve(key, DataNameAndContentOrReturnCode(data));
+  EXPECT_TRUE(started_new_get);
+  EXPECT_EQ(1U, in_flight_gets.size());
+}
+
+TEST(InFlightGetsTest, FUNC_ConcurrentJoins) {
+  InFlightGets in_flight_gets;
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  const std::string key(DataCache::Key(ImmutableData::Tag::kValue, data.name().value));
+  const int kThreadCount(8), kJoinsPerThread(1000);
+  std::atomic<int> new_get_count(0), call_count(0);
+  std::vector<std::thread> threads;
+  for (int i(0); i != kThreadCount; ++i) {
+    threads.push_back(std::thread([&] {
+      for (int j(0); j != kJoinsPerThread; ++j) {
+        if (!in_flight_gets.Join(key, [&](const DataNameAndContentOrReturnCode&) {
+                                        ++call_count;
+                                      }))
+          ++new_get_count;
+      }
+    }));
+  }
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_EQ(1, new_get_count);
+  in_flight_gets.Resolve(key, DataNameAndContentOrReturnCode(data));
+  EXPECT_EQ(kThreadCount * kJoinsPerThread, call_count);
+}
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
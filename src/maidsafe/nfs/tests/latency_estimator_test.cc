@@ -0,0 +1,186 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/latency_estimator.h"
+
+#include <chrono>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/client/messages.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+namespace {
+
+void AddSamples(LatencyEstimator& latency_estimator, MessageAction action, Persona persona,
+                const std::chrono::steady_clock::duration& latency, int count) {
+  for (int i(0); i != count; ++i)
+    latency_estimator.AddSample(action, persona, latency);
+}
+
+}  // unnamed namespace
+
+TEST(LatencyEstimatorTest, BEH_DefaultAndExplicitTimeouts) {
+  LatencyEstimator::Config config;
+  LatencyEstimator latency_estimator(config);
+  EXPECT_FALSE(latency_estimator.adaptive());
+  const std::chrono::steady_clock::duration explicit_timeout(std::chrono::milliseconds(1234));
+  EXPECT_EQ(explicit_timeout, latency_estimator.Timeout(MessageAction::kGetRequest,
+                                                        Persona::kDataManager, explicit_timeout));
+  EXPECT_EQ(config.default_timeout,
+            latency_estimator.Timeout(MessageAction::kGetRequest, Persona::kDataManager));
+
+  // Not adaptive, so samples are ignored when choosing the timeout.
+  AddSamples(latency_estimator, MessageAction::kGetRequest, Persona::kDataManager,
+             std::chrono::milliseconds(100), config.min_samples);
+  EXPECT_EQ(config.default_timeout,
+            latency_estimator.Timeout(MessageAction::kGetRequest, Persona::kDataManager));
+
+  // Adaptive, but without enough samples.
+  latency_estimator.set_adaptive(true);
+  EXPECT_EQ(config.default_timeout,
+            latency_estimator.Timeout(MessageAction::kPutRequest, Persona::kMaidManager));
+  AddSamples(latency_estimator, MessageAction::kPutRequest, Persona::kMaidManager,
+             std::chrono::milliseconds(100), config.min_samples - 1);
+  EXPECT_EQ(config.default_timeout,
+            latency_estimator.Timeout(MessageAction::kPutRequest, Persona::kMaidManager));
+  EXPECT_EQ(explicit_timeout, latency_estimator.Timeout(MessageAction::kGetRequest,
+                                                        Persona::kDataManager, explicit_timeout));
+  // An explicit zero timeout isn't mistaken for an unspecified one.
+  EXPECT_EQ(std::chrono::steady_clock::duration::zero(),
+            latency_estimator.Timeout(MessageAction::kGetRequest, Persona::kDataManager,
+                                      std::chrono::steady_clock::duration::zero()));
+}
+
+TEST(LatencyEstimatorTest, BEH_AdaptiveTimeouts) {
+  LatencyEstimator::Config config;
+  config.min_timeout = std::chrono::milliseconds(100);
+  LatencyEstimator latency_estimator(config);
+  latency_estimator.set_adaptive(true);
+
+  // 99% of Gets take around 200ms, so the timeout should be close to 200ms plus the margin.  The
+  // histogram resolution is half an octave, so allow for that.
+  AddSamples(latency_estimator, MessageAction::kGetRequest, Persona::kDataManager,
+             std::chrono::milliseconds(200), 990);
+  AddSamples(latency_estimator, MessageAction::kGetRequest, Persona::kDataManager,
+             std::chrono::seconds(5), 10);
+  auto percentile(latency_estimator.Percentile(MessageAction::kGetRequest, Persona::kDataManager,
+                                               config.percentile));
+  EXPECT_GE(percentile, std::chrono::milliseconds(200));
+  EXPECT_LE(percentile, std::chrono::milliseconds(283));
+  EXPECT_EQ(percentile + config.margin,
+            latency_estimator.Timeout(MessageAction::kGetRequest, Persona::kDataManager));
+  EXPECT_GE(latency_estimator.Percentile(MessageAction::kGetRequest, Persona::kDataManager, 1.0),
+            std::chrono::seconds(5));
+
+  // Estimates are kept per action and persona.
+  EXPECT_EQ(config.default_timeout,
+            latency_estimator.Timeout(MessageAction::kGetVersionsRequest,
+                                      Persona::kVersionManager));
+
+}
+
+TEST(LatencyEstimatorTest, BEH_AdaptiveTimeoutsAreClamped) {
+  LatencyEstimator::Config config;
+  LatencyEstimator latency_estimator(config);
+  latency_estimator.set_adaptive(true);
+  AddSamples(latency_estimator, MessageAction::kGetVersionsRequest, Persona::kVersionManager,
+             std::chrono::microseconds(10), config.min_samples);
+  EXPECT_EQ(config.min_timeout,
+            latency_estimator.Timeout(MessageAction::kGetVersionsRequest,
+                                      Persona::kVersionManager));
+  AddSamples(latency_estimator, MessageAction::kGetBranchRequest, Persona::kVersionManager,
+             std::chrono::seconds(100), config.min_samples);
+  EXPECT_EQ(config.max_timeout,
+            latency_estimator.Timeout(MessageAction::kGetBranchRequest,
+                                      Persona::kVersionManager));
+}
+
+TEST(LatencyEstimatorTest, BEH_EstimateFollowsRecentLatencies) {
+  LatencyEstimator latency_estimator;
+  AddSamples(latency_estimator, MessageAction::kGetRequest, Persona::kDataManager,
+             std::chrono::seconds(4), 1000);
+  AddSamples(latency_estimator, MessageAction::kGetRequest, Persona::kDataManager,
+             std::chrono::milliseconds(50), 10000);
+  EXPECT_LT(latency_estimator.Percentile(MessageAction::kGetRequest, Persona::kDataManager, 0.99),
+            std::chrono::milliseconds(100));
+}
+
+TEST(LatencyEstimatorTest, BEH_AdaptiveTimeoutGrowsWhenExceeded) {
+  LatencyEstimator::Config config;
+  config.min_samples = 10;
+  LatencyEstimator latency_estimator(config);
+  latency_estimator.set_adaptive(true);
+  AddSamples(latency_estimator, MessageAction::kGetRequest, Persona::kDataManager,
+             std::chrono::milliseconds(500), config.min_samples);
+  auto timeout(latency_estimator.Timeout(MessageAction::kGetRequest, Persona::kDataManager));
+  EXPECT_LT(timeout, std::chrono::seconds(2));
+
+  // Failures other than timeouts aren't sampled, however long they took.
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  const nfs_client::DataNameAndContentOrReturnCode failure(nfs_client::DataNameAndReturnCode(
+      nfs_vault::DataName(data.name()), nfs_client::ReturnCode(CommonErrors::unknown)));
+  for (int i(0); i != 100; ++i) {
+    latency_estimator.AddResult(MessageAction::kGetRequest, Persona::kDataManager,
+                                std::chrono::steady_clock::now() - 10 * timeout, failure);
+  }
+  EXPECT_EQ(timeout,
+            latency_estimator.Timeout(MessageAction::kGetRequest, Persona::kDataManager));
+
+  // Every op now takes longer than the timeout, so each one times out at its deadline.  Those are
+  // sampled at the deadline, so the timeout keeps growing until it's clamped.
+  while (timeout < config.max_timeout) {
+    for (int i(0); i != 100; ++i) {
+      latency_estimator.AddResult(MessageAction::kGetRequest, Persona::kDataManager,
+                                  std::chrono::steady_clock::now() - timeout,
+                                  nfs_client::DataNameAndContentOrReturnCode());
+    }
+    const auto grown_timeout(latency_estimator.Timeout(MessageAction::kGetRequest,
+                                                       Persona::kDataManager));
+    ASSERT_GT(grown_timeout, timeout);
+    timeout = grown_timeout;
+  }
+  EXPECT_EQ(config.max_timeout, timeout);
+}
+
+TEST(LatencyEstimatorTest, BEH_InvalidConfig) {
+  LatencyEstimator::Config config;
+  config.percentile = 0.0;
+  EXPECT_THROW(LatencyEstimator latency_estimator(config), maidsafe_error);
+  config = LatencyEstimator::Config();
+  config.min_timeout = config.max_timeout + std::chrono::seconds(1);
+  EXPECT_THROW(LatencyEstimator latency_estimator(config), maidsafe_error);
+  config = LatencyEstimator::Config();
+  config.default_timeout = kUnspecifiedTimeout;
+  EXPECT_THROW(LatencyEstimator latency_estimator(config), maidsafe_error);
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
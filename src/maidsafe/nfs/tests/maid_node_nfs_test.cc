@@ -0,0 +1,383 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/client/maid_node_nfs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+#include "maidsafe/passport/passport.h"
+#include "maidsafe/routing/message.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing_api.h"
+
+#include "maidsafe/nfs/expected.h"
+#include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/client/awaitables.h"
+#include "maidsafe/nfs/tests/allocation_counter.h"
+
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+namespace test {
+
+// Runs posted handlers immediately.
+struct Executor {
+  template<typename Functor>
+  void post(Functor&& functor) const { functor(); }
+};
+
+// Drives a MaidNodeNfs whose requests are captured rather than sent via routing, and which is
+// passed responses as though they had arrived from the network.
+class MaidNodeNfsTest : public testing::Test {
+ protected:
+  static const int kMaxPutsInFlight = 2;
+
+  MaidNodeNfsTest()
+      : anmaid_(),
+        maid_(anmaid_),
+        routing_(maid_),
+        asio_service_(2),
+        maid_node_nfs_(asio_service_, routing_,
+                       passport::PublicPmid::Name(Identity(RandomString(64))),
+                       DataCache::Config(), kMaxPutsInFlight),
+        mutex_(),
+        requests_() {
+    maid_node_nfs_.SetSendFunctor([this](const std::string& request) { AddRequest(request); });
+  }
+
+  void AddRequest(const std::string& request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(request);
+  }
+
+  std::vector<std::string> requests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+  }
+
+  template<typename Response>
+  void Deliver(const Response& response) {
+    typename Response::Sender sender(routing::GroupId(NodeId(NodeId::kRandomId)),
+                                     routing::SingleId(NodeId(NodeId::kRandomId)));
+    typename Response::Receiver receiver(routing_.kNodeId());
+    maid_node_nfs_.HandleMessage(routing::Message<typename Response::Sender,
+                                                  typename Response::Receiver>(
+        response.Serialise(), sender, receiver));
+  }
+
+  void RespondToGet(const std::string& request, const ImmutableData& data) {
+    const auto message_id(std::get<3>(nfs::ParseMessageWrapper(request)));
+    Deliver(MaidNodeService::GetResponse(message_id, DataNameAndContentOrReturnCode(data)));
+  }
+
+  // Sends the successful responses of enough of the MaidManager group to resolve the Put.
+  void RespondToPut(const std::string& request) {
+    nfs::PutRequestFromMaidNodeToMaidManager put_request(nfs::ParseMessageWrapper(request));
+    MaidNodeService::PutResponse::Contents contents;
+    contents.data_and_pmid_hint = *put_request.contents;
+    for (int i(0); i != routing::Parameters::node_group_size / 2 + 1; ++i)
+      Deliver(MaidNodeService::PutResponse(put_request.message_id, contents));
+  }
+
+  passport::Anmaid anmaid_;
+  passport::Maid maid_;
+  routing::Routing routing_;
+  AsioService asio_service_;
+  MaidNodeNfs maid_node_nfs_;
+  mutable std::mutex mutex_;
+  std::vector<std::string> requests_;
+};
+
+TEST_F(MaidNodeNfsTest, BEH_GetRecoversFromFailedSend) {
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  std::unique_ptr<boost::future<ImmutableData>> attached_get;
+  maid_node_nfs_.SetSendFunctor([&](const std::string& /*request*/) {
+    // Attached to the in-flight Get before its request fails.
+    attached_get.reset(new boost::future<ImmutableData>(
+        maid_node_nfs_.Get<ImmutableData>(data.name())));
+    ThrowError(CommonErrors::unable_to_handle_request);
+  });
+  EXPECT_THROW(maid_node_nfs_.Get<ImmutableData>(data.name()), maidsafe_error);
+  EXPECT_EQ(1U, maid_node_nfs_.coalesced_get_count());
+  ASSERT_TRUE(attached_get && attached_get->is_ready());
+  try {
+    attached_get->get();
+    ADD_FAILURE() << "Attached Get should have failed.";
+  }
+  catch(const maidsafe_error& error) {
+    EXPECT_EQ(make_error_code(CommonErrors::unable_to_handle_request), error.code());
+  }
+
+  // A later Get for the same data isn't attached to the failed one.
+  maid_node_nfs_.SetSendFunctor([this](const std::string& request) { AddRequest(request); });
+  auto get(maid_node_nfs_.Get<ImmutableData>(data.name()));
+  ASSERT_EQ(1U, requests().size());
+  EXPECT_EQ(1U, maid_node_nfs_.coalesced_get_count());
+  RespondToGet(requests().front(), data);
+  ASSERT_TRUE(get.is_ready());
+  EXPECT_EQ(data.name(), get.get().name());
+}
+
+TEST_F(MaidNodeNfsTest, BEH_PutReleasesSlotWhenSendFails) {
+  maid_node_nfs_.SetSendFunctor([](const std::string& /*request*/) {
+    ThrowError(CommonErrors::unable_to_handle_request);
+  });
+  // Had the failed Puts kept their slots, the later ones would block waiting for a free slot.
+  for (int i(0); i != kMaxPutsInFlight + 1; ++i) {
+    EXPECT_THROW(maid_node_nfs_.Put(ImmutableData(NonEmptyString(RandomString(100)))),
+                 maidsafe_error);
+  }
+
+  maid_node_nfs_.SetSendFunctor([this](const std::string& request) { AddRequest(request); });
+  std::vector<boost::future<void>> puts;
+  for (int i(0); i != kMaxPutsInFlight; ++i)
+    puts.push_back(maid_node_nfs_.Put(ImmutableData(NonEmptyString(RandomString(100)))));
+  ASSERT_EQ(static_cast<size_t>(kMaxPutsInFlight), requests().size());
+  for (const auto& request : requests())
+    RespondToPut(request);
+  for (auto& put : puts) {
+    ASSERT_TRUE(put.is_ready());
+    EXPECT_NO_THROW(put.get());
+  }
+}
+
+TEST_F(MaidNodeNfsTest, BEH_HandlerGetsAreCoalesced) {
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  Executor executor;
+  std::vector<nfs::Expected<ImmutableData>> outcomes;
+  auto handler([&](nfs::Expected<ImmutableData> outcome) {
+    outcomes.push_back(std::move(outcome));
+  });
+  maid_node_nfs_.Get<ImmutableData>(data.name(), executor, handler);
+  maid_node_nfs_.Get<ImmutableData>(data.name(), executor, handler);
+  ASSERT_EQ(1U, requests().size());
+  EXPECT_EQ(1U, maid_node_nfs_.coalesced_get_count());
+  EXPECT_TRUE(outcomes.empty());
+
+  RespondToGet(requests().front(), data);
+  ASSERT_EQ(2U, outcomes.size());
+  for (const auto& outcome : outcomes) {
+    ASSERT_TRUE(outcome);
+    EXPECT_EQ(data.name(), outcome->name());
+  }
+}
+
+TEST_F(MaidNodeNfsTest, BEH_HandlerOpsReportFailedSendOnlyViaHandler) {
+  maid_node_nfs_.SetSendFunctor([](const std::string& /*request*/) {
+    ThrowError(CommonErrors::unable_to_handle_request);
+  });
+  const auto kTimeout(std::chrono::milliseconds(100));
+  Executor executor;
+  std::mutex errors_mutex;
+  std::vector<std::error_code> errors;
+  auto record_error([&](const maidsafe_error* error) {
+    std::lock_guard<std::mutex> lock(errors_mutex);
+    errors.push_back(error ? error->code() : std::error_code());
+  });
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  EXPECT_NO_THROW(maid_node_nfs_.Get<ImmutableData>(
+      data.name(), executor,
+      [&](nfs::Expected<ImmutableData> outcome) {
+        record_error(outcome ? nullptr : &outcome.error());
+      },
+      kTimeout));
+  EXPECT_NO_THROW(maid_node_nfs_.Put(
+      data, executor,
+      [&](nfs::Expected<void> outcome) { record_error(outcome ? nullptr : &outcome.error()); },
+      kTimeout));
+  EXPECT_NO_THROW(maid_node_nfs_.GetVersions<ImmutableData>(
+      data.name(), executor,
+      [&](nfs::Expected<VersionNames> outcome) {
+        record_error(outcome ? nullptr : &outcome.error());
+      },
+      kTimeout));
+  EXPECT_NO_THROW(maid_node_nfs_.GetBranch<ImmutableData>(
+      data.name(), StructuredDataVersions::VersionName(), executor,
+      [&](nfs::Expected<VersionNames> outcome) {
+        record_error(outcome ? nullptr : &outcome.error());
+      },
+      kTimeout));
+
+  // None of the ops is left registered to time out and report again.
+  std::this_thread::sleep_for(kTimeout * 3);
+  std::lock_guard<std::mutex> lock(errors_mutex);
+  ASSERT_EQ(4U, errors.size());
+  for (const auto& error : errors)
+    EXPECT_EQ(make_error_code(CommonErrors::unable_to_handle_request), error);
+}
+
+TEST_F(MaidNodeNfsTest, BEH_HandlerGetAllocationsPerOp) {
+  // Requests are captured into a single reserved buffer, so capturing them doesn't allocate.
+  std::string request;
+  request.reserve(4096);
+  maid_node_nfs_.SetSendFunctor([&request](const std::string& sent) { request = sent; });
+  ImmutableData data(NonEmptyString(RandomString(100)));
+  Executor executor;
+  int succeeded(0);
+  auto run_gets([&](int count, nfs::test::ScopedAllocationCounter* allocation_counter)->uint64_t {
+    uint64_t allocations(0);
+    for (int i(0); i != count; ++i) {
+      const uint64_t before(allocation_counter ? allocation_counter->count() : 0);
+      maid_node_nfs_.Get<ImmutableData>(data.name(), executor,
+                                        [&](nfs::Expected<ImmutableData> outcome) {
+                                          succeeded += outcome ? 1 : 0;
+                                        });
+      if (allocation_counter)
+        allocations += allocation_counter->count() - before;
+      // Not counted, since building and delivering the response is the test's own work.
+      RespondToGet(request, data);
+    }
+    return allocations;
+  });
+
+  const int kOpCount(1000);
+  run_gets(kOpCount, nullptr);
+  // The op's own state comes from the op pool.  What remains per Get is its key, the InFlightGets
+  // entry holding the handler, the key's copies held by the op and its response functor, the timer
+  // task and the serialised request.
+  const uint64_t kAllocationsPerGet(24);
+  uint64_t allocations(0);
+  {
+    nfs::test::ScopedAllocationCounter allocation_counter;
+    allocations = run_gets(kOpCount, &allocation_counter);
+  }
+  EXPECT_EQ(2 * kOpCount, succeeded);
+  EXPECT_LE(allocations, kAllocationsPerGet * kOpCount);
+}
+
+TEST_F(MaidNodeNfsTest, BEH_HandlerPutIsQueuedWhenAtCapacity) {
+  const int kPutCount(kMaxPutsInFlight + 2);
+  Executor executor;
+  int succeeded(0);
+  // None of these block, even though only kMaxPutsInFlight can be in flight at once.
+  for (int i(0); i != kPutCount; ++i) {
+    maid_node_nfs_.Put(ImmutableData(NonEmptyString(RandomString(100))), executor,
+                       [&](nfs::Expected<void> outcome) { succeeded += outcome ? 1 : 0; });
+  }
+  ASSERT_EQ(static_cast<size_t>(kMaxPutsInFlight), requests().size());
+
+  // Each completed Put hands its slot to a queued one.
+  for (int i(0); i != kPutCount; ++i) {
+    ASSERT_LT(static_cast<size_t>(i), requests().size());
+    RespondToPut(requests()[i]);
+    EXPECT_EQ(i + 1, succeeded);
+    EXPECT_EQ(static_cast<size_t>(std::min(kPutCount, kMaxPutsInFlight + i + 1)),
+              requests().size());
+  }
+}
+
+TEST_F(MaidNodeNfsTest, BEH_QueuedHandlerPutReportsSendFailure) {
+  Executor executor;
+  std::vector<boost::optional<nfs::Expected<void>>> outcomes(kMaxPutsInFlight + 1);
+  for (auto& outcome : outcomes) {
+    maid_node_nfs_.Put(ImmutableData(NonEmptyString(RandomString(100))), executor,
+                       [&outcome](nfs::Expected<void> result) { outcome = result; });
+  }
+  const auto sent(requests());
+  ASSERT_EQ(static_cast<size_t>(kMaxPutsInFlight), sent.size());
+
+  // The queued Put is started when the first completes, and its handler is passed the error.
+  maid_node_nfs_.SetSendFunctor([](const std::string& /*request*/) {
+    ThrowError(CommonErrors::unable_to_handle_request);
+  });
+  RespondToPut(sent.front());
+  ASSERT_TRUE(outcomes.front());
+  EXPECT_TRUE(*outcomes.front());
+  ASSERT_TRUE(outcomes.back());
+  ASSERT_FALSE(*outcomes.back());
+  EXPECT_EQ(make_error_code(CommonErrors::unable_to_handle_request),
+            outcomes.back()->error().code());
+}
+
+#ifdef MAIDSAFE_NFS_HAS_COROUTINES
+namespace {
+
+// A coroutine which starts eagerly and whose frame is destroyed when it finishes.
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return DetachedTask(); }
+    std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+    std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+DetachedTask GetThenPut(MaidNodeNfs& maid_node_nfs, const ImmutableData::Name& name,
+                        const std::vector<ImmutableData>& data, int* put_count) {
+  co_await AwaitGet<ImmutableData>(maid_node_nfs, name);
+  for (const auto& item : data) {
+    co_await AwaitPut(maid_node_nfs, item);
+    ++*put_count;
+  }
+}
+
+}  // unnamed namespace
+
+TEST_F(MaidNodeNfsTest, BEH_AwaitPutsBeyondCapacityFromResumedCoroutine) {
+  std::vector<boost::future<void>> blocking_puts;
+  for (int i(0); i != kMaxPutsInFlight; ++i)
+    blocking_puts.push_back(maid_node_nfs_.Put(ImmutableData(NonEmptyString(RandomString(100)))));
+
+  ImmutableData got(NonEmptyString(RandomString(100)));
+  std::vector<ImmutableData> data;
+  for (int i(0); i != kMaxPutsInFlight + 1; ++i)
+    data.emplace_back(NonEmptyString(RandomString(100)));
+  int put_count(0);
+  GetThenPut(maid_node_nfs_, got.name(), data, &put_count);
+  ASSERT_EQ(static_cast<size_t>(kMaxPutsInFlight + 1), requests().size());
+
+  // Resumes the coroutine on this thread, as the response thread, with every Put slot taken.  Had
+  // its first Put blocked for a slot, this would never return.
+  RespondToGet(requests().back(), got);
+  EXPECT_EQ(static_cast<size_t>(kMaxPutsInFlight + 1), requests().size());
+
+  // Each response frees a slot for the coroutine's next Put, until it's done.
+  for (std::size_t i(0); i != requests().size(); ++i) {
+    if (i != static_cast<std::size_t>(kMaxPutsInFlight))
+      RespondToPut(requests()[i]);
+  }
+  EXPECT_EQ(kMaxPutsInFlight + 1, put_count);
+  for (auto& put : blocking_puts)
+    EXPECT_NO_THROW(put.get());
+}
+#endif  // MAIDSAFE_NFS_HAS_COROUTINES
+
+}  // namespace test
+
+}  // namespace nfs_client
+
+}  // namespace maidsafe
@@ -0,0 +1,182 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/message_wrapper.h"
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+#include "maidsafe/passport/passport.h"
+
+#include "maidsafe/nfs/codec_arena.h"
+#include "maidsafe/nfs/error_categories.h"
+#include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/client/messages.h"
+#include "maidsafe/nfs/vault/messages.h"
+#include "maidsafe/nfs/tests/scoped_error_category_ids_only.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+namespace {
+
+// Checks that the direct encoding of 'contents' is byte-for-byte the protobuf one, and that each
+// codec parses the other's output.
+template<typename Contents>
+void CheckDirectCodec(const Contents& contents) {
+  std::string direct_encoding;
+  DirectCodec<Contents>::AppendTo(contents, direct_encoding);
+  EXPECT_EQ(DirectCodec<Contents>::Size(contents), direct_encoding.size());
+  const std::string protobuf_encoding(contents.Serialise());
+  EXPECT_EQ(protobuf_encoding, direct_encoding);
+
+  EXPECT_EQ(contents, DirectCodec<Contents>::Parse(protobuf_encoding));
+  EXPECT_EQ(contents, Contents(direct_encoding));
+}
+
+StructuredDataVersions::VersionName RandomVersionName() {
+  return StructuredDataVersions::VersionName(RandomUint32(),
+                                             ImmutableData::Name(Identity(RandomString(64))));
+}
+
+nfs_client::DataNameAndReturnCode NotFound(const ImmutableData::Name& name) {
+  return nfs_client::DataNameAndReturnCode(
+      nfs_vault::DataName(name), nfs_client::ReturnCode(CommonErrors::no_such_element));
+}
+
+}  // unnamed namespace
+
+TEST(MessageCodecsTest, BEH_DirectEncodingMatchesProtobuf) {
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  const nfs_vault::DataName data_name(data.name());
+  const Identity pmid_hint(RandomString(crypto::SHA512::DIGESTSIZE));
+
+  CheckDirectCodec(nfs_vault::Empty());
+  CheckDirectCodec(data_name);
+  nfs_vault::DataNameAndVersion data_name_and_version;
+  data_name_and_version.data_name = data_name;
+  data_name_and_version.version_name = RandomVersionName();
+  CheckDirectCodec(data_name_and_version);
+  nfs_vault::DataNameOldNewVersion data_name_old_new_version;
+  data_name_old_new_version.data_name = data_name;
+  data_name_old_new_version.old_version_name = RandomVersionName();
+  data_name_old_new_version.new_version_name = RandomVersionName();
+  CheckDirectCodec(data_name_old_new_version);
+  CheckDirectCodec(nfs_vault::DataNameAndContent(data));
+  nfs_vault::DataNameAndCost data_name_and_cost;
+  data_name_and_cost.name = data_name;
+  data_name_and_cost.cost = RandomInt32();
+  CheckDirectCodec(data_name_and_cost);
+  // Negative costs are sign-extended to ten-byte varints.
+  data_name_and_cost.cost = -1;
+  CheckDirectCodec(data_name_and_cost);
+  CheckDirectCodec(nfs_vault::DataAndPmidHint(data_name, data.Serialise().data, pmid_hint));
+
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  passport::Pmid pmid(maid);
+  CheckDirectCodec(nfs_vault::PmidRegistration(maid, pmid, false));
+  CheckDirectCodec(nfs_vault::PmidRegistration(maid, pmid, true));
+
+  CheckDirectCodec(nfs_client::DataNameAndContentOrReturnCode(data));
+  nfs_client::DataNameAndContentOrReturnCode not_found;
+  not_found.data_name_and_return_code = NotFound(data.name());
+  CheckDirectCodec(not_found);
+
+  std::vector<StructuredDataVersions::VersionName> versions;
+  for (int i(0); i != 10; ++i)
+    versions.push_back(RandomVersionName());
+  nfs_client::StructuredDataNameAndContentOrReturnCode versions_found;
+  versions_found.structured_data = nfs_client::StructuredData(versions);
+  CheckDirectCodec(versions_found);
+  nfs_client::StructuredDataNameAndContentOrReturnCode versions_not_found;
+  versions_not_found.data_name_and_return_code = NotFound(data.name());
+  CheckDirectCodec(versions_not_found);
+
+  nfs_client::DataPmidHintAndReturnCode put_failure;
+  put_failure.data_and_pmid_hint =
+      nfs_vault::DataAndPmidHint(data_name, data.Serialise().data, pmid_hint);
+  put_failure.return_code = nfs_client::ReturnCode(CommonErrors::cannot_exceed_limit);
+  CheckDirectCodec(put_failure);
+
+  CheckDirectCodec(nfs_client::DataNameAndContentAndReturnCode(
+      data_name.type, data_name.raw_name, nfs_client::ReturnCode(CommonErrors::success),
+      data.Serialise().data));
+  CheckDirectCodec(nfs_client::DataNameAndContentAndReturnCode(
+      data_name.type, data_name.raw_name, nfs_client::ReturnCode(NfsErrors::timed_out)));
+}
+
+TEST(MessageCodecsTest, BEH_ReturnCodeCategoryEncodings) {
+  const nfs_client::ReturnCode registered(NfsErrors::timed_out);
+  const nfs_client::ReturnCode unregistered(
+      maidsafe_error(std::make_error_code(std::errc::invalid_argument)));
+  std::string name_and_id, unregistered_encoding;
+  DirectCodec<nfs_client::ReturnCode>::AppendTo(registered, name_and_id);
+  DirectCodec<nfs_client::ReturnCode>::AppendTo(unregistered, unregistered_encoding);
+  CheckDirectCodec(registered);
+  EXPECT_EQ(unregistered.Serialise(), unregistered_encoding);
+
+  ScopedErrorCategoryIdsOnly ids_only(true);
+  std::string id_only;
+  DirectCodec<nfs_client::ReturnCode>::AppendTo(registered, id_only);
+  EXPECT_LT(id_only.size(), name_and_id.size());
+  CheckDirectCodec(registered);
+  // Unregistered categories are still sent by name.
+  unregistered_encoding.clear();
+  DirectCodec<nfs_client::ReturnCode>::AppendTo(unregistered, unregistered_encoding);
+  EXPECT_EQ(unregistered.Serialise(), unregistered_encoding);
+  EXPECT_EQ(DirectCodec<nfs_client::ReturnCode>::Size(unregistered), unregistered_encoding.size());
+}
+
+TEST(MessageCodecsTest, BEH_ProtobufFallback) {
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  GetResponse get_response((GetResponse::Contents(data)));
+  const std::string direct_serialised(get_response.Serialise());
+
+  SetCodecMode(CodecMode::kProtobuf);
+  EXPECT_EQ(direct_serialised, get_response.Serialise());
+  EXPECT_EQ(get_response, GetResponse(ParseMessageWrapper(direct_serialised)));
+  SetCodecMode(CodecMode::kDirect);
+}
+
+TEST(MessageCodecsTest, BEH_MalformedContents) {
+  const std::string garbage("\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff");
+  EXPECT_THROW(DirectCodec<nfs_vault::DataName>::Parse(garbage), std::exception);
+  EXPECT_THROW(DirectCodec<nfs_vault::DataNameAndContent>::Parse(""), std::exception);
+  // A valid DataName lacks the fields required of a DataNameAndReturnCode.
+  const std::string serialised_data_name(
+      nfs_vault::DataName(ImmutableData::Name(Identity(RandomString(64)))).Serialise());
+  EXPECT_THROW(DirectCodec<nfs_client::DataNameAndReturnCode>::Parse(serialised_data_name),
+               std::exception);
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
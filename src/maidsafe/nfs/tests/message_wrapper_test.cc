@@ -18,7 +18,12 @@
 
 #include "maidsafe/nfs/message_wrapper.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "boost/variant/static_visitor.hpp"
 #include "boost/variant/variant.hpp"
@@ -28,6 +33,7 @@
 #include "maidsafe/common/utils.h"
 
 #include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/message_wrapper.pb.h"
 #include "maidsafe/nfs/client/messages.h"
 #include "maidsafe/nfs/vault/messages.h"
 #include "maidsafe/nfs/types.h"
@@ -156,6 +162,177 @@ TEST(MessageWrapperTest, BEH_CheckVariant) {
   EXPECT_THROW(data_manager_service.HandleMessage(tuple_del), maidsafe_error);
 }
 
+TEST(MessageWrapperTest, BEH_SerialiseMatchesProtobufEncoding) {
+  ImmutableData data(NonEmptyString(RandomString(1024 * 1024)));
+  PutRequest::Contents put_contents;
+  put_contents.data = nfs_vault::DataNameAndContent(data);
+  put_contents.pmid_hint = Identity(RandomString(crypto::SHA512::DIGESTSIZE));
+
+  for (int64_t message_id : std::vector<int64_t>{ 0, 1, -1, RandomInt32(),
+                                                 detail::GetNewMessageId().data,
+                                                 std::numeric_limits<int64_t>::min() }) {
+    PutRequest put(MessageId(message_id), put_contents);
+    protobuf::MessageWrapper proto_message_wrapper;
+    proto_message_wrapper.set_action(static_cast<int32_t>(MessageAction::kPutRequest));
+    proto_message_wrapper.set_source_persona(static_cast<int32_t>(Persona::kMaidNode));
+    proto_message_wrapper.set_destination_persona(static_cast<int32_t>(Persona::kMaidManager));
+    proto_message_wrapper.set_message_id(message_id);
+    proto_message_wrapper.set_serialised_contents(put_contents.Serialise());
+
+    auto serialised_put(put.Serialise());
+    EXPECT_EQ(proto_message_wrapper.SerializeAsString(), serialised_put);
+    EXPECT_EQ(put, PutRequest(ParseMessageWrapper(serialised_put)));
+  }
+}
+
+TEST(MessageWrapperTest, BEH_SerialiseGetResponseMatchesProtobufEncoding) {
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  std::vector<GetResponse::Contents> all_contents;
+  all_contents.push_back(GetResponse::Contents(data));
+  all_contents.push_back(GetResponse::Contents(nfs_client::DataNameAndReturnCode(
+      nfs_vault::DataName(data.name()), nfs_client::ReturnCode(NfsErrors::failed_to_get_data))));
+  for (const auto& contents : all_contents) {
+    GetResponse get_response(contents);
+    EXPECT_EQ(detail::SerialiseMessageWrapper(MessageAction::kGetResponse, Persona::kDataManager,
+                                              Persona::kMaidNode, get_response.message_id,
+                                              contents.Serialise()),
+              get_response.Serialise());
+  }
+}
+
+TEST(MessageWrapperTest, BEH_RvalueSerialiseConsumesContents) {
+  ImmutableData data(NonEmptyString(RandomString(1024 * 1024)));
+  PutRequest::Contents put_contents;
+  put_contents.data = nfs_vault::DataNameAndContent(data);
+  put_contents.pmid_hint = Identity(RandomString(crypto::SHA512::DIGESTSIZE));
+  const SharedBuffer content(put_contents.data.content);
+
+  // Neither moving the contents into the message nor copying the message copies the content.
+  PutRequest put(MessageId(RandomInt32()), std::move(put_contents));
+  EXPECT_EQ(2, content.use_count());
+  PutRequest put_copy(put);
+  EXPECT_EQ(&content.string(), &put_copy.contents->data.content.string());
+
+  auto serialised_put(std::move(put).Serialise());
+  EXPECT_FALSE(put.contents);
+  EXPECT_EQ(put_copy.Serialise(), serialised_put);
+  put_copy = PutRequest();
+  EXPECT_EQ(1, content.use_count());
+  EXPECT_EQ(content, PutRequest(ParseMessageWrapper(serialised_put)).contents->data.content);
+}
+
+TEST(MessageWrapperTest, FUNC_ConcurrentMessageIdAllocation) {
+  const int kThreadCount(8), kIdsPerThread(100000);
+  std::vector<std::vector<int64_t>> ids(kThreadCount, std::vector<int64_t>(kIdsPerThread));
+  std::vector<std::thread> threads;
+  auto start(std::chrono::steady_clock::now());
+  for (int i(0); i != kThreadCount; ++i) {
+    threads.emplace_back([&ids, i, kIdsPerThread] {
+      for (int j(0); j != kIdsPerThread; ++j)
+        ids[i][j] = detail::GetNewMessageId().data;
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  auto duration(std::chrono::steady_clock::now() - start);
+  LOG(kInfo) << "Allocated " << kThreadCount * kIdsPerThread << " message IDs on " << kThreadCount
+             << " threads in "
+             << std::chrono::duration_cast<std::chrono::microseconds>(duration).count() << " us";
+
+  std::vector<int64_t> all_ids;
+  for (const auto& thread_ids : ids)
+    all_ids.insert(std::end(all_ids), std::begin(thread_ids), std::end(thread_ids));
+  std::sort(std::begin(all_ids), std::end(all_ids));
+  EXPECT_TRUE(std::adjacent_find(std::begin(all_ids), std::end(all_ids)) == std::end(all_ids));
+  EXPECT_GE(all_ids.front(), 0);
+}
+
+TEST(MessageWrapperTest, BEH_ParseDoesNotCopyContents) {
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  ImmutableData data(NonEmptyString(RandomString(1024 * 1024)));
+  GetResponse get_response((GetResponse::Contents(data)));
+  auto serialised_get_response(get_response.Serialise());
+
+  auto parsed(ParseMessageWrapper(serialised_get_response));
+  const auto& contents_view(std::get<4>(parsed));
+  EXPECT_EQ(serialised_get_response.data() + serialised_get_response.size(),
+            contents_view.data() + contents_view.size());
+  EXPECT_EQ(get_response.contents->Serialise(), contents_view.to_string());
+
+  GetResponse recovered_get_response(parsed);
+  EXPECT_EQ(get_response, recovered_get_response);
+  ASSERT_TRUE(recovered_get_response.contents->data);
+  EXPECT_EQ(data.Serialise().data,
+            recovered_get_response.contents->data->content.non_empty_string());
+
+  std::string truncated(serialised_get_response.substr(0, serialised_get_response.size() - 1));
+  EXPECT_THROW(ParseMessageWrapper(truncated), maidsafe_error);
+}
+
+TEST(MessageWrapperTest, BEH_ContentsDecodedOnFirstDereference) {
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  const MessageId message_id(RandomInt32());
+  GetResponse get_response(message_id, GetResponse::Contents(data));
+  EXPECT_TRUE(get_response.contents.decoded());
+  auto serialised_get_response(get_response.Serialise());
+
+  GetResponse recovered_get_response(ParseMessageWrapper(serialised_get_response));
+  EXPECT_EQ(message_id, recovered_get_response.message_id);
+  EXPECT_TRUE(recovered_get_response.contents);
+  EXPECT_FALSE(recovered_get_response.contents.decoded());
+  ASSERT_TRUE(recovered_get_response.contents->data);
+  EXPECT_TRUE(recovered_get_response.contents.decoded());
+  EXPECT_EQ(data.Serialise().data,
+            recovered_get_response.contents->data->content.non_empty_string());
+
+  // Copying an undecoded message decodes it, so the copy doesn't refer to the serialised message.
+  GetResponse undecoded(ParseMessageWrapper(serialised_get_response));
+  EXPECT_FALSE(undecoded.contents.decoded());
+  GetResponse copied(undecoded);
+  EXPECT_TRUE(undecoded.contents.decoded());
+  serialised_get_response.assign(serialised_get_response.size(), '\0');
+  EXPECT_EQ(get_response, copied);
+}
+
+TEST(MessageWrapperTest, BEH_MalformedContentsThrowOnDereference) {
+  const std::string kGarbage("Not a serialised DataNameAndContent");
+  LazyContents<nfs_vault::DataNameAndContent> contents((boost::string_ref(kGarbage)));
+  EXPECT_TRUE(contents);
+  EXPECT_FALSE(contents.decoded());
+  EXPECT_THROW(*contents, std::exception);
+  EXPECT_FALSE(contents.decoded());
+  EXPECT_THROW(contents->name, std::exception);
+
+  LazyContents<nfs_vault::DataNameAndContent> empty;
+  EXPECT_FALSE(empty);
+  EXPECT_TRUE(empty.get() == nullptr);
+}
+
+TEST(MessageWrapperTest, FUNC_ConcurrentDereferenceDecodesOnce) {
+  typedef GetResponseFromDataManagerToMaidNode GetResponse;
+  ImmutableData data(NonEmptyString(RandomString(1024 * 1024)));
+  auto serialised_get_response(GetResponse(GetResponse::Contents(data)).Serialise());
+  const GetResponse recovered_get_response(ParseMessageWrapper(serialised_get_response));
+
+  const int kThreadCount(8);
+  std::vector<const GetResponse::Contents*> decoded(kThreadCount, nullptr);
+  std::vector<std::thread> threads;
+  for (int i(0); i != kThreadCount; ++i) {
+    threads.emplace_back([&decoded, &recovered_get_response, i] {
+      decoded[i] = &*recovered_get_response.contents;
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  for (const auto& contents : decoded)
+    EXPECT_EQ(decoded.front(), contents);
+  ASSERT_TRUE(recovered_get_response.contents->data);
+  EXPECT_EQ(data.Serialise().data,
+            recovered_get_response.contents->data->content.non_empty_string());
+}
+
 //TEST_F(MessageWrapperTest, BEH_SerialiseThenParse) {
 //  auto serialised_message(message_.Serialise());
 //  Message recovered_message(serialised_message);
@@ -0,0 +1,178 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/op_pool.h"
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/nfs/pending_ops.h"
+#include "maidsafe/nfs/tests/allocation_counter.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+struct OpPoolTestResponse {
+  OpPoolTestResponse() : error_code(MakeError(NfsErrors::timed_out).code()) {}
+  explicit OpPoolTestResponse(std::error_code error_code_in) : error_code(error_code_in) {}
+  std::error_code error_code;
+};
+
+}  // namespace test
+
+template<>
+bool IsSuccess<test::OpPoolTestResponse>(const test::OpPoolTestResponse& response) {
+  return !response.error_code;
+}
+
+template<>
+std::error_code ErrorCode<test::OpPoolTestResponse>(const test::OpPoolTestResponse& response) {
+  return response.error_code;
+}
+
+namespace test {
+
+namespace {
+
+typedef OpPoolTestResponse Response;
+typedef std::array<char, 48> Block;
+
+}  // unnamed namespace
+
+TEST(OpPoolTest, BEH_BlocksAreRecycled) {
+  OpPool op_pool(64, 4);
+  PoolAllocator<Block> allocator(op_pool);
+  allocator.deallocate(allocator.allocate(1), 1);
+  EXPECT_EQ(1U, op_pool.stats().chunks);
+  {
+    nfs::test::ScopedAllocationCounter allocation_counter;
+    for (int i(0); i != 100; ++i)
+      allocator.deallocate(allocator.allocate(1), 1);
+    EXPECT_EQ(0U, allocation_counter.count());
+  }
+  EXPECT_EQ(1U, op_pool.stats().chunks);
+  EXPECT_EQ(0U, op_pool.stats().blocks_in_use);
+  EXPECT_EQ(0U, op_pool.stats().heap_allocations);
+}
+
+TEST(OpPoolTest, BEH_ChunksGrowWithOutstandingBlocks) {
+  OpPool op_pool(64, 4);
+  PoolAllocator<Block> allocator(op_pool);
+  std::vector<Block*> blocks;
+  for (int i(0); i != 10; ++i)
+    blocks.push_back(allocator.allocate(1));
+  EXPECT_EQ(3U, op_pool.stats().chunks);
+  EXPECT_EQ(10U, op_pool.stats().blocks_in_use);
+  // Blocks are distinct.
+  for (std::size_t i(0); i != blocks.size(); ++i) {
+    for (std::size_t j(i + 1); j != blocks.size(); ++j)
+      EXPECT_NE(blocks[i], blocks[j]);
+  }
+  for (auto block : blocks)
+    allocator.deallocate(block, 1);
+  EXPECT_EQ(0U, op_pool.stats().blocks_in_use);
+
+  blocks.clear();
+  for (int i(0); i != 12; ++i)
+    blocks.push_back(allocator.allocate(1));
+  EXPECT_EQ(3U, op_pool.stats().chunks);
+  for (auto block : blocks)
+    allocator.deallocate(block, 1);
+}
+
+TEST(OpPoolTest, BEH_OversizedAllocationsUseHeap) {
+  OpPool op_pool(64, 4);
+  PoolAllocator<Block> allocator(op_pool);
+  Block* blocks(allocator.allocate(2));
+  EXPECT_EQ(0U, op_pool.stats().chunks);
+  EXPECT_EQ(1U, op_pool.stats().heap_allocations);
+  allocator.deallocate(blocks, 2);
+  EXPECT_THROW(OpPool(0, 4), maidsafe_error);
+  EXPECT_THROW(OpPool(64, 0), maidsafe_error);
+}
+
+TEST(OpPoolTest, BEH_AllocatorOutlivesPool) {
+  std::shared_ptr<OpData<Response>> op_data;
+  int resolved_count(0);
+  {
+    OpPool op_pool;
+    op_data = MakeOpData<Response>(op_pool, 1, [&](Response) { ++resolved_count; });
+  }
+  EXPECT_TRUE(op_data->HandleResponseContents(Response(std::error_code())));
+  EXPECT_EQ(1, resolved_count);
+  op_data.reset();
+}
+
+TEST(OpPoolTest, BEH_SteadyStateOpsDoConstantAllocations) {
+  AsioService asio_service(1);
+  OpPool op_pool;
+  PendingOps<Response> pending_ops(asio_service);
+  int resolved_count(0);
+  auto run_ops([&](int count) {
+    for (int i(0); i != count; ++i) {
+      auto message_id(pending_ops.Add(
+          MakeOpData<Response>(op_pool, 1, [&](Response) { ++resolved_count; }),
+          std::chrono::seconds(10)));
+      pending_ops.AddResponse(message_id, Response(std::error_code()));
+    }
+  });
+
+  const int kOpCount(1000);
+  run_ops(kOpCount);
+  const OpPool::Stats warmed_up_stats(op_pool.stats());
+  EXPECT_EQ(1U, warmed_up_stats.chunks);
+
+  // Once warmed up, the ops' own state never reaches the heap.  What remains is the timer task
+  // (a few allocations within routing::Timer) and the occasional rehash of the pending ops' table,
+  // so each op costs at most kAllocationsPerOp, however many ops have already been handled.
+  const std::size_t kAllocationsPerOp(8);
+  std::size_t allocations(0), doubled_allocations(0);
+  {
+    nfs::test::ScopedAllocationCounter allocation_counter;
+    run_ops(kOpCount);
+    allocations = allocation_counter.count();
+  }
+  {
+    nfs::test::ScopedAllocationCounter allocation_counter;
+    run_ops(2 * kOpCount);
+    doubled_allocations = allocation_counter.count();
+  }
+  EXPECT_EQ(4 * kOpCount, resolved_count);
+  EXPECT_LE(allocations, kAllocationsPerOp * kOpCount);
+  EXPECT_LE(doubled_allocations, kAllocationsPerOp * 2 * kOpCount);
+  EXPECT_LE(doubled_allocations, 2 * allocations + kOpCount / 10);
+  EXPECT_EQ(warmed_up_stats.chunks, op_pool.stats().chunks);
+  EXPECT_EQ(0U, op_pool.stats().blocks_in_use);
+  EXPECT_EQ(0U, op_pool.stats().heap_allocations);
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
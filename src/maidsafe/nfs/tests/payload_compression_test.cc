@@ -0,0 +1,215 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/payload_compression.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/message_types.h"
+#include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/tests/allocation_counter.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+namespace {
+
+typedef PutRequestFromDataManagerToPmidManager PutRequest;
+
+// Restores the default (disabled) policy on leaving scope.
+class ScopedCompressionPolicy {
+ public:
+  explicit ScopedCompressionPolicy(PayloadEncoding encoding) {
+    CompressionPolicy policy;
+    policy.enabled = true;
+    policy.encoding = encoding;
+    SetCompressionPolicy(policy);
+  }
+  ~ScopedCompressionPolicy() { SetCompressionPolicy(CompressionPolicy()); }
+
+ private:
+  ScopedCompressionPolicy(const ScopedCompressionPolicy&);
+  ScopedCompressionPolicy(ScopedCompressionPolicy&&);
+  ScopedCompressionPolicy& operator=(ScopedCompressionPolicy);
+};
+
+// Resembles the metadata and directory listings which make up most stored chunks: repetitive
+// structure with varying names and numbers.
+NonEmptyString MetadataLikeContent(std::size_t size) {
+  std::string content;
+  content.reserve(size + 128);
+  while (content.size() < size) {
+    content += "entry name=\"file_" + std::to_string(RandomUint32() % 100000) + ".dat\" size=" +
+               std::to_string(RandomUint32() % 10000000) + " modified=2013-0" +
+               std::to_string(1 + RandomUint32() % 9) + " type=regular\n";
+  }
+  content.resize(size);
+  return NonEmptyString(content);
+}
+
+PutRequest MakePutRequest(const NonEmptyString& content) {
+  return PutRequest(nfs_vault::DataNameAndContent(
+      ImmutableData::Tag::kValue, Identity(RandomString(64)), content));
+}
+
+PayloadEncoding ParsedEncoding(const std::string& serialised_message) {
+  return std::get<5>(ParseMessageWrapper(serialised_message));
+}
+
+}  // unnamed namespace
+
+TEST(PayloadCompressionTest, BEH_DisabledByDefault) {
+  EXPECT_FALSE(GetCompressionPolicy().enabled);
+  // Once enabled, the default encoding is one which every peer can decode, however it was built.
+  EXPECT_EQ(PayloadEncoding::kZlib, GetCompressionPolicy().encoding);
+  auto put_request(MakePutRequest(MetadataLikeContent(16 * 1024)));
+  const std::string serialised(put_request.Serialise());
+  EXPECT_EQ(PayloadEncoding::kNone, ParsedEncoding(serialised));
+  EXPECT_EQ(put_request, PutRequest(ParseMessageWrapper(serialised)));
+}
+
+TEST(PayloadCompressionTest, BEH_CompressibleContent) {
+  for (auto encoding : {PayloadEncoding::kZlib, PayloadEncoding::kLz4}) {
+    if (!PayloadEncodingAvailable(encoding))
+      continue;
+    ScopedCompressionPolicy compression(encoding);
+    auto put_request(MakePutRequest(MetadataLikeContent(64 * 1024)));
+    const std::string uncompressed(put_request.contents->Serialise());
+    const std::string serialised(put_request.Serialise());
+    EXPECT_EQ(encoding, ParsedEncoding(serialised));
+    EXPECT_LT(serialised.size() * 2, uncompressed.size());
+    EXPECT_EQ(put_request, PutRequest(ParseMessageWrapper(serialised)));
+
+    // Messages are decompressed whatever the receiver's own policy.
+    SetCompressionPolicy(CompressionPolicy());
+    EXPECT_EQ(put_request, PutRequest(ParseMessageWrapper(serialised)));
+  }
+}
+
+TEST(PayloadCompressionTest, BEH_SkippedPayloads) {
+  ScopedCompressionPolicy compression(PayloadEncoding::kZlib);
+  // Random content looks encrypted or already compressed.
+  auto random_put_request(MakePutRequest(NonEmptyString(RandomString(64 * 1024))));
+  auto serialised(random_put_request.Serialise());
+  EXPECT_EQ(PayloadEncoding::kNone, ParsedEncoding(serialised));
+  EXPECT_EQ(random_put_request, PutRequest(ParseMessageWrapper(serialised)));
+
+  // Below the size threshold.
+  auto small_put_request(MakePutRequest(MetadataLikeContent(100)));
+  serialised = small_put_request.Serialise();
+  EXPECT_EQ(PayloadEncoding::kNone, ParsedEncoding(serialised));
+  EXPECT_EQ(small_put_request, PutRequest(ParseMessageWrapper(serialised)));
+
+  // Not a compressible type, however large.
+  GetRequestFromMaidNodeToDataManager get_request(
+      nfs_vault::DataName(ImmutableData::Tag::kValue, Identity(std::string(4096, 'a'))));
+  serialised = get_request.Serialise();
+  EXPECT_EQ(PayloadEncoding::kNone, ParsedEncoding(serialised));
+}
+
+TEST(PayloadCompressionTest, BEH_IncompressibleContentIsNotCopied) {
+  auto put_request(MakePutRequest(NonEmptyString(RandomString(64 * 1024))));
+  uint64_t uncompressed_allocations(0);
+  {
+    test::ScopedAllocationCounter allocation_counter;
+    put_request.Serialise();
+    uncompressed_allocations = allocation_counter.count();
+  }
+  // The content is rejected by probing it, rather than after it's been copied into a temporary
+  // buffer for compression, so compression costs at most the probe's output buffer.
+  ScopedCompressionPolicy compression(PayloadEncoding::kZlib);
+  test::ScopedAllocationCounter allocation_counter;
+  const std::string serialised(put_request.Serialise());
+  EXPECT_LE(allocation_counter.count(), uncompressed_allocations + 1);
+  EXPECT_EQ(PayloadEncoding::kNone, ParsedEncoding(serialised));
+}
+
+TEST(PayloadCompressionTest, BEH_MalformedPayloadThrowsOnDereference) {
+  auto put_request(MakePutRequest(MetadataLikeContent(4096)));
+  const std::string uncompressed(put_request.contents->Serialise());
+  for (auto encoding : {PayloadEncoding::kZlib, PayloadEncoding::kLz4,
+                        static_cast<PayloadEncoding>(99)}) {
+    const std::string serialised(detail::SerialiseMessageWrapper(
+        MessageAction::kPutRequest, Persona::kDataManager, Persona::kPmidManager,
+        put_request.message_id, uncompressed, encoding));
+    PutRequest parsed(ParseMessageWrapper(serialised));
+    EXPECT_THROW(*parsed.contents, std::exception);
+  }
+
+  // A declared size which couldn't have been produced from the compressed bytes.
+  std::string oversized("\xff\xff\xff\x7f");
+  oversized += RandomString(16);
+  EXPECT_THROW(detail::DecompressPayload(PayloadEncoding::kZlib, oversized), std::exception);
+}
+
+TEST(PayloadCompressionTest, FUNC_Throughput) {
+  const int kIterations(20);
+  for (auto encoding : {PayloadEncoding::kZlib, PayloadEncoding::kLz4}) {
+    if (!PayloadEncodingAvailable(encoding))
+      continue;
+    for (std::size_t size : {std::size_t(16 * 1024), std::size_t(1024 * 1024)}) {
+      for (bool metadata : {true, false}) {
+        auto put_request(MakePutRequest(metadata ? MetadataLikeContent(size)
+                                                 : NonEmptyString(RandomString(size))));
+        ScopedCompressionPolicy compression(encoding);
+        std::string serialised;
+        auto start(std::chrono::steady_clock::now());
+        for (int i(0); i != kIterations; ++i)
+          serialised = put_request.Serialise();
+        auto serialise_time(std::chrono::steady_clock::now() - start);
+        start = std::chrono::steady_clock::now();
+        for (int i(0); i != kIterations; ++i) {
+          PutRequest parsed(ParseMessageWrapper(serialised));
+          EXPECT_EQ(size, parsed.contents->content.size());
+        }
+        auto parse_time(std::chrono::steady_clock::now() - start);
+
+        auto megabytes_per_second([&](std::chrono::steady_clock::duration elapsed) {
+          return static_cast<double>(size) * kIterations /
+                 std::chrono::duration<double>(elapsed).count() / (1024 * 1024);
+        });
+        LOG(kInfo) << (encoding == PayloadEncoding::kZlib ? "zlib" : "lz4") << ", "
+                   << size / 1024 << " KiB " << (metadata ? "metadata" : "random")
+                   << " content: wire size " << serialised.size() << ", serialise "
+                   << megabytes_per_second(serialise_time) << " MB/s, parse "
+                   << megabytes_per_second(parse_time) << " MB/s";
+        if (metadata)
+          EXPECT_EQ(encoding, ParsedEncoding(serialised));
+        else
+          EXPECT_EQ(PayloadEncoding::kNone, ParsedEncoding(serialised));
+      }
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
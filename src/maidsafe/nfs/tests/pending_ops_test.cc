@@ -0,0 +1,225 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/pending_ops.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/routing/parameters.h"
+
+#include "maidsafe/nfs/utils.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+struct PendingOpsTestResponse {
+  PendingOpsTestResponse() : error_code(MakeError(NfsErrors::timed_out).code()) {}
+  explicit PendingOpsTestResponse(std::error_code error_code_in) : error_code(error_code_in) {}
+  std::error_code error_code;
+};
+
+}  // namespace test
+
+template<>
+bool IsSuccess<test::PendingOpsTestResponse>(const test::PendingOpsTestResponse& response) {
+  return !response.error_code;
+}
+
+template<>
+std::error_code ErrorCode<test::PendingOpsTestResponse>(
+    const test::PendingOpsTestResponse& response) {
+  return response.error_code;
+}
+
+namespace test {
+
+namespace {
+
+typedef PendingOpsTestResponse Response;
+
+std::shared_ptr<OpData<Response>> MakeOpData(int* resolved_count) {
+  return std::make_shared<OpData<Response>>(1,
+                                            [resolved_count](Response) { ++*resolved_count; });
+}
+
+// Collects the message IDs of hedges sent by PendingOps.
+class HedgeRecorder {
+ public:
+  HedgeRecorder() : mutex_(), cond_var_(), hedge_ids_() {}
+  std::function<void(MessageId)> Functor() {
+    return [this](MessageId hedge_id) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      hedge_ids_.push_back(hedge_id);
+      cond_var_.notify_all();
+    };
+  }
+  std::vector<MessageId> Wait(std::size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.wait_for(lock, std::chrono::seconds(5),
+                       [this, count] { return hedge_ids_.size() >= count; });
+    return hedge_ids_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+  std::vector<MessageId> hedge_ids_;
+};
+
+}  // unnamed namespace
+
+TEST(PendingOpsTest, BEH_ResolvedOpsAreRetired) {
+  AsioService asio_service(1);
+  PendingOps<Response> pending_ops(asio_service);
+  int resolved_count(0);
+  const MessageId message_id(pending_ops.Add(MakeOpData(&resolved_count),
+                                             std::chrono::seconds(10)));
+  EXPECT_TRUE(pending_ops.Contains(message_id));
+  EXPECT_FALSE(pending_ops.Contains(detail::GetNewMessageId()));
+
+  pending_ops.AddResponse(message_id, Response(std::error_code()));
+  EXPECT_EQ(1, resolved_count);
+  EXPECT_FALSE(pending_ops.Contains(message_id));
+
+  // Responses for a retired op are ignored.
+  pending_ops.AddResponse(message_id, Response(std::error_code()));
+  EXPECT_EQ(1, resolved_count);
+}
+
+TEST(PendingOpsTest, BEH_UnresolvedOpsRemainPending) {
+  AsioService asio_service(1);
+  PendingOps<Response> pending_ops(asio_service);
+  int resolved_count(0);
+  const MessageId message_id(pending_ops.Add(MakeOpData(&resolved_count),
+                                             std::chrono::seconds(10)));
+  const Response failure(MakeError(NfsErrors::failed_to_get_data).code());
+  for (int i(1); i < routing::Parameters::node_group_size; ++i) {
+    pending_ops.AddResponse(message_id, failure);
+    EXPECT_TRUE(pending_ops.Contains(message_id));
+  }
+  pending_ops.AddResponse(message_id, failure);
+  EXPECT_EQ(1, resolved_count);
+  EXPECT_FALSE(pending_ops.Contains(message_id));
+}
+
+TEST(PendingOpsTest, BEH_ManyOps) {
+  // Enough ops to force the table to grow several times, interleaved with retirements to leave
+  // erased entries along the probe sequences.
+  AsioService asio_service(1);
+  PendingOps<Response> pending_ops(asio_service);
+  const int kOpCount(1000);
+  int resolved_count(0);
+  std::vector<MessageId> message_ids;
+  std::vector<bool> retired(kOpCount, false);
+  for (int i(0); i != kOpCount; ++i) {
+    message_ids.push_back(pending_ops.Add(MakeOpData(&resolved_count), std::chrono::seconds(10)));
+    if (i % 3 == 0) {
+      pending_ops.AddResponse(message_ids[i / 2], Response(std::error_code()));
+      retired[i / 2] = true;
+    }
+  }
+  for (int i(0); i != kOpCount; ++i)
+    EXPECT_NE(retired[i], pending_ops.Contains(message_ids[i])) << i;
+
+  for (const auto& message_id : message_ids)
+    pending_ops.AddResponse(message_id, Response(std::error_code()));
+  EXPECT_EQ(kOpCount, resolved_count);
+  for (const auto& message_id : message_ids)
+    EXPECT_FALSE(pending_ops.Contains(message_id));
+}
+
+TEST(PendingOpsTest, BEH_HedgedOps) {
+  AsioService asio_service(1);
+  PendingOps<Response> pending_ops(asio_service);
+  HedgePolicy::Config config;
+  config.max_hedges = 2;
+  config.budget_percent = 100.0;
+  HedgePolicy hedge_policy(config);
+  hedge_policy.AddRequest();
+  hedge_policy.AddRequest();
+  int resolved_count(0);
+  const MessageId message_id(pending_ops.Add(MakeOpData(&resolved_count),
+                                             std::chrono::seconds(10)));
+  HedgeRecorder hedge_recorder;
+  pending_ops.ScheduleHedges(message_id, std::chrono::milliseconds(20), hedge_policy,
+                             hedge_recorder.Functor());
+  auto hedge_ids(hedge_recorder.Wait(2));
+  ASSERT_EQ(2U, hedge_ids.size());
+  EXPECT_EQ(2U, hedge_policy.stats().hedges);
+  EXPECT_TRUE(pending_ops.Contains(message_id));
+  for (const auto& hedge_id : hedge_ids) {
+    EXPECT_NE(message_id, hedge_id);
+    EXPECT_TRUE(pending_ops.Contains(hedge_id));
+  }
+
+  // No more than 'max_hedges' are sent.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(2U, hedge_recorder.Wait(0).size());
+
+  // A response to either hedge resolves the op and retires all of its attempts.
+  pending_ops.AddResponse(hedge_ids.back(), Response(std::error_code()));
+  EXPECT_EQ(1, resolved_count);
+  EXPECT_EQ(1U, hedge_policy.stats().hedge_wins);
+  EXPECT_FALSE(pending_ops.Contains(message_id));
+  for (const auto& hedge_id : hedge_ids)
+    EXPECT_FALSE(pending_ops.Contains(hedge_id));
+  pending_ops.AddResponse(message_id, Response(std::error_code()));
+  EXPECT_EQ(1, resolved_count);
+}
+
+TEST(PendingOpsTest, BEH_HedgesRespectBudget) {
+  AsioService asio_service(1);
+  PendingOps<Response> pending_ops(asio_service);
+  HedgePolicy::Config config;
+  config.max_hedges = 1;
+  config.budget_percent = 0.0;
+  HedgePolicy hedge_policy(config);
+  hedge_policy.AddRequest();
+  int resolved_count(0);
+  const MessageId message_id(pending_ops.Add(MakeOpData(&resolved_count),
+                                             std::chrono::seconds(10)));
+  HedgeRecorder hedge_recorder;
+  pending_ops.ScheduleHedges(message_id, std::chrono::milliseconds(10), hedge_policy,
+                             hedge_recorder.Functor());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(hedge_recorder.Wait(0).empty());
+  EXPECT_EQ(0U, hedge_policy.stats().hedges);
+  EXPECT_EQ(1U, hedge_policy.stats().hedges_over_budget);
+
+  pending_ops.AddResponse(message_id, Response(std::error_code()));
+  EXPECT_EQ(1, resolved_count);
+  EXPECT_EQ(0U, hedge_policy.stats().hedge_wins);
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -0,0 +1,54 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_NFS_TESTS_SCOPED_ERROR_CATEGORY_IDS_ONLY_H_
+#define MAIDSAFE_NFS_TESTS_SCOPED_ERROR_CATEGORY_IDS_ONLY_H_
+
+#include "maidsafe/nfs/error_categories.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+// Sets the global error category encoding for the lifetime of an instance, restoring the previous
+// setting on destruction, including when a test fails part way through.
+class ScopedErrorCategoryIdsOnly {
+ public:
+  explicit ScopedErrorCategoryIdsOnly(bool ids_only) : previous_(GetErrorCategoryIdsOnly()) {
+    SetErrorCategoryIdsOnly(ids_only);
+  }
+  ~ScopedErrorCategoryIdsOnly() { SetErrorCategoryIdsOnly(previous_); }
+
+ private:
+  ScopedErrorCategoryIdsOnly(const ScopedErrorCategoryIdsOnly&);
+  ScopedErrorCategoryIdsOnly(ScopedErrorCategoryIdsOnly&&);
+  ScopedErrorCategoryIdsOnly& operator=(ScopedErrorCategoryIdsOnly);
+
+  const bool previous_;
+};
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_NFS_TESTS_SCOPED_ERROR_CATEGORY_IDS_ONLY_H_
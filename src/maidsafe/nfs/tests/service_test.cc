@@ -18,18 +18,26 @@
 
 #include "maidsafe/nfs/service.h"
 
+#include <chrono>
+#include <memory>
+#include <tuple>
+#include <vector>
+
 #include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/log.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/utils.h"
 
 #include "maidsafe/routing/routing_api.h"
-#include "maidsafe/routing/timer.h"
 #include "maidsafe/passport/types.h"
 #include "maidsafe/data_types/immutable_data.h"
 
 #include "maidsafe/nfs/message_types.h"
 #include "maidsafe/nfs/message_wrapper.h"
+#include "maidsafe/nfs/pending_ops.h"
+#include "maidsafe/nfs/utils.h"
+#include "maidsafe/nfs/client/data_cache.h"
 #include "maidsafe/nfs/client/data_getter_service.h"
 #include "maidsafe/nfs/client/maid_node_service.h"
 #include "maidsafe/nfs/client/messages.h"
@@ -42,26 +50,98 @@ namespace nfs {
 
 namespace test {
 
+namespace {
+
+const int kDispatchIterations(10000);
+
+template<typename Contents>
+std::shared_ptr<OpData<Contents>> MakeOpData(bool* resolved = nullptr) {
+  return std::make_shared<OpData<Contents>>(1, [resolved](Contents) {
+                                                   if (resolved)
+                                                     *resolved = true;
+                                                 });
+}
+
+// Logs the mean cost of handling 'message' via the generated dispatch table, alongside the cost of
+// the previous approach of parsing into the service's variant and visiting it.  Both include the
+// cost of parsing the message's contents, so the difference between them is the dispatch overhead.
+// 'pending_ops' must be the index which the persona service consults for this type of message.
+// Since a response retires its op, every iteration is given a message ID with its own pending op.
+template<typename PersonaService, typename Message>
+void MeasureDispatchCost(std::unique_ptr<PersonaService>&& persona_service,
+                         const Message& message,
+                         PendingOps<typename Message::Contents>& pending_ops) {
+  typedef typename Message::Sender Sender;
+  typedef typename Message::Receiver Receiver;
+  Sender sender((routing::GroupId(NodeId(NodeId::kRandomId))),
+                (routing::SingleId(NodeId(NodeId::kRandomId))));
+  Receiver receiver(NodeId(NodeId::kRandomId));
+  const std::string serialised_message(message.Serialise());
+  const auto parsed_message(ParseMessageWrapper(serialised_message));
+  auto make_live_messages([&]() -> std::vector<TypeErasedMessageWrapper> {
+    std::vector<TypeErasedMessageWrapper> live_messages(kDispatchIterations, parsed_message);
+    for (auto& live_message : live_messages) {
+      std::get<3>(live_message) = pending_ops.Add(MakeOpData<typename Message::Contents>(),
+                                                  std::chrono::minutes(1));
+    }
+    return live_messages;
+  });
+
+  PersonaService& persona_service_ref(*persona_service);
+  Service<PersonaService> service(std::move(persona_service));
+  const detail::PersonaDemuxer<PersonaService, Sender, Receiver> demuxer(persona_service_ref,
+                                                                         sender, receiver);
+
+  auto live_messages(make_live_messages());
+  auto start(std::chrono::steady_clock::now());
+  for (const auto& live_message : live_messages) {
+    typename PersonaService::PublicMessages variant_message;
+    ASSERT_TRUE(GetVariant(live_message, variant_message));
+    boost::apply_visitor(demuxer, variant_message);
+  }
+  auto variant_duration(std::chrono::steady_clock::now() - start);
+
+  live_messages = make_live_messages();
+  start = std::chrono::steady_clock::now();
+  for (const auto& live_message : live_messages)
+    service.HandleMessage(live_message, sender, receiver);
+  auto table_duration(std::chrono::steady_clock::now() - start);
+
+  LOG(kInfo) << "Mean cost per message over " << kDispatchIterations << " iterations: variant "
+             << std::chrono::duration_cast<std::chrono::nanoseconds>(variant_duration).count() /
+                kDispatchIterations
+             << " ns, dispatch table "
+             << std::chrono::duration_cast<std::chrono::nanoseconds>(table_duration).count() /
+                kDispatchIterations
+             << " ns";
+}
+
+}  // unnamed namespace
+
 TEST(MaidNodeService, BEH_All) {
   passport::Anmaid anmaid;
   passport::Maid maid(anmaid);
   routing::Routing routing(maid);
   AsioService asio_service(2);
-  routing::Timer<nfs_client::MaidNodeService::GetResponse::Contents> get_timer(asio_service);
-  routing::Timer<nfs_client::MaidNodeService::GetVersionsResponse::Contents>
-      get_versions_timer(asio_service);
-  routing::Timer<nfs_client::MaidNodeService::GetBranchResponse::Contents>
-      get_branch_timer(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetResponse::Contents> get_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetVersionsResponse::Contents>
+      get_versions_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetBranchResponse::Contents>
+      get_branch_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::PutResponse::Contents> put_ops(asio_service);
   maidsafe::nfs::Service<nfs_client::MaidNodeService> service(
       std::move(std::unique_ptr<nfs_client::MaidNodeService>(
-          new nfs_client::MaidNodeService(routing, get_timer, get_versions_timer,
-                                            get_branch_timer))));
+          new nfs_client::MaidNodeService(routing, get_ops, get_versions_ops,
+                                          get_branch_ops, put_ops))));
 
   ImmutableData immutable_data(NonEmptyString(RandomString(10)));
   nfs_client::DataNameAndContentOrReturnCode contents(immutable_data);
 
   typedef nfs::GetResponseFromDataManagerToMaidNode GetResponse;
-  GetResponse get_response(contents);
+  bool resolved(false);
+  GetResponse get_response(
+      get_ops.Add(MakeOpData<GetResponse::Contents>(&resolved), std::chrono::seconds(10)),
+      contents);
   auto serialised_get_response(get_response.Serialise());
 
   NodeId sender_node_id(NodeId::kRandomId);
@@ -74,6 +154,185 @@ TEST(MaidNodeService, BEH_All) {
   auto response_tuple(ParseMessageWrapper(serialised_get_response));
 
   service.HandleMessage(response_tuple, sender, receiver);
+  EXPECT_TRUE(resolved);
+  EXPECT_FALSE(get_ops.Contains(get_response.message_id));
+}
+
+TEST(MaidNodeService, FUNC_DispatchCost) {
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  routing::Routing routing(maid);
+  AsioService asio_service(2);
+  PendingOps<nfs_client::MaidNodeService::GetResponse::Contents> get_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetVersionsResponse::Contents>
+      get_versions_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetBranchResponse::Contents>
+      get_branch_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::PutResponse::Contents> put_ops(asio_service);
+  ImmutableData immutable_data(NonEmptyString(RandomString(10)));
+  MeasureDispatchCost(
+      std::unique_ptr<nfs_client::MaidNodeService>(new nfs_client::MaidNodeService(
+          routing, get_ops, get_versions_ops, get_branch_ops, put_ops)),
+      GetResponseFromDataManagerToMaidNode(nfs_client::DataNameAndContentOrReturnCode(
+          immutable_data)),
+      get_ops);
+}
+
+TEST(MaidNodeService, BEH_DropStaleResponses) {
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  routing::Routing routing(maid);
+  AsioService asio_service(2);
+  PendingOps<nfs_client::MaidNodeService::GetResponse::Contents> get_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetVersionsResponse::Contents>
+      get_versions_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetBranchResponse::Contents>
+      get_branch_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::PutResponse::Contents> put_ops(asio_service);
+  maidsafe::nfs::Service<nfs_client::MaidNodeService> service(
+      std::move(std::unique_ptr<nfs_client::MaidNodeService>(
+          new nfs_client::MaidNodeService(routing, get_ops, get_versions_ops,
+                                          get_branch_ops, put_ops))));
+
+  // A response with unparseable contents is only rejected if its op is still pending, since the
+  // contents of a stale response are never looked at.
+  typedef nfs::GetResponseFromDataManagerToMaidNode GetResponse;
+  GetResponse::Sender sender((routing::GroupId(NodeId(NodeId::kRandomId))),
+                             (routing::SingleId(NodeId(NodeId::kRandomId))));
+  GetResponse::Receiver receiver(NodeId(NodeId::kRandomId));
+  auto handle_garbage_response([&](MessageId message_id) {
+    const std::string serialised_get_response(detail::SerialiseMessageWrapper(
+        MessageAction::kGetResponse, Persona::kDataManager, Persona::kMaidNode, message_id,
+        RandomString(100)));
+    service.HandleMessage(ParseMessageWrapper(serialised_get_response), sender, receiver);
+  });
+
+  EXPECT_NO_THROW(handle_garbage_response(detail::GetNewMessageId()));
+  // Pending, but for a different action.
+  const MessageId versions_message_id(get_versions_ops.Add(
+      MakeOpData<nfs_client::MaidNodeService::GetVersionsResponse::Contents>(),
+      std::chrono::seconds(10)));
+  EXPECT_NO_THROW(handle_garbage_response(versions_message_id));
+
+  bool resolved(false);
+  const MessageId message_id(get_ops.Add(MakeOpData<GetResponse::Contents>(&resolved),
+                                         std::chrono::seconds(10)));
+  EXPECT_THROW(handle_garbage_response(message_id), std::exception);
+  EXPECT_FALSE(resolved);
+
+  // Retire the op with a valid response.
+  ImmutableData immutable_data(NonEmptyString(RandomString(10)));
+  GetResponse get_response(message_id, nfs_client::DataNameAndContentOrReturnCode(immutable_data));
+  auto serialised_get_response(get_response.Serialise());
+  service.HandleMessage(ParseMessageWrapper(serialised_get_response), sender, receiver);
+  EXPECT_TRUE(resolved);
+  EXPECT_NO_THROW(handle_garbage_response(message_id));
+}
+
+TEST(MaidNodeService, BEH_PutResponse) {
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  routing::Routing routing(maid);
+  AsioService asio_service(2);
+  PendingOps<nfs_client::MaidNodeService::GetResponse::Contents> get_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetVersionsResponse::Contents>
+      get_versions_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetBranchResponse::Contents>
+      get_branch_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::PutResponse::Contents> put_ops(asio_service);
+  maidsafe::nfs::Service<nfs_client::MaidNodeService> service(
+      std::move(std::unique_ptr<nfs_client::MaidNodeService>(
+          new nfs_client::MaidNodeService(routing, get_ops, get_versions_ops,
+                                          get_branch_ops, put_ops))));
+
+  typedef nfs::PutResponseFromMaidManagerToMaidNode PutResponse;
+  ImmutableData immutable_data(NonEmptyString(RandomString(10)));
+  PutResponse::Contents contents;
+  contents.data_and_pmid_hint = nfs_vault::DataAndPmidHint(
+      nfs_vault::DataName(immutable_data.name()), immutable_data.Serialise().data,
+      Identity(RandomString(64)));
+  EXPECT_TRUE(IsSuccess(contents));
+  EXPECT_FALSE(IsSuccess(PutResponse::Contents()));
+
+  // Requires two successes to resolve.
+  bool resolved(false);
+  PutResponse::Contents result;
+  const MessageId message_id(put_ops.Add(
+      std::make_shared<OpData<PutResponse::Contents>>(2, [&](PutResponse::Contents response) {
+                                                            resolved = true;
+                                                            result = response;
+                                                          }),
+      std::chrono::seconds(10)));
+  PutResponse put_response(message_id, contents);
+  auto serialised_put_response(put_response.Serialise());
+  PutResponse::Sender sender((routing::GroupId(NodeId(NodeId::kRandomId))),
+                             (routing::SingleId(NodeId(NodeId::kRandomId))));
+  PutResponse::Receiver receiver(NodeId(NodeId::kRandomId));
+
+  service.HandleMessage(ParseMessageWrapper(serialised_put_response), sender, receiver);
+  EXPECT_FALSE(resolved);
+  service.HandleMessage(ParseMessageWrapper(serialised_put_response), sender, receiver);
+  EXPECT_TRUE(resolved);
+  EXPECT_TRUE(IsSuccess(result));
+  EXPECT_FALSE(put_ops.Contains(message_id));
+}
+
+TEST(MaidNodeService, BEH_GetCachedResponse) {
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  routing::Routing routing(maid);
+  AsioService asio_service(2);
+  PendingOps<nfs_client::MaidNodeService::GetResponse::Contents> get_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetVersionsResponse::Contents>
+      get_versions_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::GetBranchResponse::Contents>
+      get_branch_ops(asio_service);
+  PendingOps<nfs_client::MaidNodeService::PutResponse::Contents> put_ops(asio_service);
+  maidsafe::nfs::Service<nfs_client::MaidNodeService> service(
+      std::move(std::unique_ptr<nfs_client::MaidNodeService>(
+          new nfs_client::MaidNodeService(routing, get_ops, get_versions_ops,
+                                          get_branch_ops, put_ops))));
+
+  typedef nfs::GetCachedResponseFromPmidNodeToMaidNode GetCachedResponse;
+  GetCachedResponse::Sender sender(NodeId(NodeId::kRandomId));
+  GetCachedResponse::Receiver receiver(NodeId(NodeId::kRandomId));
+  ImmutableData immutable_data(NonEmptyString(RandomString(10)));
+  ImmutableData other_data(NonEmptyString(RandomString(10)));
+  const std::string key(nfs_client::DataCache::Key(ImmutableData::Tag::kValue,
+                                                   immutable_data.name().value));
+  bool resolved(false);
+  auto handle_cached_response([&](MessageId message_id,
+                                   const GetCachedResponse::Contents& contents) {
+    GetCachedResponse cached_response(message_id, contents);
+    auto serialised_cached_response(cached_response.Serialise());
+    service.HandleMessage(ParseMessageWrapper(serialised_cached_response), sender, receiver);
+  });
+
+  // Ops added without a key, or for different data, can't be resolved by a cached copy.
+  MessageId message_id(get_ops.Add(MakeOpData<GetCachedResponse::Contents>(&resolved),
+                                   std::chrono::seconds(10)));
+  handle_cached_response(message_id, GetCachedResponse::Contents(immutable_data));
+  EXPECT_FALSE(resolved);
+  handle_cached_response(message_id, GetCachedResponse::Contents(other_data));
+  EXPECT_FALSE(resolved);
+
+  // A copy whose content doesn't hash to its name is dropped, as are failures.
+  message_id = get_ops.Add(MakeOpData<GetCachedResponse::Contents>(&resolved),
+                           std::chrono::seconds(10), key);
+  GetCachedResponse::Contents tampered_contents(immutable_data);
+  tampered_contents.data->content = SharedBuffer(other_data.Serialise().data);
+  handle_cached_response(message_id, tampered_contents);
+  EXPECT_FALSE(resolved);
+  handle_cached_response(message_id, GetCachedResponse::Contents(
+      nfs_client::DataNameAndReturnCode(nfs_vault::DataName(immutable_data.name()),
+                                        nfs_client::ReturnCode(NfsErrors::failed_to_get_data))));
+  EXPECT_FALSE(resolved);
+  EXPECT_TRUE(get_ops.Contains(message_id));
+
+  // The first valid copy resolves the op.
+  handle_cached_response(message_id, GetCachedResponse::Contents(immutable_data));
+  EXPECT_TRUE(resolved);
+  EXPECT_FALSE(get_ops.Contains(message_id));
 }
 
 TEST(DataGetterService, BEH_All) {
@@ -81,21 +340,24 @@ TEST(DataGetterService, BEH_All) {
   passport::Maid maid(anmaid);
   routing::Routing routing(maid);
   AsioService asio_service(2);
-  routing::Timer<nfs_client::DataGetterService::GetResponse::Contents> get_timer(asio_service);
-  routing::Timer<nfs_client::DataGetterService::GetVersionsResponse::Contents>
-      get_versions_timer(asio_service);
-  routing::Timer<nfs_client::DataGetterService::GetBranchResponse::Contents>
-      get_branch_timer(asio_service);
+  PendingOps<nfs_client::DataGetterService::GetResponse::Contents> get_ops(asio_service);
+  PendingOps<nfs_client::DataGetterService::GetVersionsResponse::Contents>
+      get_versions_ops(asio_service);
+  PendingOps<nfs_client::DataGetterService::GetBranchResponse::Contents>
+      get_branch_ops(asio_service);
   maidsafe::nfs::Service<nfs_client::DataGetterService> service(
       std::move(std::unique_ptr<nfs_client::DataGetterService>(
-          new nfs_client::DataGetterService(routing, get_timer, get_versions_timer,
-                                            get_branch_timer))));
+          new nfs_client::DataGetterService(routing, get_ops, get_versions_ops,
+                                            get_branch_ops))));
 
   ImmutableData immutable_data(NonEmptyString(RandomString(10)));
   nfs_client::DataNameAndContentOrReturnCode contents(immutable_data);
 
   typedef nfs::GetResponseFromDataManagerToDataGetter GetResponse;
-  GetResponse get_response(contents);
+  bool resolved(false);
+  GetResponse get_response(
+      get_ops.Add(MakeOpData<GetResponse::Contents>(&resolved), std::chrono::seconds(10)),
+      contents);
   auto serialised_get_response(get_response.Serialise());
 
   NodeId sender_node_id(NodeId::kRandomId);
@@ -108,6 +370,27 @@ TEST(DataGetterService, BEH_All) {
   auto response_tuple(ParseMessageWrapper(serialised_get_response));
 
   service.HandleMessage(response_tuple, sender, receiver);
+  EXPECT_TRUE(resolved);
+  EXPECT_FALSE(get_ops.Contains(get_response.message_id));
+}
+
+TEST(DataGetterService, FUNC_DispatchCost) {
+  passport::Anmaid anmaid;
+  passport::Maid maid(anmaid);
+  routing::Routing routing(maid);
+  AsioService asio_service(2);
+  PendingOps<nfs_client::DataGetterService::GetResponse::Contents> get_ops(asio_service);
+  PendingOps<nfs_client::DataGetterService::GetVersionsResponse::Contents>
+      get_versions_ops(asio_service);
+  PendingOps<nfs_client::DataGetterService::GetBranchResponse::Contents>
+      get_branch_ops(asio_service);
+  ImmutableData immutable_data(NonEmptyString(RandomString(10)));
+  MeasureDispatchCost(
+      std::unique_ptr<nfs_client::DataGetterService>(new nfs_client::DataGetterService(
+          routing, get_ops, get_versions_ops, get_branch_ops)),
+      GetResponseFromDataManagerToDataGetter(nfs_client::DataNameAndContentOrReturnCode(
+          immutable_data)),
+      get_ops);
 }
 
 }  // namespace test
@@ -0,0 +1,102 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/shared_buffer.h"
+
+#include <utility>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/data_types/immutable_data.h"
+
+#include "maidsafe/nfs/client/messages.h"
+#include "maidsafe/nfs/vault/messages.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+TEST(SharedBufferTest, BEH_CopiesShareContent) {
+  NonEmptyString content(RandomString(1024));
+  SharedBuffer buffer(content);
+  EXPECT_TRUE(buffer.IsInitialised());
+  EXPECT_EQ(content, buffer.non_empty_string());
+  EXPECT_EQ(content.string().size(), buffer.size());
+  EXPECT_EQ(1, buffer.use_count());
+
+  SharedBuffer copy(buffer);
+  EXPECT_EQ(2, buffer.use_count());
+  EXPECT_EQ(&buffer.string(), &copy.string());
+  EXPECT_EQ(buffer, copy);
+  EXPECT_EQ(buffer, SharedBuffer(content));
+  EXPECT_NE(buffer, SharedBuffer(NonEmptyString(RandomString(1024))));
+
+  SharedBuffer moved(std::move(copy));
+  EXPECT_FALSE(copy.IsInitialised());
+  EXPECT_EQ(2, buffer.use_count());
+}
+
+TEST(SharedBufferTest, BEH_Uninitialised) {
+  SharedBuffer buffer;
+  EXPECT_FALSE(buffer.IsInitialised());
+  EXPECT_EQ(0U, buffer.size());
+  EXPECT_THROW(buffer.non_empty_string(), maidsafe_error);
+  EXPECT_THROW(buffer.string(), maidsafe_error);
+  EXPECT_EQ(buffer, SharedBuffer());
+  EXPECT_NE(buffer, SharedBuffer(NonEmptyString(RandomString(1))));
+}
+
+TEST(SharedBufferTest, BEH_MessagesShareContent) {
+  ImmutableData data(NonEmptyString(RandomString(1024)));
+  nfs_client::DataNameAndContentOrReturnCode response(data);
+  ASSERT_TRUE(response.data);
+  const std::string* bytes(&response.data->content.string());
+
+  nfs_client::DataNameAndContentOrReturnCode response_copy(response);
+  EXPECT_EQ(bytes, &response_copy.data->content.string());
+
+  nfs_vault::DataAndPmidHint data_and_pmid_hint(response.data->name, response.data->content,
+                                                Identity(RandomString(64)));
+  nfs_vault::DataAndPmidHint data_and_pmid_hint_copy(data_and_pmid_hint);
+  EXPECT_EQ(bytes, &data_and_pmid_hint_copy.data.content.string());
+
+  nfs_client::DataNameAndContentAndReturnCode content_and_return_code(
+      response.data->name.type, response.data->name.raw_name,
+      nfs_client::ReturnCode(CommonErrors::success), response.data->content);
+  nfs_client::DataNameAndContentAndReturnCode content_and_return_code_copy(
+      content_and_return_code);
+  ASSERT_TRUE(content_and_return_code_copy.content);
+  EXPECT_EQ(bytes, &content_and_return_code_copy.content->string());
+  EXPECT_EQ(6, response.data->content.use_count());
+
+  // Parsing allocates the content once.
+  nfs_client::DataNameAndContentOrReturnCode parsed(response.Serialise());
+  ASSERT_TRUE(parsed.data);
+  EXPECT_EQ(1, parsed.data->content.use_count());
+  EXPECT_EQ(response.data->content, parsed.data->content);
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
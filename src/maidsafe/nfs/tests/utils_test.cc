@@ -0,0 +1,146 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/nfs/utils.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/routing/parameters.h"
+
+
+namespace maidsafe {
+
+namespace nfs {
+
+namespace test {
+
+struct TestResponse {
+  TestResponse() : error_code(), id(-1) {}
+  TestResponse(std::error_code error_code_in, int id_in) : error_code(error_code_in), id(id_in) {}
+  std::error_code error_code;
+  int id;
+};
+
+}  // namespace test
+
+template<>
+bool IsSuccess<test::TestResponse>(const test::TestResponse& response) {
+  return !response.error_code;
+}
+
+template<>
+std::error_code ErrorCode<test::TestResponse>(const test::TestResponse& response) {
+  return response.error_code;
+}
+
+namespace test {
+
+TEST(OpDataTest, BEH_InvalidParameters) {
+  auto callback([](TestResponse) {});
+  EXPECT_THROW(OpData<TestResponse>(0, callback), maidsafe_error);
+  EXPECT_THROW(OpData<TestResponse>(routing::Parameters::node_group_size + 1, callback),
+               maidsafe_error);
+  EXPECT_THROW(OpData<TestResponse>(1, nullptr), maidsafe_error);
+}
+
+TEST(OpDataTest, BEH_SuccessQuorum) {
+  ASSERT_GE(routing::Parameters::node_group_size, 3);
+  int call_count(0);
+  TestResponse result;
+  OpData<TestResponse> op_data(2, [&](TestResponse response) {
+                                    ++call_count;
+                                    result = response;
+                                  });
+  EXPECT_FALSE(op_data.HandleResponseContents(TestResponse(std::error_code(), 0)));
+  EXPECT_FALSE(op_data.HandleResponseContents(
+      TestResponse(MakeError(CommonErrors::unknown).code(), 1)));
+  EXPECT_EQ(0, call_count);
+  EXPECT_TRUE(op_data.HandleResponseContents(TestResponse(std::error_code(), 2)));
+  EXPECT_EQ(1, call_count);
+  EXPECT_EQ(2, result.id);
+  for (int i(0); i != routing::Parameters::node_group_size; ++i)
+    EXPECT_FALSE(op_data.HandleResponseContents(TestResponse(std::error_code(), 3 + i)));
+  EXPECT_EQ(1, call_count);
+}
+
+TEST(OpDataTest, BEH_MostFrequentFailure) {
+  ASSERT_GE(routing::Parameters::node_group_size, 4);
+  int call_count(0);
+  TestResponse result;
+  OpData<TestResponse> op_data(routing::Parameters::node_group_size,
+                               [&](TestResponse response) {
+                                 ++call_count;
+                                 result = response;
+                               });
+  const std::error_code less_frequent(MakeError(CommonErrors::invalid_parameter).code());
+  const std::error_code most_frequent(MakeError(CommonErrors::no_such_element).code());
+  op_data.HandleResponseContents(TestResponse(less_frequent, 0));
+  op_data.HandleResponseContents(TestResponse(most_frequent, 1));
+  op_data.HandleResponseContents(TestResponse(most_frequent, 2));
+  for (int i(3); i < routing::Parameters::node_group_size; ++i) {
+    EXPECT_EQ(0, call_count);
+    op_data.HandleResponseContents(TestResponse(std::error_code(), i));
+  }
+  EXPECT_EQ(1, call_count);
+  EXPECT_EQ(most_frequent, result.error_code);
+  EXPECT_EQ(1, result.id);
+}
+
+TEST(OpDataTest, FUNC_ConcurrentResponses) {
+  const int kThreadCount(8), kIterations(1000);
+  const std::error_code failure(MakeError(CommonErrors::unknown).code());
+  for (int iteration(0); iteration != kIterations; ++iteration) {
+    std::atomic<int> call_count(0);
+    std::atomic<bool> succeeded(false);
+    const bool expect_success(iteration % 2 == 0);
+    OpData<TestResponse> op_data(1, [&](TestResponse response) {
+                                      ++call_count;
+                                      succeeded = IsSuccess(response);
+                                    });
+    std::vector<std::thread> threads;
+    for (int i(0); i != kThreadCount; ++i) {
+      threads.emplace_back([&, i] {
+        // When a success is expected, only the last thread sends one.
+        for (int j(0); j != routing::Parameters::node_group_size; ++j) {
+          bool send_success(expect_success && i == kThreadCount - 1);
+          op_data.HandleResponseContents(
+              TestResponse(send_success ? std::error_code() : failure, j));
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    ASSERT_EQ(1, call_count.load());
+    // With every thread racing, the failures may reach 'node_group_size' before the success
+    // arrives; otherwise the success must win.
+    if (!expect_success) {
+      EXPECT_FALSE(succeeded.load());
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace nfs
+
+}  // namespace maidsafe
@@ -20,6 +20,7 @@
 
 #include <cstdint>
 
+#include "maidsafe/nfs/protobuf_message.h"
 #include "maidsafe/nfs/vault/messages.pb.h"
 
 
@@ -51,18 +52,18 @@ DataName& DataName::operator=(DataName other) {
 DataName::DataName(const std::string& serialised_copy)
     : type(DataTagValue::kAnmidValue),
       raw_name() {
-  protobuf::DataName proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataName> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  type = static_cast<DataTagValue>(proto_copy.type());
-  raw_name = Identity(proto_copy.raw_name());
+  type = static_cast<DataTagValue>(proto_copy->type());
+  raw_name = Identity(proto_copy->raw_name());
 }
 
 std::string DataName::Serialise() const {
-  protobuf::DataName proto_data_name;
-  proto_data_name.set_type(static_cast<uint32_t>(type));
-  proto_data_name.set_raw_name(raw_name.string());
-  return proto_data_name.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataName> proto_data_name;
+  proto_data_name->set_type(static_cast<uint32_t>(type));
+  proto_data_name->set_raw_name(raw_name.string());
+  return proto_data_name->SerializeAsString();
 }
 
 bool operator==(const DataName& lhs, const DataName& rhs) {
@@ -97,18 +98,18 @@ DataNameAndVersion& DataNameAndVersion::operator=(DataNameAndVersion other) {
 DataNameAndVersion::DataNameAndVersion(const std::string& serialised_copy)
     : data_name(),
       version_name() {
-  protobuf::DataNameAndVersion proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndVersion> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  data_name = DataName(proto_copy.serialised_data_name());
-  version_name = StructuredDataVersions::VersionName(proto_copy.serialised_version_name());
+  data_name = DataName(proto_copy->serialised_data_name());
+  version_name = StructuredDataVersions::VersionName(proto_copy->serialised_version_name());
 }
 
 std::string DataNameAndVersion::Serialise() const {
-  protobuf::DataNameAndVersion proto_copy;
-  proto_copy.set_serialised_data_name(data_name.Serialise());
-  proto_copy.set_serialised_version_name(version_name.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndVersion> proto_copy;
+  proto_copy->set_serialised_data_name(data_name.Serialise());
+  proto_copy->set_serialised_version_name(version_name.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndVersion& lhs, const DataNameAndVersion& rhs) {
@@ -149,20 +150,20 @@ DataNameOldNewVersion::DataNameOldNewVersion(const std::string& serialised_copy)
     : data_name(),
       old_version_name(),
       new_version_name() {
-  protobuf::DataNameOldNewVersion proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameOldNewVersion> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  data_name = DataName(proto_copy.serialised_data_name());
-  old_version_name = StructuredDataVersions::VersionName(proto_copy.serialised_old_version_name());
-  new_version_name = StructuredDataVersions::VersionName(proto_copy.serialised_new_version_name());
+  data_name = DataName(proto_copy->serialised_data_name());
+  old_version_name = StructuredDataVersions::VersionName(proto_copy->serialised_old_version_name());
+  new_version_name = StructuredDataVersions::VersionName(proto_copy->serialised_new_version_name());
 }
 
 std::string DataNameOldNewVersion::Serialise() const {
-  protobuf::DataNameOldNewVersion proto_copy;
-  proto_copy.set_serialised_data_name(data_name.Serialise());
-  proto_copy.set_serialised_old_version_name(old_version_name.Serialise());
-  proto_copy.set_serialised_new_version_name(new_version_name.Serialise());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataNameOldNewVersion> proto_copy;
+  proto_copy->set_serialised_data_name(data_name.Serialise());
+  proto_copy->set_serialised_old_version_name(old_version_name.Serialise());
+  proto_copy->set_serialised_new_version_name(new_version_name.Serialise());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameOldNewVersion& lhs, const DataNameOldNewVersion& rhs) {
@@ -186,6 +187,11 @@ DataNameAndContent::DataNameAndContent(DataTagValue type_in,
                                        NonEmptyString content_in)
     : name(type_in, name_in), content(std::move(content_in)) {}
 
+DataNameAndContent::DataNameAndContent(DataTagValue type_in,
+                                       const Identity& name_in,
+                                       nfs::SharedBuffer content_in)
+    : name(type_in, name_in), content(std::move(content_in)) {}
+
 DataNameAndContent::DataNameAndContent() : name(), content() {}
 
 DataNameAndContent::DataNameAndContent(const DataNameAndContent& other)
@@ -204,18 +210,18 @@ DataNameAndContent& DataNameAndContent::operator=(DataNameAndContent other) {
 DataNameAndContent::DataNameAndContent(const std::string& serialised_copy)
     : name(),
       content() {
-  protobuf::DataNameAndContent proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndContent> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  name = DataName(proto_copy.serialised_name());
-  content = NonEmptyString(proto_copy.content());
+  name = DataName(proto_copy->serialised_name());
+  content = nfs::SharedBuffer(NonEmptyString(proto_copy->content()));
 }
 
 std::string DataNameAndContent::Serialise() const {
-  protobuf::DataNameAndContent proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_content(content.string());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndContent> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_content(content.string());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndContent& lhs, const DataNameAndContent& rhs) {
@@ -250,18 +256,18 @@ DataNameAndCost& DataNameAndCost::operator=(DataNameAndCost other) {
 DataNameAndCost::DataNameAndCost(const std::string& serialised_copy)
     : name(),
       cost(0) {
-  protobuf::DataNameAndCost proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndCost> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  name = DataName(proto_copy.serialised_name());
-  cost = proto_copy.cost();
+  name = DataName(proto_copy->serialised_name());
+  cost = proto_copy->cost();
 }
 
 std::string DataNameAndCost::Serialise() const {
-  protobuf::DataNameAndCost proto_copy;
-  proto_copy.set_serialised_name(name.Serialise());
-  proto_copy.set_cost(cost);
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataNameAndCost> proto_copy;
+  proto_copy->set_serialised_name(name.Serialise());
+  proto_copy->set_cost(cost);
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataNameAndCost& lhs, const DataNameAndCost& rhs) {
@@ -284,6 +290,12 @@ DataAndPmidHint::DataAndPmidHint(const DataName& data_name,
     : data(data_name.type, data_name.raw_name, content),
       pmid_hint(std::move(pmid_node_hint)) {}
 
+DataAndPmidHint::DataAndPmidHint(const DataName& data_name,
+                                 nfs::SharedBuffer content,
+                                 Identity pmid_node_hint)
+    : data(data_name.type, data_name.raw_name, std::move(content)),
+      pmid_hint(std::move(pmid_node_hint)) {}
+
 DataAndPmidHint::DataAndPmidHint(const DataAndPmidHint& other)
     : data(other.data),
       pmid_hint(other.pmid_hint) {}
@@ -300,18 +312,18 @@ DataAndPmidHint& DataAndPmidHint::operator=(DataAndPmidHint other) {
 DataAndPmidHint::DataAndPmidHint(const std::string& serialised_copy)
     : data(),
       pmid_hint() {
-  protobuf::DataAndPmidHint proto_copy;
-  if (!proto_copy.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::DataAndPmidHint> proto_copy;
+  if (!proto_copy->ParseFromString(serialised_copy))
     ThrowError(CommonErrors::parsing_error);
-  data = DataNameAndContent(proto_copy.serialised_data_name_and_content());
-  pmid_hint = Identity(proto_copy.pmid_hint());
+  data = DataNameAndContent(proto_copy->serialised_data_name_and_content());
+  pmid_hint = Identity(proto_copy->pmid_hint());
 }
 
 std::string DataAndPmidHint::Serialise() const {
-  protobuf::DataAndPmidHint proto_copy;
-  proto_copy.set_serialised_data_name_and_content(data.Serialise());
-  proto_copy.set_pmid_hint(pmid_hint.string());
-  return proto_copy.SerializeAsString();
+  nfs::detail::ProtobufMessage<protobuf::DataAndPmidHint> proto_copy;
+  proto_copy->set_serialised_data_name_and_content(data.Serialise());
+  proto_copy->set_pmid_hint(pmid_hint.string());
+  return proto_copy->SerializeAsString();
 }
 
 bool operator==(const DataAndPmidHint& lhs, const DataAndPmidHint& rhs) {
@@ -327,4 +339,203 @@ void swap(DataAndPmidHint& lhs, DataAndPmidHint& rhs) MAIDSAFE_NOEXCEPT {
 
 }  // namespace nfs_vault
 
+
+
+namespace nfs {
+
+namespace {
+
+// Protobuf encodes negative int32 values as sign-extended 64-bit varints.
+uint64_t Int32Varint(int32_t value) {
+  return static_cast<uint64_t>(static_cast<int64_t>(value));
+}
+
+}  // unnamed namespace
+
+// ==================== DataName ===================================================================
+std::size_t DirectCodec<nfs_vault::DataName>::Size(const Contents& contents) {
+  typedef nfs_vault::protobuf::DataName ProtobufType;
+  return detail::VarintFieldSize(ProtobufType::kTypeFieldNumber,
+                                 static_cast<uint32_t>(contents.type)) +
+         detail::BytesFieldSize(ProtobufType::kRawNameFieldNumber,
+                                contents.raw_name.string().size());
+}
+
+void DirectCodec<nfs_vault::DataName>::AppendTo(const Contents& contents, std::string& buffer) {
+  typedef nfs_vault::protobuf::DataName ProtobufType;
+  detail::AppendVarintField(ProtobufType::kTypeFieldNumber, static_cast<uint32_t>(contents.type),
+                            buffer);
+  detail::AppendBytesField(ProtobufType::kRawNameFieldNumber, contents.raw_name.string(), buffer);
+}
+
+nfs_vault::DataName DirectCodec<nfs_vault::DataName>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_vault::protobuf::DataName ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  const auto type(static_cast<uint32_t>(fields.varint(ProtobufType::kTypeFieldNumber)));
+  return nfs_vault::DataName(static_cast<DataTagValue>(type),
+                             Identity(fields.bytes(ProtobufType::kRawNameFieldNumber).to_string()));
+}
+
+// ==================== DataNameAndVersion =========================================================
+// Version names are opaque here, so are serialised for both 'Size' and 'AppendTo'; they're small.
+std::size_t DirectCodec<nfs_vault::DataNameAndVersion>::Size(const Contents& contents) {
+  typedef nfs_vault::protobuf::DataNameAndVersion ProtobufType;
+  return detail::NestedFieldSize(ProtobufType::kSerialisedDataNameFieldNumber, contents.data_name) +
+         detail::BytesFieldSize(ProtobufType::kSerialisedVersionNameFieldNumber,
+                                contents.version_name.Serialise().size());
+}
+
+void DirectCodec<nfs_vault::DataNameAndVersion>::AppendTo(const Contents& contents,
+                                                          std::string& buffer) {
+  typedef nfs_vault::protobuf::DataNameAndVersion ProtobufType;
+  detail::AppendNestedField(ProtobufType::kSerialisedDataNameFieldNumber,
+                            contents.data_name, buffer);
+  detail::AppendBytesField(ProtobufType::kSerialisedVersionNameFieldNumber,
+                           contents.version_name.Serialise(), buffer);
+}
+
+nfs_vault::DataNameAndVersion DirectCodec<nfs_vault::DataNameAndVersion>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_vault::protobuf::DataNameAndVersion ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_vault::DataNameAndVersion data_name_and_version;
+  data_name_and_version.data_name = DirectCodec<nfs_vault::DataName>::Parse(
+      fields.bytes(ProtobufType::kSerialisedDataNameFieldNumber));
+  data_name_and_version.version_name = StructuredDataVersions::VersionName(
+      fields.bytes(ProtobufType::kSerialisedVersionNameFieldNumber).to_string());
+  return data_name_and_version;
+}
+
+// ==================== DataNameOldNewVersion ======================================================
+std::size_t DirectCodec<nfs_vault::DataNameOldNewVersion>::Size(const Contents& contents) {
+  typedef nfs_vault::protobuf::DataNameOldNewVersion ProtobufType;
+  return detail::NestedFieldSize(ProtobufType::kSerialisedDataNameFieldNumber, contents.data_name) +
+         detail::BytesFieldSize(ProtobufType::kSerialisedOldVersionNameFieldNumber,
+                                contents.old_version_name.Serialise().size()) +
+         detail::BytesFieldSize(ProtobufType::kSerialisedNewVersionNameFieldNumber,
+                                contents.new_version_name.Serialise().size());
+}
+
+void DirectCodec<nfs_vault::DataNameOldNewVersion>::AppendTo(const Contents& contents,
+                                                             std::string& buffer) {
+  typedef nfs_vault::protobuf::DataNameOldNewVersion ProtobufType;
+  detail::AppendNestedField(ProtobufType::kSerialisedDataNameFieldNumber,
+                            contents.data_name, buffer);
+  detail::AppendBytesField(ProtobufType::kSerialisedOldVersionNameFieldNumber,
+                           contents.old_version_name.Serialise(), buffer);
+  detail::AppendBytesField(ProtobufType::kSerialisedNewVersionNameFieldNumber,
+                           contents.new_version_name.Serialise(), buffer);
+}
+
+nfs_vault::DataNameOldNewVersion DirectCodec<nfs_vault::DataNameOldNewVersion>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_vault::protobuf::DataNameOldNewVersion ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_vault::DataNameOldNewVersion data_name_old_new_version;
+  data_name_old_new_version.data_name = DirectCodec<nfs_vault::DataName>::Parse(
+      fields.bytes(ProtobufType::kSerialisedDataNameFieldNumber));
+  data_name_old_new_version.old_version_name = StructuredDataVersions::VersionName(
+      fields.bytes(ProtobufType::kSerialisedOldVersionNameFieldNumber).to_string());
+  data_name_old_new_version.new_version_name = StructuredDataVersions::VersionName(
+      fields.bytes(ProtobufType::kSerialisedNewVersionNameFieldNumber).to_string());
+  return data_name_old_new_version;
+}
+
+// ==================== DataNameAndContent =========================================================
+std::size_t DirectCodec<nfs_vault::DataNameAndContent>::Size(const Contents& contents) {
+  typedef nfs_vault::protobuf::DataNameAndContent ProtobufType;
+  return detail::NestedFieldSize(ProtobufType::kSerialisedNameFieldNumber, contents.name) +
+         detail::BytesFieldSize(ProtobufType::kContentFieldNumber, contents.content.size());
+}
+
+void DirectCodec<nfs_vault::DataNameAndContent>::AppendTo(const Contents& contents,
+                                                          std::string& buffer) {
+  typedef nfs_vault::protobuf::DataNameAndContent ProtobufType;
+  detail::AppendNestedField(ProtobufType::kSerialisedNameFieldNumber, contents.name, buffer);
+  detail::AppendBytesField(ProtobufType::kContentFieldNumber, contents.content.string(), buffer);
+}
+
+nfs_vault::DataNameAndContent DirectCodec<nfs_vault::DataNameAndContent>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_vault::protobuf::DataNameAndContent ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_vault::DataNameAndContent data_name_and_content;
+  data_name_and_content.name = DirectCodec<nfs_vault::DataName>::Parse(
+      fields.bytes(ProtobufType::kSerialisedNameFieldNumber));
+  data_name_and_content.content =
+      SharedBuffer(NonEmptyString(fields.bytes(ProtobufType::kContentFieldNumber).to_string()));
+  return data_name_and_content;
+}
+
+// ==================== DataNameAndCost ============================================================
+std::size_t DirectCodec<nfs_vault::DataNameAndCost>::Size(const Contents& contents) {
+  typedef nfs_vault::protobuf::DataNameAndCost ProtobufType;
+  return detail::NestedFieldSize(ProtobufType::kSerialisedNameFieldNumber, contents.name) +
+         detail::VarintFieldSize(ProtobufType::kCostFieldNumber, Int32Varint(contents.cost));
+}
+
+void DirectCodec<nfs_vault::DataNameAndCost>::AppendTo(const Contents& contents,
+                                                       std::string& buffer) {
+  typedef nfs_vault::protobuf::DataNameAndCost ProtobufType;
+  detail::AppendNestedField(ProtobufType::kSerialisedNameFieldNumber, contents.name, buffer);
+  detail::AppendVarintField(ProtobufType::kCostFieldNumber, Int32Varint(contents.cost), buffer);
+}
+
+nfs_vault::DataNameAndCost DirectCodec<nfs_vault::DataNameAndCost>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_vault::protobuf::DataNameAndCost ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_vault::DataNameAndCost data_name_and_cost;
+  data_name_and_cost.name = DirectCodec<nfs_vault::DataName>::Parse(
+      fields.bytes(ProtobufType::kSerialisedNameFieldNumber));
+  data_name_and_cost.cost = static_cast<int32_t>(fields.varint(ProtobufType::kCostFieldNumber));
+  return data_name_and_cost;
+}
+
+// ==================== DataAndPmidHint ============================================================
+std::size_t DirectCodec<nfs_vault::DataAndPmidHint>::Size(const Contents& contents) {
+  typedef nfs_vault::protobuf::DataAndPmidHint ProtobufType;
+  return detail::NestedFieldSize(ProtobufType::kSerialisedDataNameAndContentFieldNumber,
+                                 contents.data) +
+         detail::BytesFieldSize(ProtobufType::kPmidHintFieldNumber,
+                                contents.pmid_hint.string().size());
+}
+
+void DirectCodec<nfs_vault::DataAndPmidHint>::AppendTo(const Contents& contents,
+                                                       std::string& buffer) {
+  typedef nfs_vault::protobuf::DataAndPmidHint ProtobufType;
+  detail::AppendNestedField(ProtobufType::kSerialisedDataNameAndContentFieldNumber,
+                            contents.data, buffer);
+  detail::AppendBytesField(ProtobufType::kPmidHintFieldNumber, contents.pmid_hint.string(),
+                           buffer);
+}
+
+nfs_vault::DataAndPmidHint DirectCodec<nfs_vault::DataAndPmidHint>::Parse(
+    const boost::string_ref& serialised_contents) {
+  typedef nfs_vault::protobuf::DataAndPmidHint ProtobufType;
+  detail::MessageFields fields(serialised_contents);
+  nfs_vault::DataAndPmidHint data_and_pmid_hint;
+  data_and_pmid_hint.data = DirectCodec<nfs_vault::DataNameAndContent>::Parse(
+      fields.bytes(ProtobufType::kSerialisedDataNameAndContentFieldNumber));
+  data_and_pmid_hint.pmid_hint =
+      Identity(fields.bytes(ProtobufType::kPmidHintFieldNumber).to_string());
+  return data_and_pmid_hint;
+}
+
+// ==================== Empty ======================================================================
+std::size_t DirectCodec<nfs_vault::Empty>::Size(const Contents& /*contents*/) {
+  return 0;
+}
+
+void DirectCodec<nfs_vault::Empty>::AppendTo(const Contents& /*contents*/,
+                                             std::string& /*buffer*/) {}
+
+nfs_vault::Empty DirectCodec<nfs_vault::Empty>::Parse(
+    const boost::string_ref& /*serialised_contents*/) {
+  return nfs_vault::Empty();
+}
+
+}  // namespace nfs
+
 }  // namespace maidsafe
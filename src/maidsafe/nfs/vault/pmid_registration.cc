@@ -21,6 +21,7 @@
 #include "maidsafe/common/rsa.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/nfs/protobuf_message.h"
 #include "maidsafe/nfs/vault/pmid_registration.pb.h"
 
 
@@ -33,19 +34,19 @@ namespace {
 asymm::PlainText GetSerialisedDetails(const passport::PublicMaid::Name& maid_name,
                                       const passport::PublicPmid::Name& pmid_name,
                                       bool unregister) {
-  protobuf::PmidRegistration::SignedDetails::Details details;
-  details.set_maid_name(maid_name->string());
-  details.set_pmid_name(pmid_name->string());
-  details.set_unregister(unregister);
-  return asymm::PlainText(details.SerializeAsString());
+  nfs::detail::ProtobufMessage<protobuf::PmidRegistration::SignedDetails::Details> details;
+  details->set_maid_name(maid_name->string());
+  details->set_pmid_name(pmid_name->string());
+  details->set_unregister(unregister);
+  return asymm::PlainText(details->SerializeAsString());
 }
 
 asymm::PlainText GetSerialisedSignedDetails(const asymm::PlainText& serialised_details,
                                             const asymm::Signature& pmid_signature) {
-  protobuf::PmidRegistration::SignedDetails signed_details;
-  signed_details.set_serialised_details(serialised_details.string());
-  signed_details.set_pmid_signature(pmid_signature.string());
-  return asymm::PlainText(signed_details.SerializeAsString());
+  nfs::detail::ProtobufMessage<protobuf::PmidRegistration::SignedDetails> signed_details;
+  signed_details->set_serialised_details(serialised_details.string());
+  signed_details->set_pmid_signature(pmid_signature.string());
+  return asymm::PlainText(signed_details->SerializeAsString());
 }
 
 }  //  unnamed namespace
@@ -82,21 +83,21 @@ PmidRegistration::PmidRegistration(const std::string& serialised_copy)
     LOG(kError) << "Failed to parse pmid_registration.";
     ThrowError(CommonErrors::parsing_error);
   });
-  protobuf::PmidRegistration proto_pmid_registration;
-  if (!proto_pmid_registration.ParseFromString(serialised_copy))
+  nfs::detail::ProtobufMessage<protobuf::PmidRegistration> proto_pmid_registration;
+  if (!proto_pmid_registration->ParseFromString(serialised_copy))
     fail();
-  protobuf::PmidRegistration::SignedDetails signed_details;
-  if (!signed_details.ParseFromString(proto_pmid_registration.serialised_signed_details()))
+  nfs::detail::ProtobufMessage<protobuf::PmidRegistration::SignedDetails> signed_details;
+  if (!signed_details->ParseFromString(proto_pmid_registration->serialised_signed_details()))
     fail();
-  protobuf::PmidRegistration::SignedDetails::Details details;
-  if (!details.ParseFromString(signed_details.serialised_details()))
+  nfs::detail::ProtobufMessage<protobuf::PmidRegistration::SignedDetails::Details> details;
+  if (!details->ParseFromString(signed_details->serialised_details()))
     fail();
 
-  maid_name_ = passport::PublicMaid::Name(Identity(details.maid_name()));
-  pmid_name_ = passport::PublicPmid::Name(Identity(details.pmid_name()));
-  unregister_ = details.unregister();
-  maid_signature_ = asymm::Signature(proto_pmid_registration.maid_signature());
-  pmid_signature_ = asymm::Signature(signed_details.pmid_signature());
+  maid_name_ = passport::PublicMaid::Name(Identity(details->maid_name()));
+  pmid_name_ = passport::PublicPmid::Name(Identity(details->pmid_name()));
+  unregister_ = details->unregister();
+  maid_signature_ = asymm::Signature(proto_pmid_registration->maid_signature());
+  pmid_signature_ = asymm::Signature(signed_details->pmid_signature());
 }
 
 PmidRegistration::PmidRegistration(const PmidRegistration& other)
@@ -135,12 +136,12 @@ bool PmidRegistration::Validate(const passport::PublicMaid& public_maid,
 }
 
 std::string PmidRegistration::Serialise() const {
-  protobuf::PmidRegistration proto_pmid_registration;
-  proto_pmid_registration.set_serialised_signed_details(
+  nfs::detail::ProtobufMessage<protobuf::PmidRegistration> proto_pmid_registration;
+  proto_pmid_registration->set_serialised_signed_details(
       GetSerialisedSignedDetails(GetSerialisedDetails(maid_name_, pmid_name_, unregister_),
                                  pmid_signature_).string());
-  proto_pmid_registration.set_maid_signature(maid_signature_.string());
-  return proto_pmid_registration.SerializeAsString();
+  proto_pmid_registration->set_maid_signature(maid_signature_.string());
+  return proto_pmid_registration->SerializeAsString();
 }
 
 bool operator==(const PmidRegistration& lhs, const PmidRegistration& rhs) {
@@ -162,4 +163,81 @@ void swap(PmidRegistration& lhs, PmidRegistration& rhs) MAIDSAFE_NOEXCEPT {
 
 }  // namespace nfs_vault
 
+
+
+namespace nfs {
+
+namespace {
+
+typedef nfs_vault::protobuf::PmidRegistration ProtobufType;
+typedef ProtobufType::SignedDetails SignedDetailsType;
+typedef SignedDetailsType::Details DetailsType;
+
+std::size_t DetailsSize(const nfs_vault::PmidRegistration& contents) {
+  return detail::BytesFieldSize(DetailsType::kMaidNameFieldNumber,
+                                contents.maid_name()->string().size()) +
+         detail::BytesFieldSize(DetailsType::kPmidNameFieldNumber,
+                                contents.pmid_name()->string().size()) +
+         detail::VarintFieldSize(DetailsType::kUnregisterFieldNumber, contents.unregister());
+}
+
+std::size_t SignedDetailsSize(std::size_t details_size, const asymm::Signature& pmid_signature) {
+  return detail::BytesFieldSize(SignedDetailsType::kSerialisedDetailsFieldNumber, details_size) +
+         detail::BytesFieldSize(SignedDetailsType::kPmidSignatureFieldNumber,
+                                pmid_signature.string().size());
+}
+
+}  // unnamed namespace
+
+// The signed details are nested two deep, so their sizes are needed for the length prefixes before
+// any of their bytes are appended.
+std::size_t DirectCodec<nfs_vault::PmidRegistration>::Size(const Contents& contents) {
+  return detail::BytesFieldSize(ProtobufType::kSerialisedSignedDetailsFieldNumber,
+                                SignedDetailsSize(DetailsSize(contents),
+                                                  contents.pmid_signature_)) +
+         detail::BytesFieldSize(ProtobufType::kMaidSignatureFieldNumber,
+                                contents.maid_signature_.string().size());
+}
+
+void DirectCodec<nfs_vault::PmidRegistration>::AppendTo(const Contents& contents,
+                                                        std::string& buffer) {
+  const std::size_t details_size(DetailsSize(contents));
+  detail::AppendBytesFieldHeader(ProtobufType::kSerialisedSignedDetailsFieldNumber,
+                                 SignedDetailsSize(details_size, contents.pmid_signature_), buffer);
+  detail::AppendBytesFieldHeader(SignedDetailsType::kSerialisedDetailsFieldNumber, details_size,
+                                 buffer);
+  detail::AppendBytesField(DetailsType::kMaidNameFieldNumber, contents.maid_name_->string(),
+                           buffer);
+  detail::AppendBytesField(DetailsType::kPmidNameFieldNumber, contents.pmid_name_->string(),
+                           buffer);
+  detail::AppendVarintField(DetailsType::kUnregisterFieldNumber, contents.unregister_, buffer);
+  detail::AppendBytesField(SignedDetailsType::kPmidSignatureFieldNumber,
+                           contents.pmid_signature_.string(), buffer);
+  detail::AppendBytesField(ProtobufType::kMaidSignatureFieldNumber,
+                           contents.maid_signature_.string(), buffer);
+}
+
+nfs_vault::PmidRegistration DirectCodec<nfs_vault::PmidRegistration>::Parse(
+    const boost::string_ref& serialised_contents) {
+  detail::MessageFields fields(serialised_contents);
+  detail::MessageFields signed_details(
+      fields.bytes(ProtobufType::kSerialisedSignedDetailsFieldNumber));
+  detail::MessageFields details(
+      signed_details.bytes(SignedDetailsType::kSerialisedDetailsFieldNumber));
+
+  nfs_vault::PmidRegistration pmid_registration;
+  pmid_registration.maid_name_ = passport::PublicMaid::Name(
+      Identity(details.bytes(DetailsType::kMaidNameFieldNumber).to_string()));
+  pmid_registration.pmid_name_ = passport::PublicPmid::Name(
+      Identity(details.bytes(DetailsType::kPmidNameFieldNumber).to_string()));
+  pmid_registration.unregister_ = details.varint(DetailsType::kUnregisterFieldNumber) != 0;
+  pmid_registration.maid_signature_ =
+      asymm::Signature(fields.bytes(ProtobufType::kMaidSignatureFieldNumber).to_string());
+  pmid_registration.pmid_signature_ = asymm::Signature(
+      signed_details.bytes(SignedDetailsType::kPmidSignatureFieldNumber).to_string());
+  return pmid_registration;
+}
+
+}  // namespace nfs
+
 }  // namespace maidsafe